@@ -61,16 +61,32 @@ inline int32_t to_big_endian(int32_t i32) {
 #endif
 }
 
-void aiger_encode(std::ostream &f, int x)
+void aiger_encode(std::string &buffer, int x)
 {
 	log_assert(x >= 0);
 
 	while (x & ~0x7f) {
-		f.put((x & 0x7f) | 0x80);
+		buffer.push_back((x & 0x7f) | 0x80);
 		x = x >> 7;
 	}
 
-	f.put(x);
+	buffer.push_back(x);
+}
+
+void aiger_append_int(std::string &buffer, int x, char sep)
+{
+	char digits[16];
+	int n = 0;
+	unsigned int u = x < 0 ? -(unsigned int)x : x;
+	do {
+		digits[n++] = '0' + u % 10;
+		u /= 10;
+	} while (u != 0);
+	if (x < 0)
+		buffer.push_back('-');
+	while (n > 0)
+		buffer.push_back(digits[--n]);
+	buffer.push_back(sep);
 }
 
 struct XAigerWriter
@@ -554,39 +570,48 @@ struct XAigerWriter
 		f << stringf("%s %d %d %d %d %d", ascii_mode ? "aag" : "aig", aig_m, aig_i, aig_l, aig_o, aig_a);
 		f << stringf("\n");
 
+		// Render the header-less body into one buffer and hand it to the
+		// stream in a single write, rather than going through the stream
+		// (and stringf) once per literal.
+		std::string buffer;
+		buffer.reserve(8*(aig_i + aig_obcjf) + (ascii_mode ? 24 : 8)*aig_a);
+
 		if (ascii_mode)
 		{
 			for (int i = 0; i < aig_i; i++)
-				f << stringf("%d\n", 2*i+2);
+				aiger_append_int(buffer, 2*i+2, '\n');
 
 			for (int i = 0; i < aig_obc; i++)
-				f << stringf("%d\n", aig_outputs.at(i));
+				aiger_append_int(buffer, aig_outputs.at(i), '\n');
 
 			for (int i = aig_obc; i < aig_obcj; i++)
-				f << stringf("1\n");
+				buffer += "1\n";
 
 			for (int i = aig_obc; i < aig_obcj; i++)
-				f << stringf("%d\n", aig_outputs.at(i));
+				aiger_append_int(buffer, aig_outputs.at(i), '\n');
 
 			for (int i = aig_obcj; i < aig_obcjf; i++)
-				f << stringf("%d\n", aig_outputs.at(i));
+				aiger_append_int(buffer, aig_outputs.at(i), '\n');
 
-			for (int i = 0; i < aig_a; i++)
-				f << stringf("%d %d %d\n", 2*(aig_i+aig_l+i)+2, aig_gates.at(i).first, aig_gates.at(i).second);
+			for (int i = 0; i < aig_a; i++) {
+				aiger_append_int(buffer, 2*(aig_i+aig_l+i)+2, ' ');
+				aiger_append_int(buffer, aig_gates.at(i).first, ' ');
+				aiger_append_int(buffer, aig_gates.at(i).second, '\n');
+			}
 		}
 		else
 		{
 			for (int i = 0; i < aig_obc; i++)
-				f << stringf("%d\n", aig_outputs.at(i));
+				aiger_append_int(buffer, aig_outputs.at(i), '\n');
 
 			for (int i = aig_obc; i < aig_obcj; i++)
-				f << stringf("1\n");
+				buffer += "1\n";
 
 			for (int i = aig_obc; i < aig_obcj; i++)
-				f << stringf("%d\n", aig_outputs.at(i));
+				aiger_append_int(buffer, aig_outputs.at(i), '\n');
 
 			for (int i = aig_obcj; i < aig_obcjf; i++)
-				f << stringf("%d\n", aig_outputs.at(i));
+				aiger_append_int(buffer, aig_outputs.at(i), '\n');
 
 			for (int i = 0; i < aig_a; i++) {
 				int lhs = 2*(aig_i+aig_l+i)+2;
@@ -594,11 +619,13 @@ struct XAigerWriter
 				int rhs1 = aig_gates.at(i).second;
 				int delta0 = lhs - rhs0;
 				int delta1 = rhs0 - rhs1;
-				aiger_encode(f, delta0);
-				aiger_encode(f, delta1);
+				aiger_encode(buffer, delta0);
+				aiger_encode(buffer, delta1);
 			}
 		}
 
+		f.write(buffer.data(), buffer.size());
+
 		f << "c";
 
 		if (!box_list.empty()) {
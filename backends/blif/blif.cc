@@ -26,6 +26,7 @@
 #include "kernel/sigtools.h"
 #include "kernel/celltypes.h"
 #include "kernel/log.h"
+#include "kernel/utils.h"
 #include <string>
 
 USING_YOSYS_NAMESPACE
@@ -56,7 +57,7 @@ struct BlifDumperConfig
 
 struct BlifDumper
 {
-	std::ostream &f;
+	TextBuffer f;
 	RTLIL::Module *module;
 	RTLIL::Design *design;
 	BlifDumperConfig *config;
@@ -65,8 +66,8 @@ struct BlifDumper
 	SigMap sigmap;
 	dict<SigBit, int> init_bits;
 
-	BlifDumper(std::ostream &f, RTLIL::Module *module, RTLIL::Design *design, BlifDumperConfig *config) :
-			f(f), module(module), design(design), config(config), ct(design), sigmap(module)
+	BlifDumper(RTLIL::Module *module, RTLIL::Design *design, BlifDumperConfig *config) :
+			module(module), design(design), config(config), ct(design), sigmap(module)
 	{
 		for (Wire *wire : module->wires())
 			if (wire->attributes.count("\\init")) {
@@ -86,52 +87,114 @@ struct BlifDumper
 			}
 	}
 
-	vector<shared_str> cstr_buf;
 	pool<SigBit> cstr_bits_seen;
+	dict<RTLIL::IdString, std::string> cstr_names;
 
-	const char *cstr(RTLIL::IdString id)
+	// the strings returned by cstr() stay valid for the next few calls,
+	// which is enough for the arguments of one stringf()
+	std::string cstr_buf[8];
+	int cstr_buf_idx = 0;
+
+	const std::string &id_name(RTLIL::IdString id)
 	{
+		auto it = cstr_names.find(id);
+		if (it != cstr_names.end())
+			return it->second;
+
 		std::string str = RTLIL::unescape_id(id);
 		for (size_t i = 0; i < str.size(); i++)
 			if (str[i] == '#' || str[i] == '=' || str[i] == '<' || str[i] == '>')
 				str[i] = '?';
-		cstr_buf.push_back(str);
-		return cstr_buf.back().c_str();
+		return cstr_names[id] = str;
 	}
 
-	const char *cstr(RTLIL::SigBit sig)
+	const char *const_name(RTLIL::State state)
+	{
+		if (state == RTLIL::State::S0) return config->false_type == "-" || config->false_type == "+" ? config->false_out.c_str() : "$false";
+		if (state == RTLIL::State::S1) return config->true_type == "-" || config->true_type == "+" ? config->true_out.c_str() : "$true";
+		return config->undef_type == "-" || config->undef_type == "+" ? config->undef_out.c_str() : "$undef";
+	}
+
+	int bit_index(RTLIL::SigBit sig)
+	{
+		return sig.wire->upto ? sig.wire->start_offset+sig.wire->width-sig.offset-1 : sig.wire->start_offset+sig.offset;
+	}
+
+	void put(RTLIL::SigBit sig)
 	{
 		cstr_bits_seen.insert(sig);
 
 		if (sig.wire == NULL) {
-			if (sig == RTLIL::State::S0) return config->false_type == "-" || config->false_type == "+" ? config->false_out.c_str() : "$false";
-			if (sig == RTLIL::State::S1) return config->true_type == "-" || config->true_type == "+" ? config->true_out.c_str() : "$true";
-			return config->undef_type == "-" || config->undef_type == "+" ? config->undef_out.c_str() : "$undef";
+			f << const_name(sig.data);
+			return;
 		}
 
-		std::string str = RTLIL::unescape_id(sig.wire->name);
-		for (size_t i = 0; i < str.size(); i++)
-			if (str[i] == '#' || str[i] == '=' || str[i] == '<' || str[i] == '>')
-				str[i] = '?';
-
+		f << id_name(sig.wire->name);
 		if (sig.wire->width != 1)
-			str += stringf("[%d]", sig.wire->upto ? sig.wire->start_offset+sig.wire->width-sig.offset-1 : sig.wire->start_offset+sig.offset);
+			f << '[' << bit_index(sig) << ']';
+	}
+
+	std::string &next_cstr_buf()
+	{
+		std::string &str = cstr_buf[cstr_buf_idx];
+		cstr_buf_idx = (cstr_buf_idx + 1) % 8;
+		return str;
+	}
+
+	const char *cstr(RTLIL::IdString id)
+	{
+		std::string &str = next_cstr_buf();
+		str = id_name(id);
+		return str.c_str();
+	}
+
+	const char *cstr(RTLIL::SigBit sig)
+	{
+		cstr_bits_seen.insert(sig);
 
-		cstr_buf.push_back(str);
-		return cstr_buf.back().c_str();
+		if (sig.wire == NULL)
+			return const_name(sig.data);
+
+		std::string &str = next_cstr_buf();
+		str = id_name(sig.wire->name);
+		if (sig.wire->width != 1)
+			str += stringf("[%d]", bit_index(sig));
+		return str.c_str();
 	}
 
-	const char *cstr_init(RTLIL::SigBit sig)
+	void put_init(RTLIL::SigBit sig)
 	{
 		sigmap.apply(sig);
 
-		if (init_bits.count(sig) == 0)
-			return " 2";
+		auto it = init_bits.find(sig);
+		if (it == init_bits.end())
+			f << " 2";
+		else
+			f << ' ' << it->second;
+	}
 
-		string str = stringf(" %d", init_bits.at(sig));
+	void dump_names(std::initializer_list<RTLIL::SigBit> sigs, const char *table)
+	{
+		f << ".names";
+		for (auto &sig : sigs) {
+			f << ' ';
+			put(sig);
+		}
+		f << '\n' << table;
+	}
 
-		cstr_buf.push_back(str);
-		return cstr_buf.back().c_str();
+	void dump_latch(RTLIL::SigBit d, RTLIL::SigBit q, const char *type = nullptr, RTLIL::SigBit ctrl = RTLIL::SigBit())
+	{
+		f << ".latch ";
+		put(d);
+		f << ' ';
+		put(q);
+		if (type != nullptr) {
+			f << ' ' << type << ' ';
+			put(ctrl);
+		}
+		put_init(q);
+		f << '\n';
 	}
 
 	const char *subckt_or_gate(std::string cell_type)
@@ -180,21 +243,25 @@ struct BlifDumper
 				outputs[wire->port_id] = wire;
 		}
 
-		f << stringf(".inputs");
+		f << ".inputs";
 		for (auto &it : inputs) {
 			RTLIL::Wire *wire = it.second;
-			for (int i = 0; i < wire->width; i++)
-				f << stringf(" %s", cstr(RTLIL::SigSpec(wire, i)));
+			for (int i = 0; i < wire->width; i++) {
+				f << ' ';
+				put(RTLIL::SigBit(wire, i));
+			}
 		}
-		f << stringf("\n");
+		f << '\n';
 
-		f << stringf(".outputs");
+		f << ".outputs";
 		for (auto &it : outputs) {
 			RTLIL::Wire *wire = it.second;
-			for (int i = 0; i < wire->width; i++)
-				f << stringf(" %s", cstr(RTLIL::SigSpec(wire, i)));
+			for (int i = 0; i < wire->width; i++) {
+				f << ' ';
+				put(RTLIL::SigBit(wire, i));
+			}
 		}
-		f << stringf("\n");
+		f << '\n';
 
 		if (module->get_blackbox_attribute()) {
 			f << stringf(".blackbox\n");
@@ -235,132 +302,107 @@ struct BlifDumper
 
 			if (config->unbuf_types.count(cell->type)) {
 				auto portnames = config->unbuf_types.at(cell->type);
-				f << stringf(".names %s %s\n1 1\n",
-						cstr(cell->getPort(portnames.first)), cstr(cell->getPort(portnames.second)));
+				dump_names({cell->getPort(portnames.first), cell->getPort(portnames.second)}, "1 1\n");
 				continue;
 			}
 
 			if (!config->icells_mode && cell->type == "$_NOT_") {
-				f << stringf(".names %s %s\n0 1\n",
-						cstr(cell->getPort("\\A")), cstr(cell->getPort("\\Y")));
+				dump_names({cell->getPort("\\A"), cell->getPort("\\Y")}, "0 1\n");
 				goto internal_cell;
 			}
 
 			if (!config->icells_mode && cell->type == "$_AND_") {
-				f << stringf(".names %s %s %s\n11 1\n",
-						cstr(cell->getPort("\\A")), cstr(cell->getPort("\\B")), cstr(cell->getPort("\\Y")));
+				dump_names({cell->getPort("\\A"), cell->getPort("\\B"), cell->getPort("\\Y")}, "11 1\n");
 				goto internal_cell;
 			}
 
 			if (!config->icells_mode && cell->type == "$_OR_") {
-				f << stringf(".names %s %s %s\n1- 1\n-1 1\n",
-						cstr(cell->getPort("\\A")), cstr(cell->getPort("\\B")), cstr(cell->getPort("\\Y")));
+				dump_names({cell->getPort("\\A"), cell->getPort("\\B"), cell->getPort("\\Y")}, "1- 1\n-1 1\n");
 				goto internal_cell;
 			}
 
 			if (!config->icells_mode && cell->type == "$_XOR_") {
-				f << stringf(".names %s %s %s\n10 1\n01 1\n",
-						cstr(cell->getPort("\\A")), cstr(cell->getPort("\\B")), cstr(cell->getPort("\\Y")));
+				dump_names({cell->getPort("\\A"), cell->getPort("\\B"), cell->getPort("\\Y")}, "10 1\n01 1\n");
 				goto internal_cell;
 			}
 
 			if (!config->icells_mode && cell->type == "$_NAND_") {
-				f << stringf(".names %s %s %s\n0- 1\n-0 1\n",
-						cstr(cell->getPort("\\A")), cstr(cell->getPort("\\B")), cstr(cell->getPort("\\Y")));
+				dump_names({cell->getPort("\\A"), cell->getPort("\\B"), cell->getPort("\\Y")}, "0- 1\n-0 1\n");
 				goto internal_cell;
 			}
 
 			if (!config->icells_mode && cell->type == "$_NOR_") {
-				f << stringf(".names %s %s %s\n00 1\n",
-						cstr(cell->getPort("\\A")), cstr(cell->getPort("\\B")), cstr(cell->getPort("\\Y")));
+				dump_names({cell->getPort("\\A"), cell->getPort("\\B"), cell->getPort("\\Y")}, "00 1\n");
 				goto internal_cell;
 			}
 
 			if (!config->icells_mode && cell->type == "$_XNOR_") {
-				f << stringf(".names %s %s %s\n11 1\n00 1\n",
-						cstr(cell->getPort("\\A")), cstr(cell->getPort("\\B")), cstr(cell->getPort("\\Y")));
+				dump_names({cell->getPort("\\A"), cell->getPort("\\B"), cell->getPort("\\Y")}, "11 1\n00 1\n");
 				goto internal_cell;
 			}
 
 			if (!config->icells_mode && cell->type == "$_ANDNOT_") {
-				f << stringf(".names %s %s %s\n10 1\n",
-						cstr(cell->getPort("\\A")), cstr(cell->getPort("\\B")), cstr(cell->getPort("\\Y")));
+				dump_names({cell->getPort("\\A"), cell->getPort("\\B"), cell->getPort("\\Y")}, "10 1\n");
 				goto internal_cell;
 			}
 
 			if (!config->icells_mode && cell->type == "$_ORNOT_") {
-				f << stringf(".names %s %s %s\n1- 1\n-0 1\n",
-						cstr(cell->getPort("\\A")), cstr(cell->getPort("\\B")), cstr(cell->getPort("\\Y")));
+				dump_names({cell->getPort("\\A"), cell->getPort("\\B"), cell->getPort("\\Y")}, "1- 1\n-0 1\n");
 				goto internal_cell;
 			}
 
 			if (!config->icells_mode && cell->type == "$_AOI3_") {
-				f << stringf(".names %s %s %s %s\n-00 1\n0-0 1\n",
-						cstr(cell->getPort("\\A")), cstr(cell->getPort("\\B")), cstr(cell->getPort("\\C")), cstr(cell->getPort("\\Y")));
+				dump_names({cell->getPort("\\A"), cell->getPort("\\B"), cell->getPort("\\C"), cell->getPort("\\Y")}, "-00 1\n0-0 1\n");
 				goto internal_cell;
 			}
 
 			if (!config->icells_mode && cell->type == "$_OAI3_") {
-				f << stringf(".names %s %s %s %s\n00- 1\n--0 1\n",
-						cstr(cell->getPort("\\A")), cstr(cell->getPort("\\B")), cstr(cell->getPort("\\C")), cstr(cell->getPort("\\Y")));
+				dump_names({cell->getPort("\\A"), cell->getPort("\\B"), cell->getPort("\\C"), cell->getPort("\\Y")}, "00- 1\n--0 1\n");
 				goto internal_cell;
 			}
 
 			if (!config->icells_mode && cell->type == "$_AOI4_") {
-				f << stringf(".names %s %s %s %s %s\n-0-0 1\n-00- 1\n0--0 1\n0-0- 1\n",
-						cstr(cell->getPort("\\A")), cstr(cell->getPort("\\B")),
-						cstr(cell->getPort("\\C")), cstr(cell->getPort("\\D")), cstr(cell->getPort("\\Y")));
+				dump_names({cell->getPort("\\A"), cell->getPort("\\B"), cell->getPort("\\C"), cell->getPort("\\D"), cell->getPort("\\Y")}, "-0-0 1\n-00- 1\n0--0 1\n0-0- 1\n");
 				goto internal_cell;
 			}
 
 			if (!config->icells_mode && cell->type == "$_OAI4_") {
-				f << stringf(".names %s %s %s %s %s\n00-- 1\n--00 1\n",
-						cstr(cell->getPort("\\A")), cstr(cell->getPort("\\B")),
-						cstr(cell->getPort("\\C")), cstr(cell->getPort("\\D")), cstr(cell->getPort("\\Y")));
+				dump_names({cell->getPort("\\A"), cell->getPort("\\B"), cell->getPort("\\C"), cell->getPort("\\D"), cell->getPort("\\Y")}, "00-- 1\n--00 1\n");
 				goto internal_cell;
 			}
 
 			if (!config->icells_mode && cell->type == "$_MUX_") {
-				f << stringf(".names %s %s %s %s\n1-0 1\n-11 1\n",
-						cstr(cell->getPort("\\A")), cstr(cell->getPort("\\B")),
-						cstr(cell->getPort("\\S")), cstr(cell->getPort("\\Y")));
+				dump_names({cell->getPort("\\A"), cell->getPort("\\B"), cell->getPort("\\S"), cell->getPort("\\Y")}, "1-0 1\n-11 1\n");
 				goto internal_cell;
 			}
 
 			if (!config->icells_mode && cell->type == "$_NMUX_") {
-				f << stringf(".names %s %s %s %s\n0-0 1\n-01 1\n",
-						cstr(cell->getPort("\\A")), cstr(cell->getPort("\\B")),
-						cstr(cell->getPort("\\S")), cstr(cell->getPort("\\Y")));
+				dump_names({cell->getPort("\\A"), cell->getPort("\\B"), cell->getPort("\\S"), cell->getPort("\\Y")}, "0-0 1\n-01 1\n");
 				goto internal_cell;
 			}
 
 			if (!config->icells_mode && cell->type == "$_FF_") {
-				f << stringf(".latch %s %s%s\n", cstr(cell->getPort("\\D")), cstr(cell->getPort("\\Q")),
-						cstr_init(cell->getPort("\\Q")));
+				dump_latch(cell->getPort("\\D"), cell->getPort("\\Q"));
 				goto internal_cell;
 			}
 
 			if (!config->icells_mode && cell->type == "$_DFF_N_") {
-				f << stringf(".latch %s %s fe %s%s\n", cstr(cell->getPort("\\D")), cstr(cell->getPort("\\Q")),
-						cstr(cell->getPort("\\C")), cstr_init(cell->getPort("\\Q")));
+				dump_latch(cell->getPort("\\D"), cell->getPort("\\Q"), "fe", cell->getPort("\\C"));
 				goto internal_cell;
 			}
 
 			if (!config->icells_mode && cell->type == "$_DFF_P_") {
-				f << stringf(".latch %s %s re %s%s\n", cstr(cell->getPort("\\D")), cstr(cell->getPort("\\Q")),
-						cstr(cell->getPort("\\C")), cstr_init(cell->getPort("\\Q")));
+				dump_latch(cell->getPort("\\D"), cell->getPort("\\Q"), "re", cell->getPort("\\C"));
 				goto internal_cell;
 			}
 
 			if (!config->icells_mode && cell->type == "$_DLATCH_N_") {
-				f << stringf(".latch %s %s al %s%s\n", cstr(cell->getPort("\\D")), cstr(cell->getPort("\\Q")),
-						cstr(cell->getPort("\\E")), cstr_init(cell->getPort("\\Q")));
+				dump_latch(cell->getPort("\\D"), cell->getPort("\\Q"), "al", cell->getPort("\\E"));
 				goto internal_cell;
 			}
 
 			if (!config->icells_mode && cell->type == "$_DLATCH_P_") {
-				f << stringf(".latch %s %s ah %s%s\n", cstr(cell->getPort("\\D")), cstr(cell->getPort("\\Q")),
-						cstr(cell->getPort("\\E")), cstr_init(cell->getPort("\\Q")));
+				dump_latch(cell->getPort("\\D"), cell->getPort("\\Q"), "ah", cell->getPort("\\E"));
 				goto internal_cell;
 			}
 
@@ -369,12 +411,15 @@ struct BlifDumper
 				auto &inputs = cell->getPort("\\A");
 				auto width = cell->parameters.at("\\WIDTH").as_int();
 				log_assert(inputs.size() == width);
-				for (int i = width-1; i >= 0; i--)
-					f << stringf(" %s", cstr(inputs.extract(i, 1)));
+				for (int i = width-1; i >= 0; i--) {
+					f << ' ';
+					put(inputs[i]);
+				}
 				auto &output = cell->getPort("\\Y");
 				log_assert(output.size() == 1);
-				f << stringf(" %s", cstr(output));
-				f << stringf("\n");
+				f << ' ';
+				put(output);
+				f << '\n';
 				RTLIL::SigSpec mask = cell->parameters.at("\\LUT");
 				for (int i = 0; i < (1 << width); i++)
 					if (mask[i] == State::S1) {
@@ -395,12 +440,15 @@ struct BlifDumper
 				while (GetSize(table) < 2*width*depth)
 					table.push_back(State::S0);
 				log_assert(inputs.size() == width);
-				for (int i = 0; i < width; i++)
-					f << stringf(" %s", cstr(inputs.extract(i, 1)));
+				for (int i = 0; i < width; i++) {
+					f << ' ';
+					put(inputs[i]);
+				}
 				auto &output = cell->getPort("\\Y");
 				log_assert(output.size() == 1);
-				f << stringf(" %s", cstr(output));
-				f << stringf("\n");
+				f << ' ';
+				put(output);
+				f << '\n';
 				for (int i = 0; i < depth; i++) {
 					for (int j = 0; j < width; j++) {
 						bool pat0 = table.at(2*width*i + 2*j + 0) == State::S1;
@@ -414,11 +462,12 @@ struct BlifDumper
 				goto internal_cell;
 			}
 
-			f << stringf(".%s %s", subckt_or_gate(cell->type.str()), cstr(cell->type));
+			f << '.' << subckt_or_gate(cell->type.str()) << ' ' << id_name(cell->type);
 			for (auto &conn : cell->connections())
 			{
 				if (conn.second.size() == 1) {
-					f << stringf(" %s=%s", cstr(conn.first), cstr(conn.second[0]));
+					f << ' ' << id_name(conn.first) << '=';
+					put(conn.second[0]);
 					continue;
 				}
 
@@ -426,18 +475,18 @@ struct BlifDumper
 				Wire *w = m ? m->wire(conn.first) : nullptr;
 
 				if (w == nullptr) {
-					for (int i = 0; i < GetSize(conn.second); i++)
-						f << stringf(" %s[%d]=%s", cstr(conn.first), i, cstr(conn.second[i]));
+					for (int i = 0; i < GetSize(conn.second); i++) {
+						f << ' ' << id_name(conn.first) << '[' << i << "]=";
+						put(conn.second[i]);
+					}
 				} else {
 					for (int i = 0; i < std::min(GetSize(conn.second), GetSize(w)); i++) {
-						SigBit sig(w, i);
-						f << stringf(" %s[%d]=%s", cstr(conn.first), sig.wire->upto ?
-								sig.wire->start_offset+sig.wire->width-sig.offset-1 :
-								sig.wire->start_offset+sig.offset, cstr(conn.second[i]));
+						f << ' ' << id_name(conn.first) << '[' << bit_index(SigBit(w, i)) << "]=";
+						put(conn.second[i]);
 					}
 				}
 			}
-			f << stringf("\n");
+			f << '\n';
 
 			if (config->cname_mode)
 				f << stringf(".cname %s\n", cstr(cell->name));
@@ -470,7 +519,7 @@ struct BlifDumper
 				f << stringf(".%s %s %s=%s %s=%s\n", subckt_or_gate(config->buf_type), config->buf_type.c_str(),
 						config->buf_in.c_str(), cstr(rhs_bit), config->buf_out.c_str(), cstr(lhs_bit));
 			else
-				f << stringf(".names %s %s\n1 1\n", cstr(rhs_bit), cstr(lhs_bit));
+				dump_names({rhs_bit, lhs_bit}, "1 1\n");
 		}
 
 		f << stringf(".end\n");
@@ -478,8 +527,9 @@ struct BlifDumper
 
 	static void dump(std::ostream &f, RTLIL::Module *module, RTLIL::Design *design, BlifDumperConfig &config)
 	{
-		BlifDumper dumper(f, module, design, &config);
+		BlifDumper dumper(module, design, &config);
 		dumper.dump();
+		f.write(dumper.f.str.data(), dumper.f.str.size());
 	}
 };
 
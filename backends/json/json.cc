@@ -23,6 +23,7 @@
 #include "kernel/celltypes.h"
 #include "kernel/cellaigs.h"
 #include "kernel/log.h"
+#include "kernel/utils.h"
 #include <string>
 
 USING_YOSYS_NAMESPACE
@@ -30,7 +31,8 @@ PRIVATE_NAMESPACE_BEGIN
 
 struct JsonWriter
 {
-	std::ostream &f;
+	std::ostream &os;
+	TextBuffer f;
 	bool use_selection;
 	bool aig_mode;
 
@@ -39,11 +41,43 @@ struct JsonWriter
 
 	SigMap sigmap;
 	int sigidcounter;
-	dict<SigBit, string> sigids;
+	dict<SigBit, int> sigids;
 	pool<Aig> aig_models;
 
-	JsonWriter(std::ostream &f, bool use_selection, bool aig_mode) :
-			f(f), use_selection(use_selection), aig_mode(aig_mode) { }
+	JsonWriter(std::ostream &os, bool use_selection, bool aig_mode) :
+			os(os), use_selection(use_selection), aig_mode(aig_mode) { }
+
+	void flush()
+	{
+		os.write(f.str.data(), f.str.size());
+		f.str.clear();
+	}
+
+	void write_string(const string &str)
+	{
+		f << '"';
+		for (char c : str) {
+			if (c == '\\')
+				f << c;
+			f << c;
+		}
+		f << '"';
+	}
+
+	void write_name(IdString name)
+	{
+		// same as RTLIL::unescape_id(), without the string copy
+		const char *p = name.c_str();
+		if (p[0] == '\\' && p[1] != 0 && p[1] != '$' && p[1] != '\\' && !(p[1] >= '0' && p[1] <= '9'))
+			p++;
+		f << '"';
+		for (; *p; p++) {
+			if (*p == '\\')
+				f << *p;
+			f << *p;
+		}
+		f << '"';
+	}
 
 	string get_string(string str)
 	{
@@ -61,26 +95,29 @@ struct JsonWriter
 		return get_string(RTLIL::unescape_id(name));
 	}
 
-	string get_bits(SigSpec sig)
+	void write_bits(SigSpec sig)
 	{
 		bool first = true;
-		string str = "[";
+		f << '[';
 		for (auto bit : sigmap(sig)) {
-			str += first ? " " : ", ";
+			f << (first ? " " : ", ");
 			first = false;
-			if (sigids.count(bit) == 0) {
-				string &s = sigids[bit];
-				if (bit.wire == nullptr) {
-					if (bit == State::S0) s = "\"0\"";
-					else if (bit == State::S1) s = "\"1\"";
-					else if (bit == State::Sz) s = "\"z\"";
-					else s = "\"x\"";
-				} else
-					s = stringf("%d", sigidcounter++);
+			if (bit.wire == nullptr) {
+				if (bit == State::S0) f << "\"0\"";
+				else if (bit == State::S1) f << "\"1\"";
+				else if (bit == State::Sz) f << "\"z\"";
+				else f << "\"x\"";
+				continue;
 			}
-			str += sigids[bit];
+			auto it = sigids.find(bit);
+			if (it != sigids.end()) {
+				f << it->second;
+				continue;
+			}
+			sigids[bit] = sigidcounter;
+			f << sigidcounter++;
 		}
-		return str + " ]";
+		f << " ]";
 	}
 
 	void write_parameter_value(const Const &value)
@@ -101,7 +138,7 @@ struct JsonWriter
 			}
 			if (state < 2)
 				str += " ";
-			f << get_string(str);
+			write_string(str);
 		} else
 		if (GetSize(value) == 32 && value.is_fully_def()) {
 			if ((value.flags & RTLIL::ConstFlags::CONST_FLAG_SIGNED) != 0)
@@ -109,7 +146,7 @@ struct JsonWriter
 			else
 				f << stringf("%u", value.as_int());
 		} else {
-			f << get_string(value.as_string());
+			write_string(value.as_string());
 		}
 	}
 
@@ -153,8 +190,9 @@ struct JsonWriter
 				f << stringf("          \"offset\": %d,\n", w->start_offset);
 			if (w->upto)
 				f << stringf("          \"upto\": 1,\n");
-			f << stringf("          \"bits\": %s\n", get_bits(w).c_str());
-			f << stringf("        }");
+			f << "          \"bits\": ";
+			write_bits(w);
+			f << "\n        }";
 			first = false;
 		}
 		f << stringf("\n      },\n");
@@ -164,10 +202,14 @@ struct JsonWriter
 		for (auto c : module->cells()) {
 			if (use_selection && !module->selected(c))
 				continue;
-			f << stringf("%s\n", first ? "" : ",");
-			f << stringf("        %s: {\n", get_name(c->name).c_str());
-			f << stringf("          \"hide_name\": %s,\n", c->name[0] == '$' ? "1" : "0");
-			f << stringf("          \"type\": %s,\n", get_name(c->type).c_str());
+			f << (first ? "\n" : ",\n");
+			f << "        ";
+			write_name(c->name);
+			f << ": {\n";
+			f << "          \"hide_name\": " << (c->name[0] == '$' ? "1" : "0") << ",\n";
+			f << "          \"type\": ";
+			write_name(c->type);
+			f << ",\n";
 			if (aig_mode) {
 				Aig aig(c);
 				if (!aig.name.empty()) {
@@ -188,8 +230,10 @@ struct JsonWriter
 					string direction = "output";
 					if (c->input(conn.first))
 						direction = c->output(conn.first) ? "inout" : "input";
-					f << stringf("%s\n", first2 ? "" : ",");
-					f << stringf("            %s: \"%s\"", get_name(conn.first).c_str(), direction.c_str());
+					f << (first2 ? "\n" : ",\n");
+					f << "            ";
+					write_name(conn.first);
+					f << ": \"" << direction << '"';
 					first2 = false;
 				}
 				f << stringf("\n          },\n");
@@ -197,8 +241,11 @@ struct JsonWriter
 			f << stringf("          \"connections\": {");
 			bool first2 = true;
 			for (auto &conn : c->connections()) {
-				f << stringf("%s\n", first2 ? "" : ",");
-				f << stringf("            %s: %s", get_name(conn.first).c_str(), get_bits(conn.second).c_str());
+				f << (first2 ? "\n" : ",\n");
+				f << "            ";
+				write_name(conn.first);
+				f << ": ";
+				write_bits(conn.second);
 				first2 = false;
 			}
 			f << stringf("\n          }\n");
@@ -212,10 +259,14 @@ struct JsonWriter
 		for (auto w : module->wires()) {
 			if (use_selection && !module->selected(w))
 				continue;
-			f << stringf("%s\n", first ? "" : ",");
-			f << stringf("        %s: {\n", get_name(w->name).c_str());
-			f << stringf("          \"hide_name\": %s,\n", w->name[0] == '$' ? "1" : "0");
-			f << stringf("          \"bits\": %s,\n", get_bits(w).c_str());
+			f << (first ? "\n" : ",\n");
+			f << "        ";
+			write_name(w->name);
+			f << ": {\n";
+			f << "          \"hide_name\": " << (w->name[0] == '$' ? "1" : "0") << ",\n";
+			f << "          \"bits\": ";
+			write_bits(w);
+			f << ",\n";
 			if (w->start_offset)
 				f << stringf("          \"offset\": %d,\n", w->start_offset);
 			if (w->upto)
@@ -245,6 +296,7 @@ struct JsonWriter
 			if (!first_module)
 				f << stringf(",\n");
 			write_module(mod);
+			flush();
 			first_module = false;
 		}
 		f << stringf("\n  }");
@@ -278,6 +330,7 @@ struct JsonWriter
 			f << stringf("\n  }");
 		}
 		f << stringf("\n}\n");
+		flush();
 	}
 };
 
@@ -151,6 +151,7 @@ struct HierDirtyFlags
 struct SimplecWorker
 {
 	bool verbose = false;
+	bool bench = false;
 	int max_uintsize = 32;
 
 	Design *design;
@@ -173,6 +174,11 @@ struct SimplecWorker
 
 	dict<Cell*, int> topoidx;
 
+	dict<Module*, idict<SigBit>> clock_bits;
+	dict<Module*, vector<string>> clock_prev_names;
+	dict<Module*, pool<SigBit>> clock_ports;
+	int tick_locals = 0;
+
 	pool<string> activated_cells;
 	pool<string> reactivated_cells;
 
@@ -282,6 +288,765 @@ struct SimplecWorker
 		return stringf("  %s(&%s, %s);", util_name.c_str(), signame.c_str(), expr.c_str());
 	}
 
+	struct FfInfo
+	{
+		SigSpec clk, d, q, en, arst, set, clr;
+		bool clk_polarity = true, en_polarity = true, arst_polarity = true;
+		bool set_polarity = true, clr_polarity = true;
+		Const arst_value;
+	};
+
+	// Describe a storage cell ($dff and friends, latches, $sr and their
+	// gate-level counterparts) in terms of one generic flip-flop. Returns
+	// false for cells that hold no state.
+	bool ff_info(Module *mod, Cell *cell, FfInfo *ff)
+	{
+		string type = cell->type.str();
+		bool is_ff = false;
+
+		if (type.substr(0, 2) == "$_")
+		{
+			if (type == "$_FF_" || type == "$_DFF_N_" || type == "$_DFF_P_" || (GetSize(type) == 10 && type.substr(0, 6) == "$_DFFE") ||
+					(GetSize(type) == 10 && type.substr(0, 6) == "$_DFF_") || type.substr(0, 8) == "$_DFFSR_" ||
+					type.substr(0, 9) == "$_DLATCH_" || type.substr(0, 11) == "$_DLATCHSR_" || type.substr(0, 5) == "$_SR_")
+				is_ff = true;
+		}
+		else if (cell->type.in("$ff", "$dff", "$dffe", "$adff", "$dffsr", "$dlatch", "$dlatchsr", "$sr"))
+			is_ff = true;
+
+		if (!is_ff || ff == nullptr)
+			return is_ff;
+
+		SigMap &sigmap = sigmaps.at(mod);
+
+		if (type[1] == '_')
+		{
+			ff->q = sigmap(cell->getPort("\\Q"));
+			if (cell->hasPort("\\D"))
+				ff->d = sigmap(cell->getPort("\\D"));
+			if (cell->hasPort("\\C")) {
+				ff->clk = sigmap(cell->getPort("\\C"));
+				ff->clk_polarity = type[type.substr(0, 7) == "$_DFFE_" ? 7 : type.substr(0, 8) == "$_DFFSR_" ? 8 : 6] == 'P';
+			}
+			if (type.substr(0, 7) == "$_DFFE_") {
+				ff->en = sigmap(cell->getPort("\\E"));
+				ff->en_polarity = type[8] == 'P';
+			}
+			if (type.substr(0, 9) == "$_DLATCH_" || type.substr(0, 11) == "$_DLATCHSR_") {
+				ff->en = sigmap(cell->getPort("\\E"));
+				ff->en_polarity = type[type[8] == '_' ? 9 : 11] == 'P';
+			}
+			if (GetSize(type) == 10 && type.substr(0, 6) == "$_DFF_") {
+				ff->arst = sigmap(cell->getPort("\\R"));
+				ff->arst_polarity = type[7] == 'P';
+				ff->arst_value = type[8] == '1' ? State::S1 : State::S0;
+			}
+			if (cell->hasPort("\\S")) {
+				int pos = type.substr(0, 8) == "$_DFFSR_" ? 9 : type.substr(0, 11) == "$_DLATCHSR_" ? 12 : 5;
+				ff->set = sigmap(cell->getPort("\\S"));
+				ff->clr = sigmap(cell->getPort("\\R"));
+				ff->set_polarity = type[pos] == 'P';
+				ff->clr_polarity = type[pos+1] == 'P';
+			}
+			return true;
+		}
+
+		ff->q = sigmap(cell->getPort("\\Q"));
+		if (cell->hasPort("\\D"))
+			ff->d = sigmap(cell->getPort("\\D"));
+		if (cell->hasPort("\\CLK")) {
+			ff->clk = sigmap(cell->getPort("\\CLK"));
+			ff->clk_polarity = cell->getParam("\\CLK_POLARITY").as_bool();
+		}
+		if (cell->hasPort("\\EN")) {
+			ff->en = sigmap(cell->getPort("\\EN"));
+			ff->en_polarity = cell->getParam("\\EN_POLARITY").as_bool();
+		}
+		if (cell->hasPort("\\ARST")) {
+			ff->arst = sigmap(cell->getPort("\\ARST"));
+			ff->arst_polarity = cell->getParam("\\ARST_POLARITY").as_bool();
+			ff->arst_value = cell->getParam("\\ARST_VALUE");
+		}
+		if (cell->hasPort("\\SET")) {
+			ff->set = sigmap(cell->getPort("\\SET"));
+			ff->clr = sigmap(cell->getPort("\\CLR"));
+			ff->set_polarity = cell->getParam("\\SET_POLARITY").as_bool();
+			ff->clr_polarity = cell->getParam("\\CLR_POLARITY").as_bool();
+		}
+		return true;
+	}
+
+	void util_word_helpers()
+	{
+		string util_name = "yosys_simplec_word_helpers";
+
+		if (generated_utils.count(util_name))
+			return;
+
+		util_ifdef_guard(util_name);
+		util_declarations.push_back("static inline uint64_t yosys_simplec_mask(int width)");
+		util_declarations.push_back("{");
+		util_declarations.push_back("  return width >= 64 ? ~UINT64_C(0) : (UINT64_C(1) << width) - 1;");
+		util_declarations.push_back("}");
+		util_declarations.push_back("static inline uint64_t yosys_simplec_sext(uint64_t value, int width)");
+		util_declarations.push_back("{");
+		util_declarations.push_back("  if (width >= 64) return value;");
+		util_declarations.push_back("  value &= yosys_simplec_mask(width);");
+		util_declarations.push_back("  return (value >> (width-1)) & 1 ? value | ~yosys_simplec_mask(width) : value;");
+		util_declarations.push_back("}");
+		util_declarations.push_back("static inline uint64_t yosys_simplec_shl(uint64_t value, uint64_t amount)");
+		util_declarations.push_back("{");
+		util_declarations.push_back("  return amount >= 64 ? 0 : value << amount;");
+		util_declarations.push_back("}");
+		util_declarations.push_back("static inline uint64_t yosys_simplec_shr(uint64_t value, uint64_t amount)");
+		util_declarations.push_back("{");
+		util_declarations.push_back("  return amount >= 64 ? 0 : value >> amount;");
+		util_declarations.push_back("}");
+		util_declarations.push_back("static inline uint64_t yosys_simplec_sshr(uint64_t value, uint64_t amount)");
+		util_declarations.push_back("{");
+		util_declarations.push_back("  uint64_t fill = (int64_t)value < 0 ? ~UINT64_C(0) : 0;");
+		util_declarations.push_back("  return amount >= 64 ? fill : (value >> amount) | (amount ? fill << (64 - amount) : 0);");
+		util_declarations.push_back("}");
+		util_declarations.push_back("static inline uint64_t yosys_simplec_shift(uint64_t value, int64_t amount)");
+		util_declarations.push_back("{");
+		util_declarations.push_back("  return amount < 0 ? yosys_simplec_shl(value, UINT64_C(0) - (uint64_t)amount) : yosys_simplec_shr(value, amount);");
+		util_declarations.push_back("}");
+		util_declarations.push_back("static inline bool yosys_simplec_parity(uint64_t value)");
+		util_declarations.push_back("{");
+		util_declarations.push_back("  value ^= value >> 32; value ^= value >> 16; value ^= value >> 8;");
+		util_declarations.push_back("  value ^= value >> 4; value ^= value >> 2; value ^= value >> 1;");
+		util_declarations.push_back("  return value & 1;");
+		util_declarations.push_back("}");
+		util_declarations.push_back("static inline uint64_t yosys_simplec_div(uint64_t a, uint64_t b, bool is_signed)");
+		util_declarations.push_back("{");
+		util_declarations.push_back("  if (b == 0) return 0;");
+		util_declarations.push_back("  if (is_signed) return (int64_t)b == -1 ? UINT64_C(0) - a : (uint64_t)((int64_t)a / (int64_t)b);");
+		util_declarations.push_back("  return a / b;");
+		util_declarations.push_back("}");
+		util_declarations.push_back("static inline uint64_t yosys_simplec_mod(uint64_t a, uint64_t b, bool is_signed)");
+		util_declarations.push_back("{");
+		util_declarations.push_back("  if (b == 0) return 0;");
+		util_declarations.push_back("  if (is_signed) return (int64_t)b == -1 ? 0 : (uint64_t)((int64_t)a % (int64_t)b);");
+		util_declarations.push_back("  return a % b;");
+		util_declarations.push_back("}");
+		util_declarations.push_back("static inline uint64_t yosys_simplec_pow(uint64_t a, uint64_t b, bool b_signed)");
+		util_declarations.push_back("{");
+		util_declarations.push_back("  uint64_t result = 1;");
+		util_declarations.push_back("  if (b_signed && (int64_t)b < 0) return a == 1 ? 1 : a == ~UINT64_C(0) ? (b & 1 ? a : 1) : 0;");
+		util_declarations.push_back("  for (; b != 0; b >>= 1, a *= a) if (b & 1) result *= a;");
+		util_declarations.push_back("  return result;");
+		util_declarations.push_back("}");
+		util_declarations.push_back("static inline uint64_t yosys_simplec_lcu(uint64_t p, uint64_t g, bool ci, int width)");
+		util_declarations.push_back("{");
+		util_declarations.push_back("  uint64_t co = 0;");
+		util_declarations.push_back("  for (int i = 0; i < width; i++) {");
+		util_declarations.push_back("    ci = ((g >> i) & 1) || (((p >> i) & 1) && ci);");
+		util_declarations.push_back("    co |= (uint64_t)ci << i;");
+		util_declarations.push_back("  }");
+		util_declarations.push_back("  return co;");
+		util_declarations.push_back("}");
+		util_declarations.push_back("#endif");
+		generated_utils.insert(util_name);
+	}
+
+	string util_word_field(const string &signame, int n, int word_idx)
+	{
+		return stringf("%s.value_%d_%d", signame.c_str(), std::min(n-1, (word_idx+1)*max_uintsize-1), word_idx*max_uintsize);
+	}
+
+	string util_const(uint64_t value)
+	{
+		return stringf("UINT64_C(0x%llx)", (unsigned long long)value);
+	}
+
+	string util_mask(int width)
+	{
+		return width >= 64 ? "~UINT64_C(0)" : util_const((uint64_t(1) << width) - 1);
+	}
+
+	// C expression of type uint64_t holding the (sigmapped) signal sig. The
+	// value is assembled directly from the packed words of the wires, so a
+	// full-word access costs a single load.
+	string util_get_word(const string &prefix, const SigSpec &sig)
+	{
+		log_assert(GetSize(sig) <= 64);
+
+		vector<string> terms;
+		uint64_t const_bits = 0;
+		int pos = 0;
+
+		for (auto &chunk : sig.chunks())
+		{
+			if (chunk.wire == nullptr) {
+				for (int i = 0; i < chunk.width; i++)
+					if (chunk.data[i] == State::S1)
+						const_bits |= uint64_t(1) << (pos + i);
+				pos += chunk.width;
+				continue;
+			}
+
+			string signame = prefix + cid(chunk.wire->name);
+			int n = chunk.wire->width;
+
+			for (int k = chunk.offset; k < chunk.offset + chunk.width;)
+			{
+				int word_idx = k / max_uintsize;
+				int word_lo = word_idx * max_uintsize;
+				int word_hi = std::min(n-1, word_lo + max_uintsize - 1);
+				int end = std::min(word_hi, chunk.offset + chunk.width - 1);
+				int dst = pos + k - chunk.offset;
+
+				string term = "(uint64_t)" + util_word_field(signame, n, word_idx);
+				if (k > word_lo)
+					term = stringf("(%s >> %d)", term.c_str(), k - word_lo);
+				if (end < word_hi)
+					term = stringf("(%s & %s)", term.c_str(), util_mask(end - k + 1).c_str());
+				if (dst > 0)
+					term = stringf("(%s << %d)", term.c_str(), dst);
+
+				terms.push_back(term);
+				k = end + 1;
+			}
+
+			pos += chunk.width;
+		}
+
+		if (const_bits != 0 || terms.empty())
+			terms.push_back(util_const(const_bits));
+
+		if (GetSize(terms) == 1)
+			return terms.front();
+
+		string expr;
+		for (auto &term : terms)
+			expr += (expr.empty() ? "(" : " | ") + term;
+		return expr + ")";
+	}
+
+	// Statement storing the uint64_t expression expr into the (sigmapped)
+	// signal sig, one packed word at a time.
+	string util_set_word(const string &prefix, const SigSpec &sig, const string &expr)
+	{
+		log_assert(GetSize(sig) <= 64);
+
+		string stmt = stringf("  { uint64_t value = %s;", expr.c_str());
+		int pos = 0;
+
+		for (auto &chunk : sig.chunks())
+		{
+			if (chunk.wire == nullptr) {
+				pos += chunk.width;
+				continue;
+			}
+
+			string signame = prefix + cid(chunk.wire->name);
+			int n = chunk.wire->width;
+
+			for (int k = chunk.offset; k < chunk.offset + chunk.width;)
+			{
+				int word_idx = k / max_uintsize;
+				int word_lo = word_idx * max_uintsize;
+				int word_hi = std::min(n-1, word_lo + max_uintsize - 1);
+				int end = std::min(word_hi, chunk.offset + chunk.width - 1);
+				int src = pos + k - chunk.offset;
+
+				string field = util_word_field(signame, n, word_idx);
+				string val = src > 0 ? stringf("(value >> %d)", src) : "value";
+
+				if (k == word_lo && end == word_hi)
+					stmt += stringf(" %s = %s;", field.c_str(), val.c_str());
+				else {
+					string mask = util_mask(end - k + 1);
+					stmt += stringf(" %s = (%s & ~(%s << %d)) | ((%s & %s) << %d);", field.c_str(), field.c_str(),
+							mask.c_str(), k - word_lo, val.c_str(), mask.c_str(), k - word_lo);
+				}
+
+				k = end + 1;
+			}
+
+			pos += chunk.width;
+		}
+
+		return stmt + " }";
+	}
+
+	void set_dirty(HierDirtyFlags *work, const SigSpec &sig)
+	{
+		for (auto bit : sig)
+			if (bit.wire != nullptr)
+				work->set_dirty(bit);
+	}
+
+	bool eval_word_cell(HierDirtyFlags *work, Cell *cell)
+	{
+		SigMap &sigmap = sigmaps.at(work->module);
+
+		auto port = [&](const char *name) {
+			return sigmap(cell->getPort(name));
+		};
+		auto param_bool = [&](const char *name) {
+			return cell->hasParam(name) && cell->getParam(name).as_bool();
+		};
+		auto word = [&](const SigSpec &sig) {
+			if (GetSize(sig) > 64)
+				log_error("Cell %s (%s) has a %d bit wide operand. Only up to 64 bits are supported for this cell type.\n",
+						log_id(cell), log_id(cell->type), GetSize(sig));
+			return util_get_word(work->prefix, sig);
+		};
+		auto assign = [&](const SigSpec &sig, const string &expr) {
+			if (GetSize(sig) > 64)
+				log_error("Cell %s (%s) has a %d bit wide result. Only up to 64 bits are supported for this cell type.\n",
+						log_id(cell), log_id(cell->type), GetSize(sig));
+			funct_declarations.push_back(util_set_word(work->prefix, sig, expr) + stringf(" // %s (%s)", log_id(cell), log_id(cell->type)));
+			set_dirty(work, sig);
+		};
+		auto assign_bool = [&](const SigSpec &sig, const string &expr) {
+			for (int i = 0; i < GetSize(sig); i += 64)
+				assign(sig.extract(i, std::min(64, GetSize(sig)-i)), i == 0 ? "(uint64_t)(" + expr + ")" : "0");
+		};
+		auto ext = [&](const string &expr, int width, bool is_signed) {
+			return is_signed ? stringf("yosys_simplec_sext(%s, %d)", expr.c_str(), width) : expr;
+		};
+		auto reduce = [&](SigSpec sig, const char *op) {
+			string expr;
+			for (int i = 0; i < GetSize(sig); i += 64) {
+				SigSpec slice = sig.extract(i, std::min(64, GetSize(sig)-i));
+				string term;
+				if (!strcmp(op, "and"))
+					term = stringf("%s == %s", word(slice).c_str(), util_mask(GetSize(slice)).c_str());
+				if (!strcmp(op, "or"))
+					term = stringf("%s != 0", word(slice).c_str());
+				if (!strcmp(op, "xor"))
+					term = word(slice);
+				expr += expr.empty() ? term : !strcmp(op, "and") ? " && " + term : !strcmp(op, "or") ? " || " + term : " ^ " + term;
+			}
+			if (expr.empty())
+				expr = !strcmp(op, "and") ? "1" : "0";
+			return !strcmp(op, "xor") ? "yosys_simplec_parity(" + expr + ")" : "(" + expr + ")";
+		};
+
+		util_word_helpers();
+
+		// Bit-parallel cells: these work on any width, in slices of 64 bits.
+		if (cell->type.in("$not", "$pos", "$and", "$or", "$xor", "$xnor", "$mux", "$tribuf", "$_TBUF_", "$fa"))
+		{
+			bool is_fa = cell->type == "$fa";
+			SigSpec y = port("\\Y");
+			SigSpec a = port("\\A"), b, c, s;
+			a.extend_u0(GetSize(y), param_bool("\\A_SIGNED"));
+			if (cell->hasPort("\\B")) {
+				b = port("\\B");
+				b.extend_u0(GetSize(y), param_bool("\\B_SIGNED"));
+			}
+			if (is_fa)
+				c = port("\\C");
+			if (cell->hasPort("\\S"))
+				s = port("\\S");
+			if (cell->hasPort("\\EN"))
+				s = port("\\EN");
+			if (cell->hasPort("\\E"))
+				s = port("\\E");
+
+			for (int i = 0; i < GetSize(y); i += 64)
+			{
+				int w = std::min(64, GetSize(y)-i);
+				string a_expr = word(a.extract(i, w));
+				string b_expr = b.empty() ? "" : word(b.extract(i, w));
+				string expr;
+
+				if (cell->type == "$not")  expr = "~" + a_expr;
+				if (cell->type == "$pos")  expr = a_expr;
+				if (cell->type == "$and")  expr = stringf("%s & %s", a_expr.c_str(), b_expr.c_str());
+				if (cell->type == "$or")   expr = stringf("%s | %s", a_expr.c_str(), b_expr.c_str());
+				if (cell->type == "$xor")  expr = stringf("%s ^ %s", a_expr.c_str(), b_expr.c_str());
+				if (cell->type == "$xnor") expr = stringf("~(%s ^ %s)", a_expr.c_str(), b_expr.c_str());
+				if (cell->type == "$mux")  expr = stringf("%s ? %s : %s", word(s).c_str(), b_expr.c_str(), a_expr.c_str());
+				if (cell->type.in("$tribuf", "$_TBUF_")) expr = stringf("%s ? %s : 0", word(s).c_str(), a_expr.c_str());
+
+				if (is_fa) {
+					string c_expr = word(c.extract(i, w));
+					assign(port("\\X").extract(i, w), stringf("(%s & %s) | (%s & %s) | (%s & %s)", a_expr.c_str(), b_expr.c_str(),
+							a_expr.c_str(), c_expr.c_str(), b_expr.c_str(), c_expr.c_str()));
+					expr = stringf("%s ^ %s ^ %s", a_expr.c_str(), b_expr.c_str(), c_expr.c_str());
+				}
+
+				assign(y.extract(i, w), expr);
+			}
+			return true;
+		}
+
+		if (cell->type == "$pmux")
+		{
+			SigSpec y = port("\\Y"), a = port("\\A"), b = port("\\B"), s = port("\\S");
+
+			for (int i = 0; i < GetSize(y); i += 64)
+			{
+				int w = std::min(64, GetSize(y)-i);
+				string expr = word(a.extract(i, w));
+				for (int j = GetSize(s)-1; j >= 0; j--)
+					expr = stringf("%s ? %s : %s", word(s[j]).c_str(), word(b.extract(j*GetSize(y)+i, w)).c_str(), expr.c_str());
+				assign(y.extract(i, w), expr);
+			}
+			return true;
+		}
+
+		if (cell->type.in("$slice", "$concat", "$equiv"))
+		{
+			SigSpec y = port("\\Y"), a = port("\\A");
+
+			if (cell->type == "$slice")
+				a = a.extract(cell->getParam("\\OFFSET").as_int(), GetSize(y));
+			if (cell->type == "$concat")
+				a.append(port("\\B"));
+
+			for (int i = 0; i < GetSize(y); i += 64) {
+				int w = std::min(64, GetSize(y)-i);
+				assign(y.extract(i, w), word(a.extract(i, w)));
+			}
+			return true;
+		}
+
+		if (cell->type.in("$reduce_and", "$reduce_or", "$reduce_xor", "$reduce_xnor", "$reduce_bool", "$logic_not", "$logic_and", "$logic_or"))
+		{
+			SigSpec y = port("\\Y"), a = port("\\A");
+			string expr;
+
+			if (cell->type == "$reduce_and")  expr = reduce(a, "and");
+			if (cell->type == "$reduce_or")   expr = reduce(a, "or");
+			if (cell->type == "$reduce_bool") expr = reduce(a, "or");
+			if (cell->type == "$reduce_xor")  expr = reduce(a, "xor");
+			if (cell->type == "$reduce_xnor") expr = "!" + reduce(a, "xor");
+			if (cell->type == "$logic_not")   expr = "!" + reduce(a, "or");
+			if (cell->type == "$logic_and")   expr = reduce(a, "or") + " && " + reduce(port("\\B"), "or");
+			if (cell->type == "$logic_or")    expr = reduce(a, "or") + " || " + reduce(port("\\B"), "or");
+
+			assign_bool(y, expr);
+			return true;
+		}
+
+		if (cell->type.in("$eq", "$ne", "$eqx", "$nex"))
+		{
+			SigSpec y = port("\\Y"), a = port("\\A"), b = port("\\B");
+			bool is_signed = param_bool("\\A_SIGNED") && param_bool("\\B_SIGNED");
+			int width = std::max(GetSize(a), GetSize(b));
+			a.extend_u0(width, is_signed);
+			b.extend_u0(width, is_signed);
+
+			string expr;
+			for (int i = 0; i < width; i += 64) {
+				int w = std::min(64, width-i);
+				expr += stringf("%s%s == %s", expr.empty() ? "" : " && ", word(a.extract(i, w)).c_str(), word(b.extract(i, w)).c_str());
+			}
+			if (expr.empty())
+				expr = "1";
+
+			assign_bool(y, cell->type.in("$eq", "$eqx") ? "(" + expr + ")" : "!(" + expr + ")");
+			return true;
+		}
+
+		if (cell->type.in("$lt", "$le", "$gt", "$ge"))
+		{
+			SigSpec y = port("\\Y"), a = port("\\A"), b = port("\\B");
+			bool is_signed = param_bool("\\A_SIGNED") && param_bool("\\B_SIGNED");
+			string a_expr = word(a), b_expr = word(b), op;
+
+			if (cell->type == "$lt") op = "<";
+			if (cell->type == "$le") op = "<=";
+			if (cell->type == "$gt") op = ">";
+			if (cell->type == "$ge") op = ">=";
+
+			if (is_signed)
+				assign_bool(y, stringf("(int64_t)%s %s (int64_t)%s", ext(a_expr, GetSize(a), true).c_str(), op.c_str(), ext(b_expr, GetSize(b), true).c_str()));
+			else
+				assign_bool(y, stringf("%s %s %s", a_expr.c_str(), op.c_str(), b_expr.c_str()));
+			return true;
+		}
+
+		if (cell->type.in("$neg", "$add", "$sub", "$mul", "$div", "$mod", "$pow"))
+		{
+			SigSpec y = port("\\Y"), a = port("\\A"), b;
+			bool a_signed = param_bool("\\A_SIGNED"), b_signed = param_bool("\\B_SIGNED");
+			string a_expr = ext(word(a), GetSize(a), a_signed), b_expr;
+
+			if (cell->hasPort("\\B")) {
+				b = port("\\B");
+				b_expr = ext(word(b), GetSize(b), b_signed);
+			}
+
+			if (cell->type == "$neg") assign(y, "UINT64_C(0) - " + a_expr);
+			if (cell->type == "$add") assign(y, stringf("%s + %s", a_expr.c_str(), b_expr.c_str()));
+			if (cell->type == "$sub") assign(y, stringf("%s - %s", a_expr.c_str(), b_expr.c_str()));
+			if (cell->type == "$mul") assign(y, stringf("%s * %s", a_expr.c_str(), b_expr.c_str()));
+			if (cell->type == "$div") assign(y, stringf("yosys_simplec_div(%s, %s, %s)", a_expr.c_str(), b_expr.c_str(), a_signed && b_signed ? "true" : "false"));
+			if (cell->type == "$mod") assign(y, stringf("yosys_simplec_mod(%s, %s, %s)", a_expr.c_str(), b_expr.c_str(), a_signed && b_signed ? "true" : "false"));
+			if (cell->type == "$pow") assign(y, stringf("yosys_simplec_pow(%s, %s, %s)", a_expr.c_str(), b_expr.c_str(), b_signed ? "true" : "false"));
+			return true;
+		}
+
+		if (cell->type.in("$shl", "$sshl", "$shr", "$sshr", "$shift", "$shiftx"))
+		{
+			SigSpec y = port("\\Y"), a = port("\\A"), b = port("\\B");
+			bool a_signed = param_bool("\\A_SIGNED"), b_signed = param_bool("\\B_SIGNED");
+			int width = std::max(GetSize(a), GetSize(y));
+			string a_expr = word(a), b_expr = word(b);
+			string a_ext = stringf("(%s & %s)", ext(a_expr, GetSize(a), a_signed).c_str(), util_mask(width).c_str());
+
+			if (cell->type.in("$shl", "$sshl"))
+				assign(y, stringf("yosys_simplec_shl(%s, %s)", ext(a_expr, GetSize(a), a_signed).c_str(), b_expr.c_str()));
+			if (cell->type == "$shr" || (cell->type == "$sshr" && !a_signed))
+				assign(y, stringf("yosys_simplec_shr(%s, %s)", a_ext.c_str(), b_expr.c_str()));
+			if (cell->type == "$sshr" && a_signed)
+				assign(y, stringf("yosys_simplec_sshr(%s, %s)", ext(a_expr, GetSize(a), true).c_str(), b_expr.c_str()));
+			if (cell->type.in("$shift", "$shiftx")) {
+				if (cell->type == "$shiftx")
+					a_ext = stringf("(%s & %s)", a_expr.c_str(), util_mask(GetSize(a)).c_str());
+				if (b_signed)
+					assign(y, stringf("yosys_simplec_shift(%s, (int64_t)%s)", a_ext.c_str(), ext(b_expr, GetSize(b), true).c_str()));
+				else
+					assign(y, stringf("yosys_simplec_shr(%s, %s)", a_ext.c_str(), b_expr.c_str()));
+			}
+			return true;
+		}
+
+		if (cell->type == "$lut")
+		{
+			SigSpec y = port("\\Y"), a = port("\\A");
+			if (GetSize(a) > 6)
+				log_error("LUT cell %s has %d inputs. Only up to 6 inputs are supported.\n", log_id(cell), GetSize(a));
+
+			Const lut = cell->getParam("\\LUT");
+			uint64_t mask = 0;
+			for (int i = 0; i < GetSize(lut) && i < 64; i++)
+				if (lut[i] == State::S1)
+					mask |= uint64_t(1) << i;
+
+			assign(y, stringf("(%s >> %s) & 1", util_const(mask).c_str(), word(a).c_str()));
+			return true;
+		}
+
+		if (cell->type == "$sop")
+		{
+			SigSpec y = port("\\Y"), a = port("\\A");
+			Const table = cell->getParam("\\TABLE");
+			int width = cell->getParam("\\WIDTH").as_int();
+			int depth = cell->getParam("\\DEPTH").as_int();
+			string a_expr = word(a), expr;
+
+			for (int i = 0; i < depth; i++) {
+				uint64_t need0 = 0, need1 = 0;
+				for (int j = 0; j < width; j++) {
+					if (table[2*width*i + 2*j + 0] == State::S1)
+						need0 |= uint64_t(1) << j;
+					if (table[2*width*i + 2*j + 1] == State::S1)
+						need1 |= uint64_t(1) << j;
+				}
+				if (need0 & need1)
+					continue;
+				expr += stringf("%s(%s & %s) == %s", expr.empty() ? "" : " || ", a_expr.c_str(),
+						util_const(need0 | need1).c_str(), util_const(need1).c_str());
+			}
+
+			assign_bool(y, expr.empty() ? "0" : expr);
+			return true;
+		}
+
+		if (cell->type == "$lcu")
+		{
+			SigSpec co = port("\\CO");
+			assign(co, stringf("yosys_simplec_lcu(%s, %s, %s, %d)", word(port("\\P")).c_str(), word(port("\\G")).c_str(),
+					word(port("\\CI")).c_str(), GetSize(co)));
+			return true;
+		}
+
+		if (cell->type == "$alu")
+		{
+			SigSpec y = port("\\Y"), a = port("\\A"), b = port("\\B");
+			string a_expr = ext(word(a), GetSize(a), param_bool("\\A_SIGNED"));
+			string b_expr = ext(word(b), GetSize(b), param_bool("\\B_SIGNED"));
+
+			funct_declarations.push_back(stringf("  { uint64_t alu_a = %s, alu_b = %s ? ~%s : %s;", a_expr.c_str(),
+					word(port("\\BI")).c_str(), b_expr.c_str(), b_expr.c_str()));
+			funct_declarations.push_back(stringf("    uint64_t alu_y = alu_a + alu_b + %s, alu_x = alu_a ^ alu_b;", word(port("\\CI")).c_str()));
+			assign(port("\\X"), "alu_x");
+			assign(y, "alu_y");
+			assign(port("\\CO"), "(alu_a & alu_b) | (alu_x & (alu_y ^ alu_x))");
+			funct_declarations.push_back("  }");
+			return true;
+		}
+
+		if (cell->type == "$mem")
+		{
+			string memname = work->prefix + cid(cell->name);
+			int abits = cell->getParam("\\ABITS").as_int();
+			int width = cell->getParam("\\WIDTH").as_int();
+			int size = cell->getParam("\\SIZE").as_int();
+			int offset = cell->getParam("\\OFFSET").as_int();
+			Const rd_clk_enable = cell->getParam("\\RD_CLK_ENABLE");
+
+			for (int i = 0; i < cell->getParam("\\RD_PORTS").as_int(); i++) {
+				if (rd_clk_enable[i] == State::S1)
+					continue;
+				string addr = stringf("(%s - %s)", word(port("\\RD_ADDR").extract(i*abits, abits)).c_str(), util_const(offset).c_str());
+				assign(port("\\RD_DATA").extract(i*width, width), stringf("%s < %d ? (uint64_t)%s[%s] : 0",
+						addr.c_str(), size, memname.c_str(), addr.c_str()));
+			}
+			return true;
+		}
+
+		return false;
+	}
+
+	void eval_tick(HierDirtyFlags *work, vector<string> &preamble, vector<string> &commit)
+	{
+		Module *mod = work->module;
+		SigMap &sigmap = sigmaps.at(mod);
+		dict<SigBit, int> clock_locals;
+
+		for (int i = 0; i < GetSize(clock_bits[mod]); i++)
+		{
+			SigBit bit = clock_bits[mod][i];
+			string prev = work->prefix + clock_prev_names.at(mod).at(i);
+			int k = tick_locals++;
+
+			preamble.push_back(stringf("  bool clk_%d = %s; // %s", k, util_get_bit(work->prefix + cid(bit.wire->name),
+					bit.wire->width, bit.offset).c_str(), log_signal(bit)));
+			preamble.push_back(stringf("  bool posedge_%d = clk_%d && !%s, negedge_%d = !clk_%d && %s;", k, k, prev.c_str(), k, k, prev.c_str()));
+			preamble.push_back(stringf("  %s = clk_%d;", prev.c_str(), k));
+			clock_locals[bit] = k;
+		}
+
+		auto get = [&](const SigSpec &sig) {
+			return util_get_word(work->prefix, sig);
+		};
+		auto active = [&](const SigSpec &sig, bool polarity) {
+			return polarity ? get(sig) : "~" + get(sig);
+		};
+		auto trigger = [&](SigBit clk, bool polarity) -> string {
+			clk = sigmap(clk);
+			if (clock_locals.count(clk) == 0)
+				return "false";
+			return stringf("%s_%d", polarity ? "posedge" : "negedge", clock_locals.at(clk));
+		};
+
+		for (Cell *cell : mod->cells())
+		{
+			FfInfo ff;
+			if (!ff_info(mod, cell, &ff))
+				continue;
+
+			string trig = ff.clk.empty() ? "true" : trigger(ff.clk, ff.clk_polarity);
+			if (!ff.en.empty())
+				trig = stringf("(%s && %s%s)", trig.c_str(), ff.en_polarity ? "" : "!", get(ff.en).c_str());
+
+			for (int i = 0; i < GetSize(ff.q); i += 64)
+			{
+				int w = std::min(64, GetSize(ff.q)-i);
+				SigSpec q = ff.q.extract(i, w);
+				string q_expr = get(q), next = q_expr;
+				int k = tick_locals++;
+
+				if (!ff.d.empty())
+					next = trig == "true" ? get(ff.d.extract(i, w)) : trig == "false" ? q_expr :
+							stringf("%s ? %s : %s", trig.c_str(), get(ff.d.extract(i, w)).c_str(), q_expr.c_str());
+
+				preamble.push_back(stringf("  uint64_t ff_%d = %s; // %s (%s)", k, next.c_str(), log_id(cell), log_id(cell->type)));
+
+				if (!ff.set.empty())
+					preamble.push_back(stringf("  ff_%d = (ff_%d | %s) & ~(%s);", k, k, active(ff.set.extract(i, w), ff.set_polarity).c_str(),
+							active(ff.clr.extract(i, w), ff.clr_polarity).c_str()));
+
+				if (!ff.arst.empty()) {
+					uint64_t value = 0;
+					for (int j = 0; j < w && i+j < GetSize(ff.arst_value); j++)
+						if (ff.arst_value[i+j] == State::S1)
+							value |= uint64_t(1) << j;
+					preamble.push_back(stringf("  if (%s%s) ff_%d = %s;", ff.arst_polarity ? "" : "!", get(ff.arst).c_str(), k, util_const(value).c_str()));
+				}
+
+				commit.push_back(util_set_word(work->prefix, q, stringf("ff_%d", k)));
+				set_dirty(work, q);
+			}
+		}
+
+		for (Cell *cell : mod->cells())
+		{
+			if (cell->type != "$mem")
+				continue;
+
+			string memname = work->prefix + cid(cell->name);
+			int abits = cell->getParam("\\ABITS").as_int();
+			int width = cell->getParam("\\WIDTH").as_int();
+			int size = cell->getParam("\\SIZE").as_int();
+			int offset = cell->getParam("\\OFFSET").as_int();
+			int rd_ports = cell->getParam("\\RD_PORTS").as_int();
+			int wr_ports = cell->getParam("\\WR_PORTS").as_int();
+			Const rd_clk_enable = cell->getParam("\\RD_CLK_ENABLE");
+			Const rd_clk_polarity = cell->getParam("\\RD_CLK_POLARITY");
+			Const rd_transparent = cell->getParam("\\RD_TRANSPARENT");
+			Const wr_clk_enable = cell->getParam("\\WR_CLK_ENABLE");
+			Const wr_clk_polarity = cell->getParam("\\WR_CLK_POLARITY");
+			SigSpec rd_clk = sigmap(cell->getPort("\\RD_CLK")), rd_en = sigmap(cell->getPort("\\RD_EN"));
+			SigSpec rd_addr = sigmap(cell->getPort("\\RD_ADDR")), rd_data = sigmap(cell->getPort("\\RD_DATA"));
+			SigSpec wr_clk = sigmap(cell->getPort("\\WR_CLK")), wr_en = sigmap(cell->getPort("\\WR_EN"));
+			SigSpec wr_addr = sigmap(cell->getPort("\\WR_ADDR")), wr_data = sigmap(cell->getPort("\\WR_DATA"));
+			bool has_async_read = false;
+
+			auto addr = [&](const SigSpec &sig) {
+				return stringf("(%s - %s)", get(sig).c_str(), util_const(offset).c_str());
+			};
+			auto sync_read = [&](int i) {
+				int k = tick_locals++;
+				SigSpec data = rd_data.extract(i*width, width);
+				preamble.push_back(stringf("  uint64_t rd_%d = %s; // %s (%s) read port %d", k, get(data).c_str(), log_id(cell), log_id(cell->type), i));
+				preamble.push_back(stringf("  if (%s && %s) { uint64_t addr = %s; rd_%d = addr < %d ? %s[addr] : 0; }",
+						trigger(rd_clk[i], rd_clk_polarity[i] == State::S1).c_str(), get(rd_en[i]).c_str(),
+						addr(rd_addr.extract(i*abits, abits)).c_str(), k, size, memname.c_str()));
+				commit.push_back(util_set_word(work->prefix, data, stringf("rd_%d", k)));
+				set_dirty(work, data);
+			};
+
+			for (int i = 0; i < rd_ports; i++)
+				if (rd_clk_enable[i] != State::S1)
+					has_async_read = true;
+				else if (rd_transparent[i] != State::S1)
+					sync_read(i);
+
+			for (int i = 0; i < wr_ports; i++) {
+				if (wr_clk_enable[i] != State::S1)
+					log_error("Memory %s has an asynchronous write port, which is not supported.\n", log_id(cell));
+				string en = get(wr_en.extract(i*width, width));
+				preamble.push_back(stringf("  if (%s) { uint64_t addr = %s; if (addr < %d) %s[addr] = (%s[addr] & ~%s) | (%s & %s); } // %s (%s) write port %d",
+						trigger(wr_clk[i], wr_clk_polarity[i] == State::S1).c_str(), addr(wr_addr.extract(i*abits, abits)).c_str(), size,
+						memname.c_str(), memname.c_str(), en.c_str(), get(wr_data.extract(i*width, width)).c_str(), en.c_str(),
+						log_id(cell), log_id(cell->type), i));
+			}
+
+			for (int i = 0; i < rd_ports; i++)
+				if (rd_clk_enable[i] == State::S1 && rd_transparent[i] == State::S1)
+					sync_read(i);
+
+			if (has_async_read && wr_ports > 0)
+				work->set_dirty(cell);
+		}
+
+		for (auto &child : work->children)
+			eval_tick(child.second, preamble, commit);
+	}
+
+	void eval_init_clocks(HierDirtyFlags *work, vector<string> &postamble)
+	{
+		Module *mod = work->module;
+
+		for (int i = 0; i < GetSize(clock_bits[mod]); i++) {
+			SigBit bit = clock_bits[mod][i];
+			postamble.push_back(stringf("  %s%s = %s;", work->prefix.c_str(), clock_prev_names.at(mod).at(i).c_str(),
+					util_get_bit(work->prefix + cid(bit.wire->name), bit.wire->width, bit.offset).c_str()));
+		}
+
+		for (auto &child : work->children)
+			eval_init_clocks(child.second, postamble);
+	}
+
 	void create_module_struct(Module *mod)
 	{
 		if (generated_structs.count(mod->name))
@@ -297,8 +1062,14 @@ struct SimplecWorker
 					bit2output[mod][sigmaps.at(mod)(bit)].insert(bit);
 		}
 
+		driven_bits[mod];
+
 		for (Cell *c : mod->cells())
 		{
+			// Storage cells sample their inputs in the tick function only,
+			// so changes on their inputs do not need to activate them.
+			bool is_ff = ff_info(mod, c, nullptr);
+
 			for (auto &conn : c->connections())
 			{
 				if (!c->input(conn.first)) {
@@ -307,6 +1078,9 @@ struct SimplecWorker
 					continue;
 				}
 
+				if (is_ff)
+					continue;
+
 				int idx = 0;
 				for (auto bit : sigmaps.at(mod)(conn.second))
 					bit2cell[mod][bit].insert(tuple<Cell*, IdString, int>(c, conn.first, idx++));
@@ -316,28 +1090,97 @@ struct SimplecWorker
 				create_module_struct(design->module(c->type));
 		}
 
-		TopoSort<IdString> topo;
+		// Levelize the cells: every cell gets an index larger than the cells
+		// driving its inputs (storage cells start over at level zero), so that
+		// evaluating dirty cells in index order touches each cell only once.
+		dict<SigBit, Cell*> bit2driver;
+		dict<Cell*, vector<Cell*>> cell_users;
+		dict<Cell*, int> cell_pending;
+		vector<Cell*> order;
+
+		for (Cell *c : mod->cells()) {
+			if (ff_info(mod, c, nullptr))
+				continue;
+			for (auto &conn : c->connections())
+				if (c->output(conn.first))
+					for (auto bit : sigmaps.at(mod)(conn.second))
+						bit2driver[bit] = c;
+		}
 
 		for (Cell *c : mod->cells())
 		{
-			topo.node(c->name);
-
+			pool<Cell*> drivers;
 			for (auto &conn : c->connections())
-			{
-				if (!c->input(conn.first))
-					continue;
+				if (c->input(conn.first))
+					for (auto bit : sigmaps.at(mod)(conn.second)) {
+						auto it = bit2driver.find(bit);
+						if (it != bit2driver.end() && it->second != c)
+							drivers.insert(it->second);
+					}
 
-				for (auto bit : sigmaps.at(mod)(conn.second))
-				for (auto &it : bit2cell[mod][bit])
-					topo.edge(c->name, std::get<0>(it)->name);
+			cell_pending[c] = GetSize(drivers);
+			for (auto driver : drivers)
+				cell_users[driver].push_back(c);
+			if (drivers.empty())
+				order.push_back(c);
+		}
+
+		for (int i = 0; i < GetSize(order); i++)
+			for (auto user : cell_users[order[i]])
+				if (--cell_pending.at(user) == 0)
+					order.push_back(user);
+
+		// cells on combinational loops go last
+		for (Cell *c : mod->cells())
+			if (cell_pending.at(c) > 0)
+				order.push_back(c);
+
+		for (int i = 0; i < GetSize(order); i++)
+			topoidx[order[i]] = i;
+
+		// Clock nets of this module: clocks of local storage cells and
+		// memories, and the clock inputs of submodules.
+		pool<SigBit> clock_nets;
+
+		for (Cell *c : mod->cells())
+		{
+			FfInfo ff;
+			if (ff_info(mod, c, &ff) && !ff.clk.empty() && ff.clk[0].wire != nullptr)
+				clock_bits[mod](ff.clk[0]);
+
+			if (c->type == "$mem") {
+				SigSpec rd_clk = sigmaps.at(mod)(c->getPort("\\RD_CLK"));
+				SigSpec wr_clk = sigmaps.at(mod)(c->getPort("\\WR_CLK"));
+				for (int i = 0; i < GetSize(rd_clk); i++)
+					if (c->getParam("\\RD_CLK_ENABLE")[i] == State::S1 && rd_clk[i].wire != nullptr)
+						clock_bits[mod](rd_clk[i]);
+				for (int i = 0; i < GetSize(wr_clk); i++)
+					if (c->getParam("\\WR_CLK_ENABLE")[i] == State::S1 && wr_clk[i].wire != nullptr)
+						clock_bits[mod](wr_clk[i]);
 			}
+
+			Module *submod = design->module(c->type);
+			if (submod)
+				for (auto bit : clock_ports[submod])
+					clock_nets.insert(sigmaps.at(mod)(c->getPort(bit.wire->name)[bit.offset]));
 		}
 
-		topo.analyze_loops = false;
-		topo.sort();
+		for (auto bit : clock_bits[mod])
+			clock_nets.insert(bit);
 
-		for (int i = 0; i < GetSize(topo.sorted); i++)
-			topoidx[mod->cell(topo.sorted[i])] = i;
+		for (Wire *w : mod->wires())
+			if (w->port_input)
+				for (int i = 0; i < w->width; i++)
+					if (clock_nets.count(sigmaps.at(mod)(SigBit(w, i))))
+						clock_ports[mod].insert(SigBit(w, i));
+
+		for (int i = 0; i < GetSize(clock_bits[mod]); i++) {
+			string name = stringf("clk_prev_%d", i);
+			while (reserved_cids.count(name))
+				name += "_";
+			reserved_cids.insert(name);
+			clock_prev_names[mod].push_back(name);
+		}
 
 		string ifdef_name = stringf("yosys_simplec_%s_state_t", cid(mod->name).c_str());
 
@@ -372,6 +1215,31 @@ struct SimplecWorker
 			if (design->module(c->type))
 				struct_declarations.push_back(stringf("  struct %s_state_t %s; // %s", cid(c->type).c_str(), cid(c->name).c_str(), log_id(c)));
 
+		for (Cell *c : mod->cells())
+		{
+			if (c->type != "$mem")
+				continue;
+
+			int width = c->getParam("\\WIDTH").as_int();
+			if (width > 64)
+				log_error("Memory %s is %d bits wide. Only up to 64 bits are supported.\n", log_id(c), width);
+
+			int k = 8;
+			while (k < width)
+				k *= 2;
+
+			struct_declarations.push_back("");
+			struct_declarations.push_back(stringf("  // Memory %s", log_id(c)));
+			struct_declarations.push_back(stringf("  uint%d_t %s[%d];", k, cid(c->name).c_str(), c->getParam("\\SIZE").as_int()));
+		}
+
+		if (!clock_bits[mod].empty()) {
+			struct_declarations.push_back("");
+			struct_declarations.push_back("  // Clock Values At Last Tick");
+			for (int i = 0; i < GetSize(clock_bits[mod]); i++)
+				struct_declarations.push_back(stringf("  bool %s; // %s", clock_prev_names[mod][i].c_str(), log_signal(clock_bits[mod][i])));
+		}
+
 		struct_declarations.push_back(stringf("};"));
 		struct_declarations.push_back("#endif");
 	}
@@ -496,6 +1364,19 @@ struct SimplecWorker
 			return;
 		}
 
+		// Storage cells are updated by the tick function.
+		if (ff_info(work->module, cell, nullptr))
+			return;
+
+		if (eval_word_cell(work, cell))
+			return;
+
+		if (cell->type.in("$memrd", "$memwr", "$meminit"))
+			log_error("Cell %s (%s) must be merged into a $mem cell with memory_collect first.\n", log_id(cell), log_id(cell->type));
+
+		if (cell->type == "$macc")
+			log_error("Cell %s ($macc) must be mapped with maccmap first.\n", log_id(cell));
+
 		log_error("No C model for %s available at the moment (FIXME).\n", log_id(cell->type));
 	}
 
@@ -573,7 +1454,7 @@ struct SimplecWorker
 				{
 					Cell *cell = nullptr;
 					for (auto c : work->dirty_cells)
-						if (cell == nullptr || topoidx.at(cell) < topoidx.at(c))
+						if (cell == nullptr || topoidx.at(c) < topoidx.at(cell))
 							cell = c;
 
 					string hiername = work->log_prefix + "." + log_id(cell);
@@ -628,7 +1509,7 @@ struct SimplecWorker
 			eval_sticky_dirty(child.second);
 	}
 
-	void make_func(HierDirtyFlags *work, const string &func_name, const vector<string> &preamble)
+	void make_func(HierDirtyFlags *work, const string &func_name, const vector<string> &preamble, const vector<string> &postamble = vector<string>())
 	{
 		log("Generating function %s():\n", func_name.c_str());
 
@@ -642,6 +1523,8 @@ struct SimplecWorker
 			funct_declarations.push_back(line);
 		eval_dirty(work);
 		eval_sticky_dirty(work);
+		for (auto &line : postamble)
+			funct_declarations.push_back(line);
 		funct_declarations.push_back("}");
 
 		log("  Activated %d cells (%d activated more than once).\n", GetSize(activated_cells), GetSize(reactivated_cells));
@@ -679,6 +1562,34 @@ struct SimplecWorker
 			}
 		}
 
+		for (Cell *cell : module->cells())
+		{
+			FfInfo ff;
+			if (ff_info(module, cell, &ff))
+				set_dirty(work, ff.q);
+
+			if (cell->type == "$mem")
+			{
+				string memname = work->prefix + cid(cell->name);
+				int width = cell->getParam("\\WIDTH").as_int();
+				int size = cell->getParam("\\SIZE").as_int();
+				Const init = cell->getParam("\\INIT");
+
+				preamble.push_back(stringf("  for (int i = 0; i < %d; i++) %s[i] = 0;", size, memname.c_str()));
+				for (int i = 0; i < size && i*width < GetSize(init); i++) {
+					uint64_t value = 0;
+					for (int j = 0; j < width && i*width+j < GetSize(init); j++)
+						if (init[i*width+j] == State::S1)
+							value |= uint64_t(1) << j;
+					if (value != 0)
+						preamble.push_back(stringf("  %s[%d] = %s;", memname.c_str(), i, util_const(value).c_str()));
+				}
+
+				set_dirty(work, sigmaps.at(module)(cell->getPort("\\RD_DATA")));
+				work->set_dirty(cell);
+			}
+		}
+
 		work->set_dirty(State::S0);
 		work->set_dirty(State::S1);
 
@@ -688,9 +1599,10 @@ struct SimplecWorker
 
 	void make_init_func(HierDirtyFlags *work)
 	{
-		vector<string> preamble;
+		vector<string> preamble, postamble;
 		eval_init(work, preamble);
-		make_func(work, cid(work->module->name) + "_init", preamble);
+		eval_init_clocks(work, postamble);
+		make_func(work, cid(work->module->name) + "_init", preamble, postamble);
 	}
 
 	void make_eval_func(HierDirtyFlags *work)
@@ -707,9 +1619,65 @@ struct SimplecWorker
 		make_func(work, cid(work->module->name) + "_eval", preamble);
 	}
 
-	void make_tick_func(HierDirtyFlags* /* work */)
+	void make_tick_func(HierDirtyFlags *work)
+	{
+		// All storage elements sample their inputs before any of them is
+		// updated, then the new state is propagated like in _eval().
+		vector<string> preamble, commit;
+		tick_locals = 0;
+		eval_tick(work, preamble, commit);
+		preamble.insert(preamble.end(), commit.begin(), commit.end());
+		make_func(work, cid(work->module->name) + "_tick", preamble);
+	}
+
+	void make_bench_func(Module *mod)
 	{
-		// FIXME
+		string name = cid(mod->name);
+		SigSpec data_inputs;
+		vector<SigBit> clock_inputs;
+
+		for (Wire *w : mod->wires()) {
+			if (!w->port_input)
+				continue;
+			for (int i = 0; i < w->width; i++) {
+				if (clock_ports[mod].count(SigBit(w, i)))
+					clock_inputs.push_back(SigBit(w, i));
+				else
+					data_inputs.append(SigBit(w, i));
+			}
+		}
+
+		funct_declarations.push_back("");
+		funct_declarations.push_back("#ifndef YOSYS_SIMPLEC_BENCH_CYCLES");
+		funct_declarations.push_back("#define YOSYS_SIMPLEC_BENCH_CYCLES 1000000");
+		funct_declarations.push_back("#endif");
+		funct_declarations.push_back("");
+		funct_declarations.push_back("int main(void)");
+		funct_declarations.push_back("{");
+		funct_declarations.push_back(stringf("  static struct %s_state_t state;", name.c_str()));
+		funct_declarations.push_back("  uint64_t lfsr = UINT64_C(0x2545f4914f6cdd1d);");
+		funct_declarations.push_back("  long cycle;");
+		funct_declarations.push_back(stringf("  %s_init(&state);", name.c_str()));
+		funct_declarations.push_back("  clock_t start = clock();");
+		funct_declarations.push_back("  for (cycle = 0; cycle < YOSYS_SIMPLEC_BENCH_CYCLES; cycle++) {");
+		for (int i = 0; i < GetSize(data_inputs); i += 64) {
+			funct_declarations.push_back("    lfsr ^= lfsr << 13; lfsr ^= lfsr >> 7; lfsr ^= lfsr << 17;");
+			funct_declarations.push_back("  " + util_set_word("state.", data_inputs.extract(i, std::min(64, GetSize(data_inputs)-i)), "lfsr"));
+		}
+		funct_declarations.push_back(stringf("    %s_eval(&state);", name.c_str()));
+		for (auto bit : clock_inputs)
+			for (auto value : {"true", "false"}) {
+				funct_declarations.push_back("  " + util_set_bit("state." + cid(bit.wire->name), bit.wire->width, bit.offset, value));
+				funct_declarations.push_back(stringf("    %s_eval(&state);", name.c_str()));
+				funct_declarations.push_back(stringf("    %s_tick(&state);", name.c_str()));
+			}
+		if (clock_inputs.empty())
+			funct_declarations.push_back(stringf("    %s_tick(&state);", name.c_str()));
+		funct_declarations.push_back("  }");
+		funct_declarations.push_back("  double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;");
+		funct_declarations.push_back("  printf(\"%ld cycles in %.3f seconds (%.0f cycles/second)\\n\", cycle, seconds, seconds > 0 ? cycle / seconds : 0.0);");
+		funct_declarations.push_back("  return 0;");
+		funct_declarations.push_back("}");
 	}
 
 	void run(Module *mod)
@@ -721,6 +1689,9 @@ struct SimplecWorker
 		make_init_func(&work);
 		make_eval_func(&work);
 		make_tick_func(&work);
+
+		if (bench)
+			make_bench_func(mod);
 	}
 
 	void write(std::ostream &f)
@@ -728,6 +1699,11 @@ struct SimplecWorker
 		f << "#include <stdint.h>" << std::endl;
 		f << "#include <stdbool.h>" << std::endl;
 
+		if (bench) {
+			f << "#include <stdio.h>" << std::endl;
+			f << "#include <time.h>" << std::endl;
+		}
+
 		for (auto &line : signal_declarations)
 			f << line << std::endl;
 
@@ -754,13 +1730,28 @@ struct SimplecBackend : public Backend {
 		log("simulate the design in a C environment, but the purpose of this command is to\n");
 		log("generate code that works well with C-based formal verification.\n");
 		log("\n");
+		log("For the top module <top> the functions <top>_init(), <top>_eval() and\n");
+		log("<top>_tick() are generated. _eval() propagates changed inputs through the\n");
+		log("combinational logic. _tick() updates all flip-flops, latches and memories\n");
+		log("(as if their clocks had their edge since the previous _tick() call, so any\n");
+		log("number of clock domains is supported) and propagates the new state.\n");
+		log("Asynchronous resets and latches are sampled by _tick() as well. Memories must\n");
+		log("be merged into $mem cells (memory_collect) and may be up to 64 bits wide.\n");
+		log("\n");
+		log("Signals are stored packed into words. Word-level cells are evaluated on whole\n");
+		log("words, arithmetic cells support operands of up to 64 bits.\n");
+		log("\n");
 		log("    -verbose\n");
 		log("        this will print the recursive walk used to export the modules.\n");
 		log("\n");
 		log("    -i8, -i16, -i32, -i64\n");
 		log("        set the maximum integer bit width to use in the generated code.\n");
 		log("\n");
-		log("THIS COMMAND IS UNDER CONSTRUCTION\n");
+		log("    -bench\n");
+		log("        add a main() function that drives the top module inputs with random\n");
+		log("        data, toggles all of its clock inputs and prints the number of clock\n");
+		log("        cycles simulated per second. The number of cycles can be changed by\n");
+		log("        defining YOSYS_SIMPLEC_BENCH_CYCLES when compiling.\n");
 		log("\n");
 	}
 	void execute(std::ostream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design) YS_OVERRIDE
@@ -779,6 +1770,10 @@ struct SimplecBackend : public Backend {
 				worker.verbose = true;
 				continue;
 			}
+			if (args[argidx] == "-bench") {
+				worker.bench = true;
+				continue;
+			}
 			if (args[argidx] == "-i8") {
 				worker.max_uintsize = 8;
 				continue;
@@ -596,12 +596,20 @@ void AigerReader::parse_aiger_ascii()
 	std::getline(f, line); // Ignore up to start of next line
 }
 
-static unsigned parse_next_delta_literal(std::istream &f, unsigned ref)
+// Decode directly from the stream buffer: going through std::istream::get()
+// costs a sentry construction per byte, which dominates for large AIGs.
+static unsigned parse_next_delta_literal(std::streambuf *sb, unsigned ref)
 {
 	unsigned x = 0, i = 0;
-	unsigned char ch;
-	while ((ch = f.get()) & 0x80)
+	int ch;
+	while (1) {
+		ch = sb->sbumpc();
+		if (ch == std::char_traits<char>::eof())
+			log_error("Unexpected end of file while reading AND gate delta!\n");
+		if (!(ch & 0x80))
+			break;
 		x |= (ch & 0x7f) << (7 * i++);
+	}
 	return ref - (x | (ch << (7 * i)));
 }
 
@@ -711,9 +719,10 @@ void AigerReader::parse_aiger_binary()
 
 	// Parse AND
 	l1 = (I+L+1) << 1;
+	std::streambuf *sb = f.rdbuf();
 	for (unsigned i = 0; i < A; ++i, ++line_count, l1 += 2) {
-		l2 = parse_next_delta_literal(f, l1);
-		l3 = parse_next_delta_literal(f, l2);
+		l2 = parse_next_delta_literal(sb, l1);
+		l3 = parse_next_delta_literal(sb, l2);
 
 		log_debug2("%d %d %d is an AND\n", l1, l2, l3);
 		log_assert(!(l1 & 1));
@@ -31,60 +31,236 @@ struct ConstEval
 {
 	RTLIL::Module *module;
 	SigMap assign_map;
-	SigMap values_map;
-	SigPool stop_signals;
-	SigSet<RTLIL::Cell*> sig2driver;
-	std::set<RTLIL::Cell*> busy;
-	std::vector<SigMap> stack;
 	RTLIL::State defaultval;
 
-	ConstEval(RTLIL::Module *module, RTLIL::State defaultval = RTLIL::State::Sm) : module(module), assign_map(module), defaultval(defaultval)
+	// Values, stop flags and drivers are kept per bit of the assign_map'ed
+	// signals, at index wire_base[wire] + offset. Every bit that gets a
+	// value is recorded on the trail, and pop() only resets the bits set
+	// since the matching push().
+	enum { BIT_SET = 1, BIT_STOP = 2 };
+	dict<RTLIL::Wire*, int> wire_base;
+	std::vector<RTLIL::State> bit_values;
+	std::vector<char> bit_flags;
+	std::vector<int> bit_driver;
+	dict<int, std::vector<int>> more_bit_drivers;
+	std::vector<int> trail, stack, stopped;
+
+	// cells in module order, so that drivers are always evaluated in the same order
+	idict<RTLIL::Cell*> cells;
+	std::vector<bool> busy;
+
+	// Views for code written against the former SigMap values_map and
+	// SigPool stop_signals members. They take assign_map'ed signals, as
+	// those members did. New code should use values(), apply_values(),
+	// set(), stop() and all_stopped().
+	struct ValuesMapView
+	{
+		ConstEval *ce;
+		ValuesMapView(ConstEval *ce) : ce(ce) { }
+		void apply(RTLIL::SigSpec &sig) const { ce->apply_values(sig); }
+		RTLIL::SigSpec operator()(RTLIL::SigSpec sig) const { ce->apply_values(sig); return sig; }
+		void add(RTLIL::SigSpec sig, RTLIL::SigSpec value) const { ce->set(sig, value.as_const()); }
+	} values_map;
+
+	struct StopSignalsView
+	{
+		ConstEval *ce;
+		StopSignalsView(ConstEval *ce) : ce(ce) { }
+		void add(RTLIL::SigSpec sig) const { ce->stop(sig); }
+		bool check(RTLIL::SigBit bit) const { return bit.wire != nullptr && (ce->bit_flags[ce->bit_index(bit)] & BIT_STOP) != 0; }
+		bool check_all(const RTLIL::SigSpec &sig) const { return ce->all_stopped(sig); }
+		bool check_any(const RTLIL::SigSpec &sig) const {
+			for (auto bit : sig)
+				if (check(bit))
+					return true;
+			return false;
+		}
+		RTLIL::SigSpec extract(const RTLIL::SigSpec &sig) const {
+			RTLIL::SigSpec result;
+			for (auto bit : sig)
+				if (check(bit))
+					result.append(bit);
+			return result;
+		}
+	} stop_signals;
+
+	ConstEval(RTLIL::Module *module, RTLIL::State defaultval = RTLIL::State::Sm) : module(module), assign_map(module), defaultval(defaultval),
+			values_map(this), stop_signals(this)
 	{
 		CellTypes ct;
 		ct.setup_internals();
 		ct.setup_stdcells();
 
+		for (auto wire : module->wires())
+			add_wire(wire);
+
 		for (auto &it : module->cells_) {
 			if (!ct.cell_known(it.second->type))
 				continue;
+			int cell_idx = cell_index(it.second);
 			for (auto &it2 : it.second->connections())
 				if (ct.cell_output(it.second->type, it2.first))
-					sig2driver.insert(assign_map(it2.second), it.second);
+					for (auto bit : assign_map(it2.second)) {
+						if (bit.wire == nullptr)
+							continue;
+						int idx = bit_index(bit);
+						if (bit_driver[idx] < 0)
+							bit_driver[idx] = cell_idx;
+						else if (bit_driver[idx] != cell_idx)
+							more_bit_drivers[idx].push_back(cell_idx);
+					}
 		}
 	}
 
+	// the views must refer to the copy and not to the original
+	ConstEval(const ConstEval &other) : module(other.module), assign_map(other.assign_map), defaultval(other.defaultval),
+			wire_base(other.wire_base), bit_values(other.bit_values), bit_flags(other.bit_flags), bit_driver(other.bit_driver),
+			more_bit_drivers(other.more_bit_drivers), trail(other.trail), stack(other.stack), stopped(other.stopped),
+			cells(other.cells), busy(other.busy), values_map(this), stop_signals(this)
+	{
+	}
+
+	ConstEval &operator=(const ConstEval &other)
+	{
+		module = other.module;
+		assign_map = other.assign_map;
+		defaultval = other.defaultval;
+		wire_base = other.wire_base;
+		bit_values = other.bit_values;
+		bit_flags = other.bit_flags;
+		bit_driver = other.bit_driver;
+		more_bit_drivers = other.more_bit_drivers;
+		trail = other.trail;
+		stack = other.stack;
+		stopped = other.stopped;
+		cells = other.cells;
+		busy = other.busy;
+		return *this;
+	}
+
+	void add_wire(RTLIL::Wire *wire)
+	{
+		int base = GetSize(bit_values);
+		wire_base[wire] = base;
+		bit_values.resize(base + wire->width, RTLIL::State::Sx);
+		bit_flags.resize(base + wire->width);
+		bit_driver.resize(base + wire->width, -1);
+	}
+
+	// index of an assign_map'ed wire bit, wires added after construction
+	// get their indices on first use
+	int bit_index(const RTLIL::SigBit &bit)
+	{
+		auto it = wire_base.find(bit.wire);
+		if (it == wire_base.end()) {
+			add_wire(bit.wire);
+			it = wire_base.find(bit.wire);
+		}
+		return it->second + bit.offset;
+	}
+
+	int cell_index(RTLIL::Cell *cell)
+	{
+		int idx = cells(cell);
+		if (idx == GetSize(busy))
+			busy.push_back(false);
+		return idx;
+	}
+
 	void clear()
 	{
-		values_map.clear();
-		stop_signals.clear();
+		while (!trail.empty()) {
+			bit_flags[trail.back()] &= ~BIT_SET;
+			trail.pop_back();
+		}
+		for (int idx : stopped)
+			bit_flags[idx] &= ~BIT_STOP;
+		stopped.clear();
+		stack.clear();
 	}
 
 	void push()
 	{
-		stack.push_back(values_map);
+		stack.push_back(GetSize(trail));
 	}
 
 	void pop()
 	{
-		values_map.swap(stack.back());
+		int mark = stack.back();
 		stack.pop_back();
+		while (GetSize(trail) > mark) {
+			bit_flags[trail.back()] &= ~BIT_SET;
+			trail.pop_back();
+		}
 	}
 
 	void set(RTLIL::SigSpec sig, RTLIL::Const value)
 	{
 		assign_map.apply(sig);
+		for (int i = 0; i < GetSize(sig); i++) {
+			RTLIL::SigBit bit = sig[i];
+			if (bit.wire == nullptr)
+				continue;
+			int idx = bit_index(bit);
+			if (bit_flags[idx] & BIT_SET) {
 #ifndef NDEBUG
-		RTLIL::SigSpec current_val = values_map(sig);
-		for (int i = 0; i < GetSize(current_val); i++)
-			log_assert(current_val[i].wire != NULL || current_val[i] == value.bits[i]);
+				log_assert(bit_values[idx] == value.bits[i]);
 #endif
-		values_map.add(sig, RTLIL::SigSpec(value));
+				continue;
+			}
+			bit_flags[idx] |= BIT_SET;
+			bit_values[idx] = value.bits[i];
+			trail.push_back(idx);
+		}
 	}
 
 	void stop(RTLIL::SigSpec sig)
 	{
 		assign_map.apply(sig);
-		stop_signals.add(sig);
+		for (auto bit : sig) {
+			if (bit.wire == nullptr)
+				continue;
+			int idx = bit_index(bit);
+			if (!(bit_flags[idx] & BIT_STOP)) {
+				bit_flags[idx] |= BIT_STOP;
+				stopped.push_back(idx);
+			}
+		}
+	}
+
+	// replace the bits of an assign_map'ed signal that have a value
+	void apply_values(RTLIL::SigSpec &sig)
+	{
+		if (sig.is_fully_const())
+			return;
+		std::vector<RTLIL::SigBit> bits = sig.bits();
+		bool changed = false;
+		for (auto &bit : bits) {
+			if (bit.wire == nullptr)
+				continue;
+			int idx = bit_index(bit);
+			if (bit_flags[idx] & BIT_SET) {
+				bit = bit_values[idx];
+				changed = true;
+			}
+		}
+		if (changed)
+			sig = bits;
+	}
+
+	RTLIL::SigSpec values(RTLIL::SigSpec sig)
+	{
+		apply_values(sig);
+		return sig;
+	}
+
+	// true if all non-constant bits of the assign_map'ed signal are stop signals
+	bool all_stopped(const RTLIL::SigSpec &sig)
+	{
+		for (auto bit : sig)
+			if (bit.wire != nullptr && !(bit_flags[bit_index(bit)] & BIT_STOP))
+				return false;
+		return true;
 	}
 
 	bool eval(RTLIL::Cell *cell, RTLIL::SigSpec &undef)
@@ -94,7 +270,7 @@ struct ConstEval
 			RTLIL::SigSpec sig_p = cell->getPort(ID(P));
 			RTLIL::SigSpec sig_g = cell->getPort(ID(G));
 			RTLIL::SigSpec sig_ci = cell->getPort(ID(CI));
-			RTLIL::SigSpec sig_co = values_map(assign_map(cell->getPort(ID(CO))));
+			RTLIL::SigSpec sig_co = values(assign_map(cell->getPort(ID(CO))));
 
 			if (sig_co.is_fully_const())
 				return true;
@@ -129,7 +305,7 @@ struct ConstEval
 		RTLIL::SigSpec sig_a, sig_b, sig_s, sig_y;
 
 		log_assert(cell->hasPort(ID::Y));
-		sig_y = values_map(assign_map(cell->getPort(ID::Y)));
+		sig_y = values(assign_map(cell->getPort(ID::Y)));
 		if (sig_y.is_fully_const())
 			return true;
 
@@ -339,38 +515,58 @@ struct ConstEval
 	bool eval(RTLIL::SigSpec &sig, RTLIL::SigSpec &undef, RTLIL::Cell *busy_cell = NULL)
 	{
 		assign_map.apply(sig);
-		values_map.apply(sig);
+		apply_values(sig);
 
 		if (sig.is_fully_const())
 			return true;
 
-		if (stop_signals.check_any(sig)) {
-			undef = stop_signals.extract(sig);
+		RTLIL::SigSpec stopped_bits;
+		std::vector<int> driver_cells;
+
+		for (auto bit : sig) {
+			if (bit.wire == nullptr)
+				continue;
+			int idx = bit_index(bit);
+			if (bit_flags[idx] & BIT_STOP)
+				stopped_bits.append(bit);
+			if (bit_driver[idx] >= 0) {
+				driver_cells.push_back(bit_driver[idx]);
+				auto it = more_bit_drivers.find(idx);
+				if (it != more_bit_drivers.end())
+					driver_cells.insert(driver_cells.end(), it->second.begin(), it->second.end());
+			}
+		}
+
+		if (!stopped_bits.empty()) {
+			undef = stopped_bits;
 			return false;
 		}
 
+		int busy_idx = -1;
 		if (busy_cell) {
-			if (busy.count(busy_cell) > 0) {
+			busy_idx = cell_index(busy_cell);
+			if (busy[busy_idx]) {
 				undef = sig;
 				return false;
 			}
-			busy.insert(busy_cell);
+			busy[busy_idx] = true;
 		}
 
-		std::set<RTLIL::Cell*> driver_cells;
-		sig2driver.find(sig, driver_cells);
-		for (auto cell : driver_cells) {
-			if (!eval(cell, undef)) {
+		std::sort(driver_cells.begin(), driver_cells.end());
+		driver_cells.erase(std::unique(driver_cells.begin(), driver_cells.end()), driver_cells.end());
+
+		for (int cell_idx : driver_cells) {
+			if (!eval(cells[cell_idx], undef)) {
 				if (busy_cell)
-					busy.erase(busy_cell);
+					busy[busy_idx] = false;
 				return false;
 			}
 		}
 
 		if (busy_cell)
-			busy.erase(busy_cell);
+			busy[busy_idx] = false;
 
-		values_map.apply(sig);
+		apply_values(sig);
 		if (sig.is_fully_const())
 			return true;
 
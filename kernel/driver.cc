@@ -19,6 +19,7 @@
 
 #include "kernel/yosys.h"
 #include "libs/sha1/sha1.h"
+#include "kernel/log_trace.h"
 
 #ifdef YOSYS_ENABLE_READLINE
 #  include <readline/readline.h>
@@ -190,6 +191,7 @@ int main(int argc, char **argv)
 	std::string output_filename = "";
 	std::string scriptfile = "";
 	std::string depsfile = "";
+	std::string tracefile = "";
 	bool scriptfile_tcl = false;
 	bool got_output_filename = false;
 	bool print_banner = true;
@@ -296,6 +298,10 @@ int main(int argc, char **argv)
 		printf("    -E <depsfile>\n");
 		printf("        write a Makefile dependencies file with in- and output file names\n");
 		printf("\n");
+		printf("    -J <tracefile>\n");
+		printf("        write a trace of all executed commands and script labels in the\n");
+		printf("        Chrome trace-event JSON format (for chrome://tracing or Perfetto)\n");
+		printf("\n");
 		printf("    -g\n");
 		printf("        globally enable debug log messages\n");
 		printf("\n");
@@ -319,7 +325,7 @@ int main(int argc, char **argv)
 	}
 
 	int opt;
-	while ((opt = getopt(argc, argv, "MXAQTVSgm:f:Hh:b:o:p:l:L:qv:tds:c:W:w:e:D:P:E:")) != -1)
+	while ((opt = getopt(argc, argv, "MXAQTVSgm:f:Hh:b:o:p:l:L:qv:tds:c:W:w:e:D:P:E:J:")) != -1)
 	{
 		switch (opt)
 		{
@@ -378,6 +384,8 @@ int main(int argc, char **argv)
 			}
 			if (opt == 'L')
 				setvbuf(log_files.back(), NULL, _IOLBF, 0);
+			else
+				setvbuf(log_files.back(), NULL, _IOFBF, 1 << 16);
 			break;
 		case 'q':
 			mode_q = true;
@@ -405,22 +413,13 @@ int main(int argc, char **argv)
 			scriptfile_tcl = true;
 			break;
 		case 'W':
-			log_warn_regexes.push_back(std::regex(optarg,
-					std::regex_constants::nosubs |
-					std::regex_constants::optimize |
-					std::regex_constants::egrep));
+			log_add_regex(log_warn_regexes, optarg);
 			break;
 		case 'w':
-			log_nowarn_regexes.push_back(std::regex(optarg,
-					std::regex_constants::nosubs |
-					std::regex_constants::optimize |
-					std::regex_constants::egrep));
+			log_add_regex(log_nowarn_regexes, optarg);
 			break;
 		case 'e':
-			log_werror_regexes.push_back(std::regex(optarg,
-					std::regex_constants::nosubs |
-					std::regex_constants::optimize |
-					std::regex_constants::egrep));
+			log_add_regex(log_werror_regexes, optarg);
 			break;
 		case 'D':
 			vlog_defines.push_back(optarg);
@@ -450,6 +449,9 @@ int main(int argc, char **argv)
 		case 'E':
 			depsfile = optarg;
 			break;
+		case 'J':
+			tracefile = optarg;
+			break;
 		default:
 			fprintf(stderr, "Run '%s -h' for help.\n", argv[0]);
 			exit(1);
@@ -461,6 +463,9 @@ int main(int argc, char **argv)
 		log_error_stderr = true;
 	}
 
+	if (!tracefile.empty())
+		log_trace_open(tracefile);
+
 	if (print_banner)
 		yosys_banner();
 
@@ -661,6 +666,8 @@ int main(int argc, char **argv)
 	}
 #endif
 
+	log_trace_close();
+
 	yosys_atexit();
 
 	memhasher_off();
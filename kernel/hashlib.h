@@ -36,6 +36,23 @@ inline unsigned int mkhash_add(unsigned int a, unsigned int b) {
 	return ((a << 5) + a) + b;
 }
 
+// 64 bit mixing function (the MurmurHash3 finalizer), folded to the 32 bit
+// hash type. Unlike the DJB2 steps above it spreads small differences in any
+// input bit over the whole result, so it is used for fixed-size keys with
+// little entropy in the low bits: pointers, (object, offset) pairs, 64 bit ints.
+inline unsigned int mkhash_mix(uint64_t a) {
+	a ^= a >> 33;
+	a *= 0xff51afd7ed558ccdULL;
+	a ^= a >> 33;
+	a *= 0xc4ceb9fe1a85ec53ULL;
+	a ^= a >> 33;
+	return (unsigned int)(a ^ (a >> 32));
+}
+
+inline unsigned int mkhash_mix(unsigned int a, unsigned int b) {
+	return mkhash_mix((uint64_t(a) << 32) | b);
+}
+
 inline unsigned int mkhash_xorshift(unsigned int a) {
 	if (sizeof(a) == 4) {
 		a ^= a << 13;
@@ -75,7 +92,7 @@ template<> struct hash_ops<int32_t> : hash_int_ops
 template<> struct hash_ops<int64_t> : hash_int_ops
 {
 	static inline unsigned int hash(int64_t a) {
-		return mkhash((unsigned int)(a), (unsigned int)(a >> 32));
+		return mkhash_mix(a);
 	}
 };
 
@@ -88,7 +105,7 @@ template<> struct hash_ops<uint32_t> : hash_int_ops
 template<> struct hash_ops<uint64_t> : hash_int_ops
 {
     static inline unsigned int hash(uint64_t a) {
-        return mkhash((unsigned int)(a), (unsigned int)(a >> 32));
+        return mkhash_mix(a);
     }
 };
 
@@ -110,7 +127,7 @@ template<typename P, typename Q> struct hash_ops<std::pair<P, Q>> {
 		return a == b;
 	}
 	static inline unsigned int hash(std::pair<P, Q> a) {
-		return mkhash(hash_ops<P>::hash(a.first), hash_ops<Q>::hash(a.second));
+		return mkhash_mix(hash_ops<P>::hash(a.first), hash_ops<Q>::hash(a.second));
 	}
 };
 
@@ -125,7 +142,7 @@ template<typename... T> struct hash_ops<std::tuple<T...>> {
 	template<size_t I = 0>
 	static inline typename std::enable_if<I != sizeof...(T), unsigned int>::type hash(std::tuple<T...> a) {
 		typedef hash_ops<typename std::tuple_element<I, std::tuple<T...>>::type> element_ops_t;
-		return mkhash(hash<I+1>(a), element_ops_t::hash(std::get<I>(a)));
+		return mkhash_mix(hash<I+1>(a), element_ops_t::hash(std::get<I>(a)));
 	}
 };
 
@@ -161,7 +178,7 @@ struct hash_ptr_ops {
 		return a == b;
 	}
 	static inline unsigned int hash(const void *a) {
-		return (uintptr_t)a;
+		return mkhash_mix((uintptr_t)a);
 	}
 };
 
@@ -205,6 +222,32 @@ inline int hashtable_size(int min_size)
 	throw std::length_error("hash table exceeded maximum size.");
 }
 
+// By default dict<> and pool<> resolve collisions by chaining: the hashtable
+// holds the first entry of each bucket and entry_t::next links the rest. With
+// open addressing the hashtable holds the entry indices directly (linear
+// probing) and entry_t::next caches the full hash of the key, so that probing
+// rarely needs to compare keys and rehashing does not need to hash them again.
+// The layout does not change the API or the iteration order.
+//
+// Open addressing can be selected globally with -DHASHLIB_OPEN_ADDRESSING, or
+// for a single hash_ops type by specializing hash_layout<OPS>.
+//
+// A dict<> with at most hash_layout<OPS>::small_size entries does not allocate
+// a hashtable at all and finds its keys by a linear search of the entries.
+// This is meant for key types with a cheap comparison that are mostly used
+// in many small dicts, like the ports, parameters and attributes of cells.
+
+#ifdef HASHLIB_OPEN_ADDRESSING
+const bool hashtable_open_addressing = true;
+#else
+const bool hashtable_open_addressing = false;
+#endif
+
+template<typename OPS> struct hash_layout {
+	static const bool open_addressing = hashtable_open_addressing;
+	static const int small_size = 0;
+};
+
 template<typename K, typename T, typename OPS = hash_ops<K>> class dict;
 template<typename K, int offset = 0, typename OPS = hash_ops<K>> class idict;
 template<typename K, typename OPS = hash_ops<K>> class pool;
@@ -235,19 +278,63 @@ class dict
 	}
 #endif
 
+	static const bool open_addressing = hash_layout<OPS>::open_addressing;
+	static const int small_size = hash_layout<OPS>::small_size;
+
+	// chaining: bucket index, open addressing: full hash of the key
 	int do_hash(const K &key) const
 	{
+		if (open_addressing)
+			return ops.hash(key);
 		unsigned int hash = 0;
 		if (!hashtable.empty())
 			hash = ops.hash(key) % (unsigned int)(hashtable.size());
 		return hash;
 	}
 
+	int do_slot(int hash) const
+	{
+		return (unsigned int)hash % (unsigned int)(hashtable.size());
+	}
+
+	// slot holding the given entry (open addressing)
+	int do_find_slot(int index) const
+	{
+		int slot = do_slot(entries[index].next);
+		while (hashtable[slot] != index) {
+			do_assert(hashtable[slot] >= 0);
+			if (++slot == int(hashtable.size()))
+				slot = 0;
+		}
+		return slot;
+	}
+
+	// put the given entry into the first free slot (open addressing)
+	void do_place(int index)
+	{
+		int slot = do_slot(entries[index].next);
+		while (hashtable[slot] >= 0)
+			if (++slot == int(hashtable.size()))
+				slot = 0;
+		hashtable[slot] = index;
+	}
+
 	void do_rehash()
 	{
+		if (int(entries.size()) <= small_size) {
+			std::vector<int>().swap(hashtable);
+			return;
+		}
+
 		hashtable.clear();
 		hashtable.resize(hashtable_size(entries.capacity() * hashtable_size_factor), -1);
 
+		if (open_addressing) {
+			for (int i = 0; i < int(entries.size()); i++)
+				do_place(i);
+			return;
+		}
+
 		for (int i = 0; i < int(entries.size()); i++) {
 			do_assert(-1 <= entries[i].next && entries[i].next < int(entries.size()));
 			int hash = do_hash(entries[i].udata.first);
@@ -256,12 +343,55 @@ class dict
 		}
 	}
 
+	int do_erase_open(int index)
+	{
+		// free the slot and move back all following entries of the probe
+		// run that could not be found anymore otherwise
+		int n = hashtable.size();
+		int hole = do_find_slot(index);
+
+		for (int slot = hole + 1 == n ? 0 : hole + 1; hashtable[slot] >= 0; slot = slot + 1 == n ? 0 : slot + 1) {
+			int home = do_slot(entries[hashtable[slot]].next);
+			bool reachable = hole < slot ? (hole < home && home <= slot) : (hole < home || home <= slot);
+			if (!reachable) {
+				hashtable[hole] = hashtable[slot];
+				hole = slot;
+			}
+		}
+		hashtable[hole] = -1;
+
+		int back_idx = entries.size()-1;
+
+		if (index != back_idx) {
+			hashtable[do_find_slot(back_idx)] = index;
+			entries[index] = std::move(entries[back_idx]);
+		}
+
+		entries.pop_back();
+
+		if (entries.empty())
+			hashtable.clear();
+
+		return 1;
+	}
+
 	int do_erase(int index, int hash)
 	{
 		do_assert(index < int(entries.size()));
-		if (hashtable.empty() || index < 0)
+		if (index < 0)
 			return 0;
 
+		if (hashtable.empty()) {
+			int back_idx = entries.size()-1;
+			if (index != back_idx)
+				entries[index] = std::move(entries[back_idx]);
+			entries.pop_back();
+			return 1;
+		}
+
+		if (open_addressing)
+			return do_erase_open(index);
+
 		int k = hashtable[hash];
 		do_assert(0 <= k && k < int(entries.size()));
 
@@ -307,12 +437,29 @@ class dict
 
 	int do_lookup(const K &key, int &hash) const
 	{
-		if (hashtable.empty())
+		// without a hashtable there are at most small_size entries
+		if (hashtable.empty()) {
+			for (int index = 0; index < int(entries.size()); index++)
+				if ((!open_addressing || entries[index].next == hash) && ops.cmp(entries[index].udata.first, key))
+					return index;
 			return -1;
+		}
 
 		if (entries.size() * hashtable_size_trigger > hashtable.size()) {
 			((dict*)this)->do_rehash();
-			hash = do_hash(key);
+			if (!open_addressing)
+				hash = do_hash(key);
+		}
+
+		if (open_addressing) {
+			int slot = do_slot(hash);
+			while (1) {
+				int index = hashtable[slot];
+				if (index < 0 || (entries[index].next == hash && ops.cmp(entries[index].udata.first, key)))
+					return index;
+				if (++slot == int(hashtable.size()))
+					slot = 0;
+			}
 		}
 
 		int index = hashtable[hash];
@@ -327,6 +474,15 @@ class dict
 
 	int do_insert(K key, int &hash)
 	{
+		if (open_addressing) {
+			entries.push_back(entry_t(std::pair<K, T>(std::move(key), T()), hash));
+			if (entries.size() * hashtable_size_trigger > hashtable.size())
+				do_rehash();
+			else
+				do_place(entries.size() - 1);
+			return entries.size() - 1;
+		}
+
 		if (hashtable.empty()) {
 			entries.push_back(entry_t(std::pair<K, T>(std::move(key), T()), -1));
 			do_rehash();
@@ -340,6 +496,15 @@ class dict
 
 	int do_insert(std::pair<K, T> value, int &hash)
 	{
+		if (open_addressing) {
+			entries.push_back(entry_t(std::move(value), hash));
+			if (entries.size() * hashtable_size_trigger > hashtable.size())
+				do_rehash();
+			else
+				do_place(entries.size() - 1);
+			return entries.size() - 1;
+		}
+
 		if (hashtable.empty()) {
 			entries.push_back(entry_t(std::move(value), -1));
 			do_rehash();
@@ -612,19 +777,57 @@ protected:
 	}
 #endif
 
+	static const bool open_addressing = hash_layout<OPS>::open_addressing;
+
+	// chaining: bucket index, open addressing: full hash of the key
 	int do_hash(const K &key) const
 	{
+		if (open_addressing)
+			return ops.hash(key);
 		unsigned int hash = 0;
 		if (!hashtable.empty())
 			hash = ops.hash(key) % (unsigned int)(hashtable.size());
 		return hash;
 	}
 
+	int do_slot(int hash) const
+	{
+		return (unsigned int)hash % (unsigned int)(hashtable.size());
+	}
+
+	// slot holding the given entry (open addressing)
+	int do_find_slot(int index) const
+	{
+		int slot = do_slot(entries[index].next);
+		while (hashtable[slot] != index) {
+			do_assert(hashtable[slot] >= 0);
+			if (++slot == int(hashtable.size()))
+				slot = 0;
+		}
+		return slot;
+	}
+
+	// put the given entry into the first free slot (open addressing)
+	void do_place(int index)
+	{
+		int slot = do_slot(entries[index].next);
+		while (hashtable[slot] >= 0)
+			if (++slot == int(hashtable.size()))
+				slot = 0;
+		hashtable[slot] = index;
+	}
+
 	void do_rehash()
 	{
 		hashtable.clear();
 		hashtable.resize(hashtable_size(entries.capacity() * hashtable_size_factor), -1);
 
+		if (open_addressing) {
+			for (int i = 0; i < int(entries.size()); i++)
+				do_place(i);
+			return;
+		}
+
 		for (int i = 0; i < int(entries.size()); i++) {
 			do_assert(-1 <= entries[i].next && entries[i].next < int(entries.size()));
 			int hash = do_hash(entries[i].udata);
@@ -633,12 +836,47 @@ protected:
 		}
 	}
 
+	int do_erase_open(int index)
+	{
+		// free the slot and move back all following entries of the probe
+		// run that could not be found anymore otherwise
+		int n = hashtable.size();
+		int hole = do_find_slot(index);
+
+		for (int slot = hole + 1 == n ? 0 : hole + 1; hashtable[slot] >= 0; slot = slot + 1 == n ? 0 : slot + 1) {
+			int home = do_slot(entries[hashtable[slot]].next);
+			bool reachable = hole < slot ? (hole < home && home <= slot) : (hole < home || home <= slot);
+			if (!reachable) {
+				hashtable[hole] = hashtable[slot];
+				hole = slot;
+			}
+		}
+		hashtable[hole] = -1;
+
+		int back_idx = entries.size()-1;
+
+		if (index != back_idx) {
+			hashtable[do_find_slot(back_idx)] = index;
+			entries[index] = std::move(entries[back_idx]);
+		}
+
+		entries.pop_back();
+
+		if (entries.empty())
+			hashtable.clear();
+
+		return 1;
+	}
+
 	int do_erase(int index, int hash)
 	{
 		do_assert(index < int(entries.size()));
 		if (hashtable.empty() || index < 0)
 			return 0;
 
+		if (open_addressing)
+			return do_erase_open(index);
+
 		int k = hashtable[hash];
 		if (k == index) {
 			hashtable[hash] = entries[index].next;
@@ -685,7 +923,19 @@ protected:
 
 		if (entries.size() * hashtable_size_trigger > hashtable.size()) {
 			((pool*)this)->do_rehash();
-			hash = do_hash(key);
+			if (!open_addressing)
+				hash = do_hash(key);
+		}
+
+		if (open_addressing) {
+			int slot = do_slot(hash);
+			while (1) {
+				int index = hashtable[slot];
+				if (index < 0 || (entries[index].next == hash && ops.cmp(entries[index].udata, key)))
+					return index;
+				if (++slot == int(hashtable.size()))
+					slot = 0;
+			}
 		}
 
 		int index = hashtable[hash];
@@ -700,6 +950,15 @@ protected:
 
 	int do_insert(const K &value, int &hash)
 	{
+		if (open_addressing) {
+			entries.push_back(entry_t(value, hash));
+			if (entries.size() * hashtable_size_trigger > hashtable.size())
+				do_rehash();
+			else
+				do_place(entries.size() - 1);
+			return entries.size() - 1;
+		}
+
 		if (hashtable.empty()) {
 			entries.push_back(entry_t(value, -1));
 			do_rehash();
@@ -60,6 +60,62 @@ void pass_finished() {
     }
 }
 
+FILE *log_trace_file = nullptr;
+static bool log_trace_first_event;
+static std::chrono::steady_clock::time_point log_trace_start;
+
+static std::string log_trace_json_str(const std::string &str)
+{
+	std::string res = "\"";
+	for (char c : str) {
+		if (c == '"' || c == '\\')
+			res += '\\';
+		if ((unsigned char)c < 0x20)
+			res += stringf("\\u%04x", c);
+		else
+			res += c;
+	}
+	return res + "\"";
+}
+
+void log_trace_open(const std::string &filename)
+{
+	log_trace_close();
+	log_trace_file = fopen(filename.c_str(), "w");
+	if (log_trace_file == nullptr)
+		log_error("Can't open trace file `%s' for writing: %s\n", filename.c_str(), strerror(errno));
+	yosys_output_files.insert(filename);
+	log_trace_first_event = true;
+	log_trace_start = std::chrono::steady_clock::now();
+	fputs("[", log_trace_file);
+}
+
+void log_trace_close()
+{
+	if (log_trace_file == nullptr)
+		return;
+	fputs("\n]\n", log_trace_file);
+	fclose(log_trace_file);
+	log_trace_file = nullptr;
+}
+
+void log_trace_event(char phase, const std::string &name, const char *category, RTLIL::Module *module)
+{
+	double ts = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - log_trace_start).count();
+
+	std::string str = stringf("%s\n{\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":1", log_trace_first_event ? "" : ",", phase, ts);
+	if (!name.empty())
+		str += ",\"name\":" + log_trace_json_str(name);
+	if (category != nullptr)
+		str += stringf(",\"cat\":\"%s\"", category);
+	if (module != nullptr)
+		str += ",\"args\":{\"module\":" + log_trace_json_str(log_id(module)) + "}";
+	str += "}";
+
+	fwrite(str.data(), 1, str.size(), log_trace_file);
+	log_trace_first_event = false;
+}
+
 std::vector<FILE*> log_files;
 std::vector<std::ostream*> log_streams;
 std::map<std::string, std::set<std::string>> log_hdump;
@@ -119,6 +175,40 @@ int gettimeofday(struct timeval *tv, struct timezone *tz)
 }
 #endif
 
+// Each of the -W/-w/-e lists is also kept as a single alternation of all its
+// patterns, so that a message is scanned only once per list. Regexes that are
+// added to the lists directly (without log_add_regex) fall back to matching
+// them one by one.
+static std::map<const std::vector<std::regex>*, pair<int, std::regex>> log_combined_regexes;
+static std::map<const std::vector<std::regex>*, std::string> log_combined_patterns;
+
+void log_add_regex(std::vector<std::regex> &list, const std::string &pattern)
+{
+	auto flags = std::regex_constants::nosubs | std::regex_constants::optimize | std::regex_constants::egrep;
+	list.push_back(std::regex(pattern, flags));
+
+	if (GetSize(list) == 1 || log_combined_regexes.count(&list)) {
+		std::string &combined = log_combined_patterns[&list];
+		combined += (combined.empty() ? "(" : "|(") + pattern + ")";
+		log_combined_regexes[&list] = pair<int, std::regex>(GetSize(list), std::regex(combined, flags));
+	}
+}
+
+static bool log_regex_search(const std::vector<std::regex> &list, const std::string &str)
+{
+	if (list.empty())
+		return false;
+
+	auto it = log_combined_regexes.find(&list);
+	if (it != log_combined_regexes.end() && it->second.first == GetSize(list))
+		return std::regex_search(str, it->second.second);
+
+	for (auto &re : list)
+		if (std::regex_search(str, re))
+			return true;
+	return false;
+}
+
 void logv(const char *format, va_list ap)
 {
 	while (format[0] == '\n' && format[1] != 0) {
@@ -129,6 +219,23 @@ void logv(const char *format, va_list ap)
 	if (log_make_debug && !ys_debug(1))
 		return;
 
+	// Nobody is listening (e.g. "yosys -q"): skip formatting the message,
+	// only keep track of the trailing newlines for log_spacer().
+	if (log_files.empty() && log_streams.empty() && log_hasher == nullptr && log_warn_regexes.empty())
+	{
+		int len = strlen(format);
+		if (len == 0)
+			return;
+		int nnl_pos = len-1;
+		while (nnl_pos >= 0 && format[nnl_pos] == '\n')
+			nnl_pos--;
+		if (nnl_pos < 0)
+			log_newline_count += len;
+		else
+			log_newline_count = len - nnl_pos - 1;
+		return;
+	}
+
 	std::string str = vstringf(format, ap);
 
 	if (str.empty())
@@ -166,14 +273,14 @@ void logv(const char *format, va_list ap)
 			next_print_log = true;
 
 		for (auto f : log_files)
-			fputs(time_str.c_str(), f);
+			fwrite(time_str.data(), 1, time_str.size(), f);
 
 		for (auto f : log_streams)
 			*f << time_str;
 	}
 
 	for (auto f : log_files)
-		fputs(str.c_str(), f);
+		fwrite(str.data(), 1, str.size(), f);
 
 	for (auto f : log_streams)
 		*f << str;
@@ -194,9 +301,8 @@ void logv(const char *format, va_list ap)
 			linebuffer += str;
 
 			if (!linebuffer.empty() && linebuffer.back() == '\n') {
-				for (auto &re : log_warn_regexes)
-					if (std::regex_search(linebuffer, re))
-						log_warning("Found log message matching -W regex:\n%s", str.c_str());
+				if (log_regex_search(log_warn_regexes, linebuffer))
+					log_warning("Found log message matching -W regex:\n%s", str.c_str());
 				linebuffer.clear();
 			}
 		}
@@ -270,11 +376,7 @@ static void logv_warning_with_prefix(const char *prefix,
                                      const char *format, va_list ap)
 {
 	std::string message = vstringf(format, ap);
-	bool suppressed = false;
-
-	for (auto &re : log_nowarn_regexes)
-		if (std::regex_search(message, re))
-			suppressed = true;
+	bool suppressed = log_regex_search(log_nowarn_regexes, message);
 
 	if (suppressed)
 	{
@@ -285,9 +387,8 @@ static void logv_warning_with_prefix(const char *prefix,
 		int bak_log_make_debug = log_make_debug;
 		log_make_debug = 0;
 
-		for (auto &re : log_werror_regexes)
-			if (std::regex_search(message, re))
-				log_error("%s",  message.c_str());
+		if (log_regex_search(log_werror_regexes, message))
+			log_error("%s",  message.c_str());
 
 		if (log_warnings.count(message))
 		{
@@ -369,6 +470,10 @@ static void logv_error_with_prefix(const char *prefix,
 	log("%s%s", prefix, log_last_error.c_str());
 	log_flush();
 
+	// the closing bracket is optional in the trace-event format
+	if (log_trace_file != nullptr)
+		fflush(log_trace_file);
+
 	log_make_debug = bak_log_make_debug;
 
 	if (log_error_atexit)
@@ -649,6 +754,21 @@ const char *log_const(const RTLIL::Const &value, bool autoint)
 	}
 }
 
+const char *log_deferred_arg(RTLIL::IdString id)
+{
+	return log_id(id);
+}
+
+const char *log_deferred_arg(const RTLIL::SigBit &bit)
+{
+	return log_signal(bit);
+}
+
+const char *log_deferred_arg(const RTLIL::SigSpec &sig)
+{
+	return log_signal(sig);
+}
+
 const char *log_id(RTLIL::IdString str)
 {
 	log_id_cache.push_back(strdup(str.c_str()));
@@ -136,6 +136,9 @@ void log_backtrace(const char *prefix, int levels);
 void log_reset_stack();
 void log_flush();
 
+// add a pattern to log_warn_regexes, log_nowarn_regexes or log_werror_regexes
+void log_add_regex(std::vector<std::regex> &list, const std::string &pattern);
+
 const char *log_signal(const RTLIL::SigSpec &sig, bool autoint = true);
 const char *log_const(const RTLIL::Const &value, bool autoint = true);
 const char *log_id(RTLIL::IdString id);
@@ -150,6 +153,92 @@ void log_module(RTLIL::Module *module, std::string indent = "");
 void log_cell(RTLIL::Cell *cell, std::string indent = "");
 void log_wire(RTLIL::Wire *wire, std::string indent = "");
 
+// ---------------------------------------------------
+// Deferred messages: log_defer() captures the format string and a copy of
+// the arguments, str() formats them. IdStrings, signals and named RTLIL
+// objects are formatted as with log_id() and log_signal(), but only when
+// the message is actually used, so diagnostics for rare cases can be
+// prepared in hot loops.
+// ---------------------------------------------------
+
+const char *log_deferred_arg(RTLIL::IdString id);
+const char *log_deferred_arg(const RTLIL::SigBit &bit);
+const char *log_deferred_arg(const RTLIL::SigSpec &sig);
+static inline const char *log_deferred_arg(const std::string &str) { return str.c_str(); }
+static inline const char *log_deferred_arg(const char *str) { return str; }
+
+template<typename T> static inline const char *log_deferred_arg(T *obj) {
+	return log_id(obj, "(null)");
+}
+
+template<typename T> static inline typename std::enable_if<std::is_arithmetic<T>::value, T>::type log_deferred_arg(T value) {
+	return value;
+}
+
+template<int... I> struct LogDeferredIndices { };
+template<int N, int... I> struct LogDeferredIndicesGen : LogDeferredIndicesGen<N-1, N-1, I...> { };
+template<int... I> struct LogDeferredIndicesGen<0, I...> { typedef LogDeferredIndices<I...> type; };
+
+struct LogDeferred
+{
+	struct Message {
+		virtual ~Message() { }
+		virtual std::string str() const = 0;
+	};
+
+	template<typename... Args> struct MessageImpl : Message
+	{
+		const char *format;
+		std::tuple<Args...> args;
+
+		MessageImpl(const char *format, const Args&... args) : format(format), args(args...) { }
+
+		template<int... I> std::string str_worker(LogDeferredIndices<I...>) const {
+			return stringf(format, log_deferred_arg(std::get<I>(args))...);
+		}
+
+		std::string str() const YS_OVERRIDE {
+			return str_worker(typename LogDeferredIndicesGen<sizeof...(Args)>::type());
+		}
+	};
+
+	std::shared_ptr<const Message> msg;
+
+	std::string str() const { return msg->str(); }
+};
+
+// the format string must outlive the message (usually it is a literal)
+template<typename... Args> LogDeferred log_defer(const char *format, const Args&... args)
+{
+	LogDeferred deferred;
+	deferred.msg = std::make_shared<LogDeferred::MessageImpl<Args...>>(format, args...);
+	return deferred;
+}
+
+#ifdef __GNUC__
+// Let the compiler check the format string against the formatted arguments,
+// as it does for log(). The check is never executed. Up to 9 arguments.
+static inline void log_defer_check(const char *format, ...) YS_ATTRIBUTE(format(printf, 1, 2));
+static inline void log_defer_check(const char*, ...) { }
+
+#  define YS_LOG_DEFER_A(_a_) , YOSYS_NAMESPACE_PREFIX log_deferred_arg(_a_)
+#  define YS_LOG_DEFER_1(_f_) _f_
+#  define YS_LOG_DEFER_2(_f_, _1_) _f_ YS_LOG_DEFER_A(_1_)
+#  define YS_LOG_DEFER_3(_f_, _1_, _2_) YS_LOG_DEFER_2(_f_, _1_) YS_LOG_DEFER_A(_2_)
+#  define YS_LOG_DEFER_4(_f_, _1_, _2_, _3_) YS_LOG_DEFER_3(_f_, _1_, _2_) YS_LOG_DEFER_A(_3_)
+#  define YS_LOG_DEFER_5(_f_, _1_, _2_, _3_, _4_) YS_LOG_DEFER_4(_f_, _1_, _2_, _3_) YS_LOG_DEFER_A(_4_)
+#  define YS_LOG_DEFER_6(_f_, _1_, _2_, _3_, _4_, _5_) YS_LOG_DEFER_5(_f_, _1_, _2_, _3_, _4_) YS_LOG_DEFER_A(_5_)
+#  define YS_LOG_DEFER_7(_f_, _1_, _2_, _3_, _4_, _5_, _6_) YS_LOG_DEFER_6(_f_, _1_, _2_, _3_, _4_, _5_) YS_LOG_DEFER_A(_6_)
+#  define YS_LOG_DEFER_8(_f_, _1_, _2_, _3_, _4_, _5_, _6_, _7_) YS_LOG_DEFER_7(_f_, _1_, _2_, _3_, _4_, _5_, _6_) YS_LOG_DEFER_A(_7_)
+#  define YS_LOG_DEFER_9(_f_, _1_, _2_, _3_, _4_, _5_, _6_, _7_, _8_) YS_LOG_DEFER_8(_f_, _1_, _2_, _3_, _4_, _5_, _6_, _7_) YS_LOG_DEFER_A(_8_)
+#  define YS_LOG_DEFER_10(_f_, _1_, _2_, _3_, _4_, _5_, _6_, _7_, _8_, _9_) YS_LOG_DEFER_9(_f_, _1_, _2_, _3_, _4_, _5_, _6_, _7_, _8_) YS_LOG_DEFER_A(_9_)
+#  define YS_LOG_DEFER_SELECT(_1_, _2_, _3_, _4_, _5_, _6_, _7_, _8_, _9_, _10_, _n_, ...) _n_
+#  define YS_LOG_DEFER_ARGS(...) YS_LOG_DEFER_SELECT(__VA_ARGS__, YS_LOG_DEFER_10, YS_LOG_DEFER_9, YS_LOG_DEFER_8, YS_LOG_DEFER_7, \
+		YS_LOG_DEFER_6, YS_LOG_DEFER_5, YS_LOG_DEFER_4, YS_LOG_DEFER_3, YS_LOG_DEFER_2, YS_LOG_DEFER_1, _)(__VA_ARGS__)
+#  define log_defer(...) (false ? YOSYS_NAMESPACE_PREFIX log_defer_check(YS_LOG_DEFER_ARGS(__VA_ARGS__)) : (void)0, \
+		YOSYS_NAMESPACE_PREFIX log_defer(__VA_ARGS__))
+#endif
+
 #ifndef NDEBUG
 static inline void log_assert_worker(bool cond, const char *expr, const char *file, int line) {
 	if (!cond) log_error("Assert `%s' failed in %s:%d.\n", expr, file, line);
@@ -13,6 +13,38 @@ YOSYS_NAMESPACE_BEGIN
 
     void log_set_callbacks(HeaderFunc header, LevelFunc push, LevelFunc pop, LevelFunc finishPass);
     void pass_finished();
+
+    // Event trace in Chrome trace-event JSON format (chrome://tracing, Perfetto).
+    // Spans are recorded as nested begin/end events. When no trace file is
+    // open, all of this reduces to a single pointer check.
+    extern FILE *log_trace_file;
+
+    void log_trace_open(const std::string &filename);
+    void log_trace_close();
+    void log_trace_event(char phase, const std::string &name, const char *category, RTLIL::Module *module);
+
+    static inline void log_trace_begin(const std::string &name, const char *category, RTLIL::Module *module = nullptr) {
+        if (log_trace_file != nullptr)
+            log_trace_event('B', name, category, module);
+    }
+
+    static inline void log_trace_end() {
+        if (log_trace_file != nullptr)
+            log_trace_event('E', std::string(), nullptr, nullptr);
+    }
+
+    struct LogTraceSpan {
+        bool active;
+        LogTraceSpan(const std::string &name, RTLIL::Module *module = nullptr, const char *category = "phase") :
+                active(log_trace_file != nullptr) {
+            if (active)
+                log_trace_event('B', name, category, module);
+        }
+        ~LogTraceSpan() {
+            if (active)
+                log_trace_end();
+        }
+    };
 YOSYS_NAMESPACE_END
 
 #endif //LOG_TRACE_H
@@ -49,7 +49,7 @@ struct ModIndex : public RTLIL::Monitor
 		}
 
 		unsigned int hash() const {
-			return mkhash_add(mkhash(cell->name.hash(), port.hash()), offset);
+			return mkhash_mix(mkhash(cell->hashidx_, port.hash()), offset);
 		}
 	};
 
@@ -74,7 +74,7 @@ struct ModIndex : public RTLIL::Monitor
 
 	SigMap sigmap;
 	RTLIL::Module *module;
-	std::map<RTLIL::SigBit, SigBitInfo> database;
+	dict<RTLIL::SigBit, SigBitInfo> database;
 	int auto_reload_counter;
 	bool auto_reload_module;
 
@@ -284,13 +284,20 @@ struct ModIndex : public RTLIL::Monitor
 			reload_module();
 		}
 
-		for (auto &it : database) {
-			log("BIT %s:\n", log_signal(it.first));
-			if (it.second.is_input)
+		// database is hashed, sort the bits so that dumps can be diffed
+		std::vector<RTLIL::SigBit> bits;
+		for (auto &it : database)
+			bits.push_back(it.first);
+		std::sort(bits.begin(), bits.end());
+
+		for (auto &bit : bits) {
+			auto &info = database.at(bit);
+			log("BIT %s:\n", log_signal(bit));
+			if (info.is_input)
 				log("  PRIMARY INPUT\n");
-			if (it.second.is_output)
+			if (info.is_output)
 				log("  PRIMARY OUTPUT\n");
-			for (auto &port : it.second.ports)
+			for (auto &port : info.ports)
 				log("  PORT: %s.%s[%d] (%s)\n", log_id(port.cell),
 						log_id(port.port), port.offset, log_id(port.cell->type));
 		}
@@ -318,7 +325,7 @@ struct ModWalker
 		}
 
 		unsigned int hash() const {
-			return mkhash_add(mkhash(cell->name.hash(), port.hash()), offset);
+			return mkhash_mix(mkhash(cell->hashidx_, port.hash()), offset);
 		}
 	};
 
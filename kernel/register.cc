@@ -297,6 +297,7 @@ void Pass::call(RTLIL::Design *design, std::vector<std::string> args)
 		log_cmd_error("No such command: %s (type 'help' for a command overview)\n", args[0].c_str());
 
 	size_t orig_sel_stack_pos = design->selection_stack.size();
+	LogTraceSpan trace_span(pass_register[args[0]]->pass_name, nullptr, "pass");
 	auto state = pass_register[args[0]]->pre_execute();
 	pass_register[args[0]]->execute(args, design);
 	pass_register[args[0]]->post_execute(state);
@@ -372,6 +373,11 @@ bool ScriptPass::check_label(std::string label, std::string info)
 			if (label == active_run_to)
 				block_active = false;
 		}
+		if (label_traced)
+			log_trace_end();
+		if (block_active)
+			log_trace_begin(pass_name + ":" + label, "label");
+		label_traced = block_active && log_trace_file != nullptr;
 		return block_active;
 	}
 }
@@ -396,6 +402,18 @@ void ScriptPass::run_script(RTLIL::Design *design, std::string run_from, std::st
 	block_active = run_from.empty();
 	active_run_from = run_from;
 	active_run_to = run_to;
+	label_traced = false;
+
+	// closes the span of the last label, also when the script throws
+	struct LabelTraceGuard {
+		ScriptPass *pass;
+		~LabelTraceGuard() {
+			if (pass->label_traced)
+				log_trace_end();
+			pass->label_traced = false;
+		}
+	} label_guard = { this };
+
 	script();
 }
 
@@ -435,6 +453,7 @@ void Frontend::execute(std::vector<std::string> args, RTLIL::Design *design)
 	do {
 		std::istream *f = NULL;
 		next_args.clear();
+		LogTraceSpan trace_span(pass_name, nullptr, "pass");
 		auto state = pre_execute();
 		execute(f, std::string(), args, design);
 		post_execute(state);
@@ -567,11 +586,13 @@ void Frontend::frontend_call(RTLIL::Design *design, std::istream *f, std::string
 		log_cmd_error("No such frontend: %s\n", args[0].c_str());
 
 	if (f != NULL) {
+		LogTraceSpan trace_span(frontend_register[args[0]]->pass_name, nullptr, "pass");
 		auto state = frontend_register[args[0]]->pre_execute();
 		frontend_register[args[0]]->execute(f, filename, args, design);
 		frontend_register[args[0]]->post_execute(state);
 	} else if (filename == "-") {
 		std::istream *f_cin = &std::cin;
+		LogTraceSpan trace_span(frontend_register[args[0]]->pass_name, nullptr, "pass");
 		auto state = frontend_register[args[0]]->pre_execute();
 		frontend_register[args[0]]->execute(f_cin, "<stdin>", args, design);
 		frontend_register[args[0]]->post_execute(state);
@@ -614,6 +635,7 @@ void Backend::execute(std::vector<std::string> args, RTLIL::Design *design)
         }
     } deleter(f);
 
+	LogTraceSpan trace_span(pass_name, nullptr, "pass");
 	auto state = pre_execute();
 	execute(f, std::string(), args, design);
 	post_execute(state);
@@ -695,11 +717,13 @@ void Backend::backend_call(RTLIL::Design *design, std::ostream *f, std::string f
 	size_t orig_sel_stack_pos = design->selection_stack.size();
 
 	if (f != NULL) {
+		LogTraceSpan trace_span(backend_register[args[0]]->pass_name, nullptr, "pass");
 		auto state = backend_register[args[0]]->pre_execute();
 		backend_register[args[0]]->execute(f, filename, args, design);
 		backend_register[args[0]]->post_execute(state);
 	} else if (filename == "-") {
 		std::ostream *f_cout = &std::cout;
+		LogTraceSpan trace_span(backend_register[args[0]]->pass_name, nullptr, "pass");
 		auto state = backend_register[args[0]]->pre_execute();
 		backend_register[args[0]]->execute(f_cout, "<stdout>", args, design);
 		backend_register[args[0]]->post_execute(state);
@@ -66,7 +66,7 @@ struct Pass
 
 struct ScriptPass : Pass
 {
-	bool block_active, help_mode;
+	bool block_active, help_mode, label_traced;
 	RTLIL::Design *active_design;
 	std::string active_run_from, active_run_to;
 
@@ -399,6 +399,15 @@ void RTLIL::Selection::optimize(RTLIL::Design *design)
 	}
 }
 
+void RTLIL::Monitor::notify_cells_del(RTLIL::Module*, const pool<RTLIL::Cell*> &cells)
+{
+	for (auto cell : cells)
+		for (auto &conn : cell->connections_) {
+			RTLIL::SigSpec signal;
+			notify_connect(cell, conn.first, conn.second, signal);
+		}
+}
+
 RTLIL::Design::Design()
 {
 	static unsigned int hashidx_count = 123456789;
@@ -682,7 +691,52 @@ std::vector<RTLIL::Module*> RTLIL::Design::selected_whole_modules_warn() const
 	return result;
 }
 
-RTLIL::Module::Module()
+RTLIL::ObjectArena::ObjectArena(size_t object_size) : slab_capacity(0), slab_used(0), free_list(nullptr)
+{
+	// keep every object aligned like the slabs themselves
+	size_t align = alignof(std::max_align_t);
+	this->object_size = (std::max(object_size, sizeof(void*)) + align - 1) / align * align;
+}
+
+RTLIL::ObjectArena::~ObjectArena()
+{
+	for (auto slab : slabs)
+		::operator delete(slab);
+}
+
+void *RTLIL::ObjectArena::alloc()
+{
+	if (free_list != nullptr) {
+		void *ptr = free_list;
+		free_list = *(void**)ptr;
+		return ptr;
+	}
+
+	if (slab_used == slab_capacity) {
+		slab_capacity = slabs.empty() ? 16 : std::min(2 * slab_capacity, 4096);
+		slabs.push_back((char*)::operator new(slab_capacity * object_size));
+		slab_used = 0;
+	}
+
+	return slabs.back() + object_size * slab_used++;
+}
+
+void RTLIL::ObjectArena::free(void *ptr)
+{
+	*(void**)ptr = free_list;
+	free_list = ptr;
+}
+
+void RTLIL::ObjectArena::swap(RTLIL::ObjectArena &other)
+{
+	std::swap(object_size, other.object_size);
+	std::swap(slab_capacity, other.slab_capacity);
+	std::swap(slab_used, other.slab_used);
+	slabs.swap(other.slabs);
+	std::swap(free_list, other.free_list);
+}
+
+RTLIL::Module::Module() : wire_arena_(sizeof(RTLIL::Wire)), cell_arena_(sizeof(RTLIL::Cell))
 {
 	static unsigned int hashidx_count = 123456789;
 	hashidx_count = mkhash_xorshift(hashidx_count);
@@ -699,12 +753,13 @@ RTLIL::Module::Module()
 
 RTLIL::Module::~Module()
 {
+	// the arenas release the storage of all wires and cells at once
 	for (auto it = wires_.begin(); it != wires_.end(); ++it)
-		delete it->second;
+		it->second->~Wire();
 	for (auto it = memories.begin(); it != memories.end(); ++it)
 		delete it->second;
 	for (auto it = cells_.begin(); it != cells_.end(); ++it)
-		delete it->second;
+		it->second->~Cell();
 	for (auto it = processes.begin(); it != processes.end(); ++it)
 		delete it->second;
 #ifdef WITH_PYTHON
@@ -733,7 +788,7 @@ void RTLIL::Module::makeblackbox()
 	memories.clear();
 
 	for (auto it = cells_.begin(); it != cells_.end(); ++it)
-		delete it->second;
+		free(it->second);
 	cells_.clear();
 
 	for (auto it = processes.begin(); it != processes.end(); ++it)
@@ -1648,10 +1703,22 @@ void RTLIL::Module::add(RTLIL::Cell *cell)
 	cell->module = this;
 }
 
+void RTLIL::Module::free(RTLIL::Wire *wire)
+{
+	wire->~Wire();
+	wire_arena_.free(wire);
+}
+
+void RTLIL::Module::free(RTLIL::Cell *cell)
+{
+	cell->~Cell();
+	cell_arena_.free(cell);
+}
+
 void RTLIL::Module::erase(RTLIL::Wire* wire) {
     log_assert(wires_.count(wire->name) != 0);
     wires_.erase(wire->name);
-    delete wire;
+    free(wire);
 }
 void RTLIL::Module::remove(const pool<RTLIL::Wire*> &wires)
 {
@@ -1708,7 +1775,126 @@ void RTLIL::Module::remove(RTLIL::Cell *cell)
 	log_assert(cells_.count(cell->name) != 0);
 	log_assert(refcount_cells_ == 0);
 	cells_.erase(cell->name);
-	delete cell;
+	free(cell);
+}
+
+void RTLIL::Module::compact()
+{
+	log_assert(refcount_wires_ == 0);
+	log_assert(refcount_cells_ == 0);
+
+	// monitors may keep Wire* and Cell* pointers into the module
+	if (!monitors.empty() || (design != nullptr && !design->monitors.empty())) {
+		log_warning("Not compacting module %s while monitors are attached.\n", log_id(this));
+		return;
+	}
+
+	RTLIL::ObjectArena old_wire_arena(sizeof(RTLIL::Wire)), old_cell_arena(sizeof(RTLIL::Cell));
+	old_wire_arena.swap(wire_arena_);
+	old_cell_arena.swap(cell_arena_);
+
+	// the new objects keep the hashidx_ of the old ones, so that the order
+	// of hashed containers and everything derived from it stays the same
+	dict<RTLIL::Wire*, RTLIL::Wire*> wire_map;
+	vector<RTLIL::Wire*> old_wires;
+	vector<RTLIL::Cell*> old_cells;
+
+	for (auto &it : wires_) {
+		RTLIL::Wire *old_wire = it.second;
+		RTLIL::Wire *wire = new (wire_arena_.alloc()) RTLIL::Wire;
+#ifdef WITH_PYTHON
+		RTLIL::Wire::get_all_wires()->erase(wire->hashidx_);
+#endif
+		wire->hashidx_ = old_wire->hashidx_;
+		wire->attributes.swap(old_wire->attributes);
+		wire->module = this;
+		wire->name = old_wire->name;
+		wire->width = old_wire->width;
+		wire->start_offset = old_wire->start_offset;
+		wire->port_id = old_wire->port_id;
+		wire->port_input = old_wire->port_input;
+		wire->port_output = old_wire->port_output;
+		wire->upto = old_wire->upto;
+		wire_map[old_wire] = wire;
+		old_wires.push_back(old_wire);
+		it.second = wire;
+	}
+
+	for (auto &it : cells_) {
+		RTLIL::Cell *old_cell = it.second;
+		RTLIL::Cell *cell = new (cell_arena_.alloc()) RTLIL::Cell;
+#ifdef WITH_PYTHON
+		RTLIL::Cell::get_all_cells()->erase(cell->hashidx_);
+#endif
+		cell->hashidx_ = old_cell->hashidx_;
+		cell->attributes.swap(old_cell->attributes);
+		cell->module = this;
+		cell->name = old_cell->name;
+		cell->type = old_cell->type;
+		cell->connections_.swap(old_cell->connections_);
+		cell->parameters.swap(old_cell->parameters);
+		old_cells.push_back(old_cell);
+		it.second = cell;
+	}
+
+	struct CompactWorker
+	{
+		const dict<RTLIL::Wire*, RTLIL::Wire*> *wire_map_p;
+
+		void operator()(RTLIL::SigSpec &sig) {
+			if (sig.is_fully_const())
+				return;
+			std::vector<RTLIL::SigChunk> chunks = sig.chunks();
+			for (auto &c : chunks)
+				if (c.wire != nullptr)
+					c.wire = wire_map_p->at(c.wire);
+			sig = chunks;
+		}
+	};
+
+	CompactWorker compact_worker;
+	compact_worker.wire_map_p = &wire_map;
+	rewrite_sigspecs(compact_worker);
+
+	for (auto wire : old_wires)
+		wire->~Wire();
+	for (auto cell : old_cells)
+		cell->~Cell();
+
+#ifdef WITH_PYTHON
+	for (auto &it : wires_)
+		RTLIL::Wire::get_all_wires()->insert(std::pair<unsigned int, RTLIL::Wire*>(it.second->hashidx_, it.second));
+	for (auto &it : cells_)
+		RTLIL::Cell::get_all_cells()->insert(std::pair<unsigned int, RTLIL::Cell*>(it.second->hashidx_, it.second));
+#endif
+}
+
+void RTLIL::Module::remove(const pool<RTLIL::Cell*> &cells)
+{
+	log_assert(refcount_cells_ == 0);
+
+	if (cells.empty())
+		return;
+
+	for (auto mon : monitors)
+		mon->notify_cells_del(this, cells);
+
+	if (design)
+		for (auto mon : design->monitors)
+			mon->notify_cells_del(this, cells);
+
+	// the connections go away with the cells, there is no need to unset
+	// the ports one by one
+	for (auto cell : cells) {
+		if (yosys_xtrace) {
+			log("#X# Remove %s.%s\n", log_id(this), log_id(cell));
+			log_backtrace("-X- ", yosys_xtrace-1);
+		}
+		log_assert(cell->module == this);
+		log_assert(cells_.count(cell->name) != 0);
+		cells_.erase(cell->name);
+		free(cell);
+	}
 }
 
 void RTLIL::Module::rename(RTLIL::Wire *wire, RTLIL::IdString new_name)
@@ -1885,7 +2071,7 @@ void RTLIL::Module::fixup_ports()
 
 RTLIL::Wire *RTLIL::Module::addWire(RTLIL::IdString name, int width)
 {
-	RTLIL::Wire *wire = new RTLIL::Wire;
+	RTLIL::Wire *wire = new (wire_arena_.alloc()) RTLIL::Wire;
 	wire->name = name;
 	wire->width = width;
 	add(wire);
@@ -1907,9 +2093,16 @@ RTLIL::Wire *RTLIL::Module::addWire(RTLIL::IdString name, const RTLIL::Wire *oth
 
 RTLIL::Cell *RTLIL::Module::addCell(RTLIL::IdString name, RTLIL::IdString type)
 {
-	RTLIL::Cell *cell = new RTLIL::Cell;
+	RTLIL::Cell *cell = new (cell_arena_.alloc()) RTLIL::Cell;
 	cell->name = name;
 	cell->type = type;
+
+	// the ports of known cell types are allocated in one go (and, with
+	// at most 8 of them, without a hashtable)
+	auto it = yosys_celltypes.cell_types.find(type);
+	if (it != yosys_celltypes.cell_types.end())
+		cell->connections_.reserve(GetSize(it->second.inputs) + GetSize(it->second.outputs));
+
 	add(cell);
 	return cell;
 }
@@ -2871,7 +3064,7 @@ const RTLIL::SigSpec &RTLIL::SigSpec::operator=(const RTLIL::SigSpec &other)
 	chunks_ = other.chunks_;
 	bits_.clear();
 
-	if (!other.bits_.empty())
+	if (other.chunks_.empty() && !other.bits_.empty())
 	{
 		RTLIL::SigChunk *last = NULL;
 		int last_end_offset = 0;
@@ -3041,19 +3234,15 @@ void RTLIL::SigSpec::pack() const
 {
 	RTLIL::SigSpec *that = (RTLIL::SigSpec*)this;
 
-	if (that->bits_.empty())
+	if (!that->chunks_.empty() || that->bits_.empty())
 		return;
 
 	cover("kernel.rtlil.sigspec.convert.pack");
-	log_assert(that->chunks_.empty());
-
-	std::vector<RTLIL::SigBit> old_bits;
-	old_bits.swap(that->bits_);
 
 	RTLIL::SigChunk *last = NULL;
 	int last_end_offset = 0;
 
-	for (auto &bit : old_bits) {
+	for (auto &bit : that->bits_) {
 		if (last && bit.wire == last->wire) {
 			if (bit.wire == NULL) {
 				last->data.push_back(bit.data);
@@ -3077,19 +3266,31 @@ void RTLIL::SigSpec::unpack() const
 {
 	RTLIL::SigSpec *that = (RTLIL::SigSpec*)this;
 
-	if (that->chunks_.empty())
+	if (!that->bits_.empty() || that->chunks_.empty())
 		return;
 
 	cover("kernel.rtlil.sigspec.convert.unpack");
-	log_assert(that->bits_.empty());
 
 	that->bits_.reserve(that->width_);
 	for (auto &c : that->chunks_)
 		for (int i = 0; i < c.width; i++)
 			that->bits_.push_back(RTLIL::SigBit(c, i));
+}
+
+void RTLIL::SigSpec::make_packed()
+{
+	pack();
+	if (!bits_.empty())
+		std::vector<RTLIL::SigBit>().swap(bits_);
+	hash_ = 0;
+}
 
-	that->chunks_.clear();
-	that->hash_ = 0;
+void RTLIL::SigSpec::make_unpacked()
+{
+	unpack();
+	if (!chunks_.empty())
+		std::vector<RTLIL::SigChunk>().swap(chunks_);
+	hash_ = 0;
 }
 
 void RTLIL::SigSpec::updhash() const
@@ -3100,18 +3301,54 @@ void RTLIL::SigSpec::updhash() const
 		return;
 
 	cover("kernel.rtlil.sigspec.hash");
-	that->pack();
 
+	// The hash is defined on the chunks. For an unpacked signal the chunks
+	// are reconstructed on the fly, so that no conversion is needed.
 	that->hash_ = mkhash_init;
-	for (auto &c : that->chunks_)
-		if (c.wire == NULL) {
-			for (auto &v : c.data)
-				that->hash_ = mkhash(that->hash_, v);
-		} else {
-			that->hash_ = mkhash(that->hash_, c.wire->name.index_);
-			that->hash_ = mkhash(that->hash_, c.offset);
-			that->hash_ = mkhash(that->hash_, c.width);
+
+	if (!that->chunks_.empty())
+	{
+		for (auto &c : that->chunks_)
+			if (c.wire == NULL) {
+				for (auto &v : c.data)
+					that->hash_ = mkhash(that->hash_, v);
+			} else {
+				that->hash_ = mkhash(that->hash_, c.wire->name.index_);
+				that->hash_ = mkhash(that->hash_, c.offset);
+				that->hash_ = mkhash(that->hash_, c.width);
+			}
+	}
+	else
+	{
+		RTLIL::Wire *run_wire = NULL;
+		int run_offset = 0, run_width = 0;
+
+		for (auto &bit : that->bits_) {
+			if (run_wire != NULL) {
+				if (bit.wire == run_wire && bit.offset == run_offset + run_width) {
+					run_width++;
+					continue;
+				}
+				that->hash_ = mkhash(that->hash_, run_wire->name.index_);
+				that->hash_ = mkhash(that->hash_, run_offset);
+				that->hash_ = mkhash(that->hash_, run_width);
+				run_wire = NULL;
+			}
+			if (bit.wire == NULL) {
+				that->hash_ = mkhash(that->hash_, bit.data);
+			} else {
+				run_wire = bit.wire;
+				run_offset = bit.offset;
+				run_width = 1;
+			}
+		}
+
+		if (run_wire != NULL) {
+			that->hash_ = mkhash(that->hash_, run_wire->name.index_);
+			that->hash_ = mkhash(that->hash_, run_offset);
+			that->hash_ = mkhash(that->hash_, run_width);
 		}
+	}
 
 	if (that->hash_ == 0)
 		that->hash_ = 1;
@@ -3119,7 +3356,7 @@ void RTLIL::SigSpec::updhash() const
 
 void RTLIL::SigSpec::sort()
 {
-	unpack();
+	make_unpacked();
 	cover("kernel.rtlil.sigspec.sort");
 	std::sort(bits_.begin(), bits_.end());
 }
@@ -3154,7 +3391,7 @@ void RTLIL::SigSpec::replace(const RTLIL::SigSpec &pattern, const RTLIL::SigSpec
 	pattern.unpack();
 	with.unpack();
 	unpack();
-	other->unpack();
+	other->make_unpacked();
 
 	for (int i = 0; i < GetSize(pattern.bits_); i++) {
 		if (pattern.bits_[i].wire != NULL) {
@@ -3182,7 +3419,7 @@ void RTLIL::SigSpec::replace(const dict<RTLIL::SigBit, RTLIL::SigBit> &rules, RT
 	log_assert(width_ == other->width_);
 
 	unpack();
-	other->unpack();
+	other->make_unpacked();
 
 	for (int i = 0; i < GetSize(bits_); i++) {
 		auto it = rules.find(bits_[i]);
@@ -3206,7 +3443,7 @@ void RTLIL::SigSpec::replace(const std::map<RTLIL::SigBit, RTLIL::SigBit> &rules
 	log_assert(width_ == other->width_);
 
 	unpack();
-	other->unpack();
+	other->make_unpacked();
 
 	for (int i = 0; i < GetSize(bits_); i++) {
 		auto it = rules.find(bits_[i]);
@@ -3235,10 +3472,10 @@ void RTLIL::SigSpec::remove2(const RTLIL::SigSpec &pattern, RTLIL::SigSpec *othe
 	else
 		cover("kernel.rtlil.sigspec.remove");
 
-	unpack();
+	make_unpacked();
 	if (other != NULL) {
 		log_assert(width_ == other->width_);
-		other->unpack();
+		other->make_unpacked();
 	}
 
 	for (int i = GetSize(bits_) - 1; i >= 0; i--)
@@ -3280,11 +3517,11 @@ void RTLIL::SigSpec::remove2(const pool<RTLIL::SigBit> &pattern, RTLIL::SigSpec
 	else
 		cover("kernel.rtlil.sigspec.remove");
 
-	unpack();
+	make_unpacked();
 
 	if (other != NULL) {
 		log_assert(width_ == other->width_);
-		other->unpack();
+		other->make_unpacked();
 	}
 
 	for (int i = GetSize(bits_) - 1; i >= 0; i--) {
@@ -3308,11 +3545,11 @@ void RTLIL::SigSpec::remove2(const std::set<RTLIL::SigBit> &pattern, RTLIL::SigS
 	else
 		cover("kernel.rtlil.sigspec.remove");
 
-	unpack();
+	make_unpacked();
 
 	if (other != NULL) {
 		log_assert(width_ == other->width_);
-		other->unpack();
+		other->make_unpacked();
 	}
 
 	for (int i = GetSize(bits_) - 1; i >= 0; i--) {
@@ -3339,11 +3576,11 @@ RTLIL::SigSpec RTLIL::SigSpec::extract(const RTLIL::SigSpec &pattern, const RTLI
 	log_assert(other == NULL || width_ == other->width_);
 
 	RTLIL::SigSpec ret;
-	std::vector<RTLIL::SigBit> bits_match = to_sigbit_vector();
+	const std::vector<RTLIL::SigBit> &bits_match = bits();
 
 	for (auto& pattern_chunk : pattern.chunks()) {
 		if (other) {
-			std::vector<RTLIL::SigBit> bits_other = other->to_sigbit_vector();
+			const std::vector<RTLIL::SigBit> &bits_other = other->bits();
 			for (int i = 0; i < width_; i++)
 				if (bits_match[i].wire &&
 					bits_match[i].wire == pattern_chunk.wire &&
@@ -3373,11 +3610,11 @@ RTLIL::SigSpec RTLIL::SigSpec::extract(const pool<RTLIL::SigBit> &pattern, const
 
 	log_assert(other == NULL || width_ == other->width_);
 
-	std::vector<RTLIL::SigBit> bits_match = to_sigbit_vector();
+	const std::vector<RTLIL::SigBit> &bits_match = bits();
 	RTLIL::SigSpec ret;
 
 	if (other) {
-		std::vector<RTLIL::SigBit> bits_other = other->to_sigbit_vector();
+		const std::vector<RTLIL::SigBit> &bits_other = other->bits();
 		for (int i = 0; i < width_; i++)
 			if (bits_match[i].wire && pattern.count(bits_match[i]))
 				ret.append_bit(bits_other[i]);
@@ -3395,7 +3632,7 @@ void RTLIL::SigSpec::replace(int offset, const RTLIL::SigSpec &with)
 {
 	cover("kernel.rtlil.sigspec.replace_pos");
 
-	unpack();
+	make_unpacked();
 	with.unpack();
 
 	log_assert(offset >= 0);
@@ -3410,6 +3647,11 @@ void RTLIL::SigSpec::replace(int offset, const RTLIL::SigSpec &with)
 
 void RTLIL::SigSpec::remove_const()
 {
+	if (!chunks_.empty())
+		make_packed();
+	else
+		hash_ = 0;
+
 	if (packed())
 	{
 		cover("kernel.rtlil.sigspec.remove_const.packed");
@@ -3448,7 +3690,7 @@ void RTLIL::SigSpec::remove(int offset, int length)
 {
 	cover("kernel.rtlil.sigspec.remove_pos");
 
-	unpack();
+	make_unpacked();
 
 	log_assert(offset >= 0);
 	log_assert(length >= 0);
@@ -3462,9 +3704,39 @@ void RTLIL::SigSpec::remove(int offset, int length)
 
 RTLIL::SigSpec RTLIL::SigSpec::extract(int offset, int length) const
 {
-	unpack();
-	cover("kernel.rtlil.sigspec.extract_pos");
-	return std::vector<RTLIL::SigBit>(bits_.begin() + offset, bits_.begin() + offset + length);
+	log_assert(offset >= 0);
+	log_assert(length >= 0);
+	log_assert(offset + length <= width_);
+
+	RTLIL::SigSpec ret;
+	ret.width_ = length;
+
+	if (length == 0)
+		return ret;
+
+	if (!bits_.empty())
+	{
+		cover("kernel.rtlil.sigspec.extract_pos.unpacked");
+		ret.bits_.assign(bits_.begin() + offset, bits_.begin() + offset + length);
+	}
+	else
+	{
+		// slices of the chunks of a packed signal are packed as well
+		cover("kernel.rtlil.sigspec.extract_pos.packed");
+		int chunk_offset = 0;
+		for (auto &c : chunks_) {
+			int lo = std::max(offset, chunk_offset);
+			int hi = std::min(offset + length, chunk_offset + c.width);
+			if (lo < hi)
+				ret.chunks_.push_back(lo == chunk_offset && hi - lo == c.width ? c : c.extract(lo - chunk_offset, hi - lo));
+			chunk_offset += c.width;
+			if (chunk_offset >= offset + length)
+				break;
+		}
+	}
+
+	ret.check();
+	return ret;
 }
 
 void RTLIL::SigSpec::append(const RTLIL::SigSpec &signal)
@@ -3477,11 +3749,22 @@ void RTLIL::SigSpec::append(const RTLIL::SigSpec &signal)
 		return;
 	}
 
+	if (&signal == this) {
+		RTLIL::SigSpec tmp = signal;
+		append(tmp);
+		return;
+	}
+
 	cover("kernel.rtlil.sigspec.append");
 
-	if (packed() != signal.packed()) {
-		pack();
+	// keep the form this signal already has (prefer chunks if it has
+	// both and the other signal has chunks as well)
+	if (!chunks_.empty() && (bits_.empty() || !signal.chunks_.empty())) {
+		make_packed();
 		signal.pack();
+	} else {
+		make_unpacked();
+		signal.unpack();
 	}
 
 	if (packed())
@@ -3508,6 +3791,10 @@ void RTLIL::SigSpec::append(const RTLIL::SigSpec &signal)
 
 void RTLIL::SigSpec::append_bit(const RTLIL::SigBit &bit)
 {
+	if (!chunks_.empty() && !bits_.empty())
+		make_unpacked();
+	hash_ = 0;
+
 	if (packed())
 	{
 		cover("kernel.rtlil.sigspec.append_bit.packed");
@@ -3541,10 +3828,8 @@ void RTLIL::SigSpec::extend_u0(int width, bool is_signed)
 {
 	cover("kernel.rtlil.sigspec.extend_u0");
 
-	pack();
-
 	if (width_ > width)
-		remove(width, width_ - width);
+		*this = extract(0, width);
 
 	if (width_ < width) {
 		RTLIL::SigBit padding = width_ > 0 ? (*this)[width_ - 1] : RTLIL::State::Sx;
@@ -3573,7 +3858,7 @@ void RTLIL::SigSpec::check() const
 	{
 		cover("kernel.rtlil.sigspec.check.skip");
 	}
-	else if (packed())
+	else
 	{
 		cover("kernel.rtlil.sigspec.check.packed");
 
@@ -3595,15 +3880,11 @@ void RTLIL::SigSpec::check() const
 			}
 			w += chunk.width;
 		}
-		log_assert(w == width_);
-		log_assert(bits_.empty());
-	}
-	else
-	{
-		cover("kernel.rtlil.sigspec.check.unpacked");
+		log_assert(chunks_.empty() || w == width_);
 
-		log_assert(width_ == GetSize(bits_));
-		log_assert(chunks_.empty());
+		cover("kernel.rtlil.sigspec.check.unpacked");
+		log_assert(bits_.empty() || width_ == GetSize(bits_));
+		log_assert(width_ == 0 || !chunks_.empty() || !bits_.empty());
 	}
 }
 #endif
@@ -3650,6 +3931,16 @@ bool RTLIL::SigSpec::operator ==(const RTLIL::SigSpec &other) const
 	if (width_ != other.width_)
 		return false;
 
+	// compare bit vectors if both have them and one of them is not packed
+	if (!bits_.empty() && !other.bits_.empty() && (chunks_.empty() || other.chunks_.empty())) {
+		updhash();
+		other.updhash();
+		if (hash_ != other.hash_)
+			return false;
+		cover("kernel.rtlil.sigspec.comp_eq.unpacked");
+		return bits_ == other.bits_;
+	}
+
 	pack();
 	other.pack();
 
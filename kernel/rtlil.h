@@ -76,6 +76,7 @@ namespace RTLIL
 	struct SwitchRule;
 	struct SyncRule;
 	struct Process;
+	struct ObjectArena;
 
 	typedef std::pair<SigSpec, SigSpec> SigSig;
 
@@ -667,7 +668,7 @@ struct RTLIL::Const
 	inline unsigned int hash() const {
 		unsigned int h = mkhash_init;
 		for (auto b : bits)
-			mkhash(h, b);
+			h = mkhash(h, b);
 		return h;
 	}
 };
@@ -768,19 +769,27 @@ struct RTLIL::SigSpec
 private:
 	int width_;
 	unsigned long hash_;
+
+	// A signal is stored as list of chunks, as list of bits, or both. The
+	// const accessors add a missing representation without dropping the
+	// other one, so that alternating chunks()/bits() calls don't convert
+	// back and forth. Modifying methods first drop the representation
+	// they don't update (make_packed()/make_unpacked()).
 	std::vector<RTLIL::SigChunk> chunks_; // LSB at index 0
 	std::vector<RTLIL::SigBit> bits_; // LSB at index 0
 
 	void pack() const;
 	void unpack() const;
 	void updhash() const;
+	void make_packed();
+	void make_unpacked();
 
 	inline bool packed() const {
 		return bits_.empty();
 	}
 
 	inline void inline_unpack() const {
-		if (!chunks_.empty())
+		if (bits_.empty() && !chunks_.empty())
 			unpack();
 	}
 
@@ -830,7 +839,12 @@ public:
 	inline int size() const { return width_; }
 	inline bool empty() const { return width_ == 0; }
 
-	inline RTLIL::SigBit &operator[](int index) { inline_unpack(); return bits_.at(index); }
+	inline RTLIL::SigBit &operator[](int index) {
+		if (!chunks_.empty())
+			make_unpacked();
+		hash_ = 0;
+		return bits_.at(index);
+	}
 	inline const RTLIL::SigBit &operator[](int index) const { inline_unpack(); return bits_.at(index); }
 
 	inline RTLIL::SigSpecIterator begin() { RTLIL::SigSpecIterator it; it.sig_p = this; it.index = 0; return it; }
@@ -975,6 +989,10 @@ struct RTLIL::Monitor
 	virtual void notify_connect(RTLIL::Module*, const std::vector<RTLIL::SigSig>&) { }
 	virtual void notify_blackout(RTLIL::Module*) { }
     virtual void notify_design_delete(RTLIL::Design*) {}
+
+	// called before Module::remove() deletes a set of cells, by default
+	// this reports every port of these cells as disconnected
+	virtual void notify_cells_del(RTLIL::Module *module, const pool<RTLIL::Cell*> &cells);
 };
 
 struct RTLIL::Design
@@ -1067,14 +1085,40 @@ struct RTLIL::Design
 #endif
 };
 
+// Storage for the wires or cells of one module. Objects are carved out of
+// slabs that grow up to 4096 objects each, freed objects are put on a free
+// list for reuse, and all slabs are released together with the arena.
+struct RTLIL::ObjectArena
+{
+	size_t object_size;
+	int slab_capacity, slab_used;
+	std::vector<char*> slabs;
+	void *free_list;
+
+	ObjectArena(size_t object_size);
+	~ObjectArena();
+
+	// do not copy arenas, the objects in them belong to one module
+	ObjectArena(const RTLIL::ObjectArena &other) = delete;
+	void operator=(const RTLIL::ObjectArena &other) = delete;
+
+	void *alloc();
+	void free(void *ptr);
+	void swap(RTLIL::ObjectArena &other);
+};
+
 struct RTLIL::Module : public RTLIL::AttrObject
 {
 	unsigned int hashidx_;
 	unsigned int hash() const { return hashidx_; }
 
 protected:
+	RTLIL::ObjectArena wire_arena_, cell_arena_;
+
 	void add(RTLIL::Wire *wire);
 	void add(RTLIL::Cell *cell);
+	void free(RTLIL::Wire *wire);
+	void free(RTLIL::Cell *cell);
 
 	int find_top_mod_score_by_celltype(dict<Module*, int> &db, std::string celltype);
 	virtual int calc_top_mod_score(dict<Module*, int> &db);
@@ -1146,11 +1190,19 @@ public:
 
 	// Removing wires is expensive. If you have to remove wires, remove them all at once.
 	void remove(const pool<RTLIL::Wire*> &wires);
+	void remove(const pool<RTLIL::Cell*> &cells);
 	void remove(RTLIL::Cell *cell);
 
     //Remove from wires list and delete. Make sure the wire is unused!
     void erase(RTLIL::Wire* wire);
 
+	// Move all wires and cells to new storage, in the order in which wires()
+	// and cells() return them. This invalidates all Wire* and Cell* pointers
+	// into the module, so it must only be called when nothing holds on to
+	// them (e.g. between passes). With monitors attached to the module or
+	// the design it only prints a warning and leaves the module unchanged.
+	void compact();
+
 	void rename(RTLIL::Wire *wire, RTLIL::IdString new_name);
 	void rename(RTLIL::Cell *cell, RTLIL::IdString new_name);
 	void rename(RTLIL::IdString old_name, RTLIL::IdString new_name);
@@ -1521,7 +1573,7 @@ inline bool RTLIL::SigBit::operator!=(const RTLIL::SigBit &other) const {
 
 inline unsigned int RTLIL::SigBit::hash() const {
 	if (wire)
-		return mkhash_add(wire->name.hash(), offset);
+		return mkhash_mix(wire->hashidx_, offset);
 	return data;
 }
 
@@ -1534,8 +1586,7 @@ inline const RTLIL::SigBit &RTLIL::SigSpecConstIterator::operator*() const {
 }
 
 inline RTLIL::SigBit::SigBit(const RTLIL::SigSpec &sig) {
-	log_assert(sig.size() == 1 && sig.chunks().size() == 1);
-	*this = SigBit(sig.chunks().front());
+	*this = sig.as_bit();
 }
 
 template<typename T>
@@ -0,0 +1,249 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+// [[CITE]] Tarjan's strongly connected components algorithm
+// Tarjan, R. E. (1972), "Depth-first search and linear graph algorithms", SIAM Journal on Computing 1 (2): 146-160, doi:10.1137/0201010
+// http://en.wikipedia.org/wiki/Tarjan's_strongly_connected_components_algorithm
+
+#ifndef SCC_H
+#define SCC_H
+
+#include "kernel/yosys.h"
+#include "kernel/sigtools.h"
+#include "kernel/celltypes.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+// ------------------------------------------------
+// Strongly connected components of a graph with dense integer nodes
+// ------------------------------------------------
+
+struct SccGraph
+{
+	int num_nodes = 0;
+	vector<pair<int, int>> edges;
+
+	// results of find()
+	vector<int> node_scc;
+	vector<vector<int>> sccs;
+	vector<bool> self_loop;
+	vector<int> postorder;
+
+	int node()
+	{
+		return num_nodes++;
+	}
+
+	void edge(int from, int to)
+	{
+		log_assert(0 <= from && from < num_nodes);
+		log_assert(0 <= to && to < num_nodes);
+		edges.push_back(pair<int, int>(from, to));
+	}
+
+	// Iterative Tarjan. Every node ends up in exactly one component. The
+	// components are stored in reverse topological order, i.e. a component
+	// comes before all components that have an edge into it.
+	//
+	// With max_depth >= 0, an edge back to a node on the DFS stack is only
+	// followed if that node is less than max_depth levels up the DFS tree,
+	// limiting the search to short loops (as in "scc -max_depth").
+	//
+	// postorder lists the nodes in the order in which the search finishes
+	// them. The roots and the edges of each node are visited in node order,
+	// so with edges that point from each node to its predecessors this is a
+	// topological order in which ties are broken by node number.
+	void find(int max_depth = -1)
+	{
+		int N = num_nodes;
+
+		std::sort(edges.begin(), edges.end());
+		edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+		vector<int> edge_start(N+1);
+		for (auto &e : edges)
+			edge_start[e.first + 1]++;
+		for (int i = 0; i < N; i++)
+			edge_start[i+1] += edge_start[i];
+
+		self_loop.assign(N, false);
+		for (auto &e : edges)
+			if (e.first == e.second)
+				self_loop[e.first] = true;
+
+		vector<int> label(N, -1), lowlink(N), depth(N);
+		vector<bool> on_stack(N);
+		vector<int> scc_stack;
+		vector<pair<int, int>> call_stack;
+		int label_counter = 0;
+
+		node_scc.assign(N, -1);
+		sccs.clear();
+		postorder.clear();
+
+		for (int root = 0; root < N; root++)
+		{
+			if (label[root] >= 0)
+				continue;
+
+			auto visit = [&](int n, int d) {
+				label[n] = lowlink[n] = label_counter++;
+				depth[n] = d;
+				on_stack[n] = true;
+				scc_stack.push_back(n);
+				call_stack.push_back(pair<int, int>(n, edge_start[n]));
+			};
+
+			visit(root, 0);
+
+			while (!call_stack.empty())
+			{
+				int n = call_stack.back().first;
+				int e = call_stack.back().second;
+
+				if (e < edge_start[n+1]) {
+					call_stack.back().second++;
+					int m = edges[e].second;
+					if (label[m] < 0)
+						visit(m, depth[n]+1);
+					else if (on_stack[m] && (max_depth < 0 || depth[m] + max_depth > depth[n]))
+						lowlink[n] = min(lowlink[n], lowlink[m]);
+					continue;
+				}
+
+				call_stack.pop_back();
+				postorder.push_back(n);
+
+				if (!call_stack.empty()) {
+					int parent = call_stack.back().first;
+					lowlink[parent] = min(lowlink[parent], lowlink[n]);
+				}
+
+				if (lowlink[n] == label[n]) {
+					int scc_id = GetSize(sccs);
+					sccs.push_back(vector<int>());
+					while (1) {
+						int m = scc_stack.back();
+						scc_stack.pop_back();
+						on_stack[m] = false;
+						node_scc[m] = scc_id;
+						sccs.back().push_back(m);
+						if (m == n)
+							break;
+					}
+				}
+			}
+		}
+	}
+
+	// true if the node is part of a loop, including a self-loop
+	bool in_loop(int n) const
+	{
+		return self_loop[n] || GetSize(sccs[node_scc[n]]) > 1;
+	}
+
+	bool found_loops() const
+	{
+		for (int n = 0; n < num_nodes; n++)
+			if (in_loop(n))
+				return true;
+		return false;
+	}
+};
+
+// ------------------------------------------------
+// SCC graph over the cells of a module, with an edge from each cell
+// to every cell that uses one of its output bits
+// ------------------------------------------------
+
+struct SccCellGraph
+{
+	SccGraph graph;
+	idict<RTLIL::Cell*> cells;
+	dict<RTLIL::SigBit, vector<int>> bit_drivers, bit_users;
+
+	int add_cell(RTLIL::Cell *cell)
+	{
+		int idx = cells(cell);
+		if (idx == graph.num_nodes)
+			graph.node();
+		return idx;
+	}
+
+	void add_driver(RTLIL::Cell *cell, RTLIL::SigBit bit)
+	{
+		bit_drivers[bit].push_back(add_cell(cell));
+	}
+
+	void add_user(RTLIL::Cell *cell, RTLIL::SigBit bit)
+	{
+		bit_users[bit].push_back(add_cell(cell));
+	}
+
+	// Add all connections of a cell. Ports of cell types unknown to ct are
+	// treated as inout ports.
+	void add_connections(const SigMap &sigmap, const CellTypes &ct, RTLIL::Cell *cell)
+	{
+		add_cell(cell);
+		bool known = ct.cell_known(cell->type);
+
+		for (auto &conn : cell->connections())
+		{
+			bool is_input = !known || ct.cell_input(cell->type, conn.first);
+			bool is_output = !known || ct.cell_output(cell->type, conn.first);
+
+			for (auto bit : sigmap(conn.second)) {
+				if (bit.wire == nullptr)
+					continue;
+				if (is_input)
+					add_user(cell, bit);
+				if (is_output)
+					add_driver(cell, bit);
+			}
+		}
+	}
+
+	void find(int max_depth = -1)
+	{
+		for (auto &it : bit_drivers) {
+			auto users = bit_users.find(it.first);
+			if (users == bit_users.end())
+				continue;
+			for (int driver : it.second)
+			for (int user : users->second)
+				graph.edge(driver, user);
+		}
+
+		graph.find(max_depth);
+	}
+
+	// cells in topological order (drivers before users), loops in arbitrary order
+	vector<RTLIL::Cell*> sorted() const
+	{
+		vector<RTLIL::Cell*> result;
+		for (int i = GetSize(graph.sccs)-1; i >= 0; i--)
+			for (int n : graph.sccs[i])
+				result.push_back(cells[n]);
+		return result;
+	}
+};
+
+YOSYS_NAMESPACE_END
+
+#endif
@@ -124,6 +124,32 @@ public:
 };
 
 
+// ------------------------------------------------
+// A string with stream-like appending, for backends that assemble their
+// output in memory and write it to the output stream in one piece
+// ------------------------------------------------
+
+struct TextBuffer
+{
+	std::string str;
+
+	TextBuffer &operator<<(const std::string &s) { str += s; return *this; }
+	TextBuffer &operator<<(const char *s) { str += s; return *this; }
+	TextBuffer &operator<<(char c) { str += c; return *this; }
+
+	TextBuffer &operator<<(int value)
+	{
+		char buf[16], *p = buf + sizeof(buf);
+		unsigned int v = value < 0 ? 0u - value : value;
+		do *--p = '0' + v % 10; while (v /= 10);
+		if (value < 0)
+			*--p = '-';
+		str.append(p, buf + sizeof(buf) - p);
+		return *this;
+	}
+};
+
+
 // ------------------------------------------------
 // A simple class for topological sorting
 // ------------------------------------------------
@@ -132,10 +158,16 @@ template<typename T, typename C = std::less<T>>
 struct TopoSort
 {
 	bool analyze_loops, found_loops;
-	std::map<T, std::set<T, C>, C> database;
 	std::set<std::set<T, C>> loops;
 	std::vector<T> sorted;
 
+	// node() and edge() only collect the graph, sort() maps the nodes to
+	// dense indices in the order given by C and runs the depth-first search
+	// on those. The order of the result is the same as with a search that
+	// visits the nodes and their predecessors in C order.
+	std::vector<T> nodes;
+	std::vector<std::pair<T, T>> edges;
+
 	TopoSort()
 	{
 		analyze_loops = true;
@@ -144,68 +176,265 @@ struct TopoSort
 
 	void node(T n)
 	{
-		if (database.count(n) == 0)
-			database[n] = std::set<T, C>();
+		nodes.push_back(n);
 	}
 
 	void edge(T left, T right)
 	{
-		node(left);
-		database[right].insert(left);
+		edges.push_back(std::pair<T, T>(left, right));
 	}
 
-	void sort_worker(const T &n, std::set<T, C> &marked_cells, std::set<T, C> &active_cells, std::vector<T> &active_stack)
+	bool sort()
 	{
-		if (active_cells.count(n)) {
-			found_loops = true;
-			if (analyze_loops) {
-				std::set<T, C> loop;
-				for (int i = GetSize(active_stack)-1; i >= 0; i--) {
-					loop.insert(active_stack[i]);
-					if (active_stack[i] == n)
-						break;
-				}
-				loops.insert(loop);
-			}
-			return;
+		loops.clear();
+		sorted.clear();
+		found_loops = false;
+
+		C comp;
+		std::vector<T> index = nodes;
+		for (auto &e : edges) {
+			index.push_back(e.first);
+			index.push_back(e.second);
 		}
+		std::sort(index.begin(), index.end(), comp);
+		index.erase(std::unique(index.begin(), index.end(), [&](const T &a, const T &b) { return !comp(a, b) && !comp(b, a); }), index.end());
+
+		auto lookup = [&](const T &n) {
+			return int(std::lower_bound(index.begin(), index.end(), n, comp) - index.begin());
+		};
+
+		int N = GetSize(index);
+
+		// predecessors of each node, in C order
+		std::vector<std::pair<int, int>> preds;
+		preds.reserve(edges.size());
+		for (auto &e : edges)
+			preds.push_back(std::pair<int, int>(lookup(e.second), lookup(e.first)));
+		std::sort(preds.begin(), preds.end());
+		preds.erase(std::unique(preds.begin(), preds.end()), preds.end());
+
+		std::vector<int> pred_start(N+1);
+		for (auto &p : preds)
+			pred_start[p.first + 1]++;
+		for (int i = 0; i < N; i++)
+			pred_start[i+1] += pred_start[i];
+
+		std::vector<bool> marked(N), active(N);
+		std::vector<std::pair<int, int>> stack;
+
+		auto finish = [&](int n) {
+			marked[n] = true;
+			sorted.push_back(index[n]);
+		};
+
+		for (int root = 0; root < N; root++)
+		{
+			if (marked[root])
+				continue;
 
-		if (marked_cells.count(n))
-			return;
+			if (pred_start[root] == pred_start[root+1]) {
+				finish(root);
+				continue;
+			}
 
-		if (!database.at(n).empty())
-		{
-			if (analyze_loops)
-				active_stack.push_back(n);
-			active_cells.insert(n);
+			active[root] = true;
+			stack.push_back(std::pair<int, int>(root, pred_start[root]));
+
+			while (!stack.empty())
+			{
+				int n = stack.back().first;
+				int p = stack.back().second;
+
+				if (p == pred_start[n+1]) {
+					stack.pop_back();
+					active[n] = false;
+					finish(n);
+					continue;
+				}
+
+				stack.back().second++;
+				int m = preds[p].second;
+
+				if (active[m]) {
+					found_loops = true;
+					if (analyze_loops) {
+						std::set<T, C> loop;
+						for (int i = GetSize(stack)-1; i >= 0; i--) {
+							loop.insert(index[stack[i].first]);
+							if (stack[i].first == m)
+								break;
+						}
+						loops.insert(loop);
+					}
+					continue;
+				}
+
+				if (marked[m])
+					continue;
 
-			for (auto &left_n : database.at(n))
-				sort_worker(left_n, marked_cells, active_cells, active_stack);
+				if (pred_start[m] == pred_start[m+1]) {
+					finish(m);
+					continue;
+				}
 
-			if (analyze_loops)
-				active_stack.pop_back();
-			active_cells.erase(n);
+				active[m] = true;
+				stack.push_back(std::pair<int, int>(m, pred_start[m]));
+			}
 		}
 
-		marked_cells.insert(n);
-		sorted.push_back(n);
+		log_assert(GetSize(sorted) == N);
+		return !found_loops;
+	}
+};
+
+// ------------------------------------------------
+// Topological sorting of a graph with dense integer nodes (Kahn's
+// algorithm), for users that do not depend on a particular order
+// among independent nodes
+// ------------------------------------------------
+
+struct IntTopoSort
+{
+	bool analyze_loops = true, found_loops = false;
+	int num_nodes = 0;
+	std::vector<std::pair<int, int>> edges;
+
+	// results of sort(): the nodes in topological order, followed by
+	// the nodes that are on a loop or behind one
+	std::vector<int> sorted;
+	int num_sorted = 0;
+
+	// longest distance to a node without predecessors, or -1 for the
+	// nodes on or behind a loop. sorted lists the nodes level by level.
+	// Nodes on the same level don't depend on each other, but sort()
+	// itself is sequential: the callers work on cells and IdStrings,
+	// whose reference counts are not thread-safe.
+	std::vector<int> level;
+	int num_levels = 0;
+
+	// one cycle for each back edge of a depth-first search over the nodes
+	// on or behind a loop (if analyze_loops), like TopoSort::loops, so
+	// loops that share nodes are reported separately
+	std::vector<std::vector<int>> loops;
+
+	int node()
+	{
+		return num_nodes++;
+	}
+
+	void edge(int left, int right)
+	{
+		log_assert(0 <= left && left < num_nodes);
+		log_assert(0 <= right && right < num_nodes);
+		edges.push_back(std::pair<int, int>(left, right));
 	}
 
 	bool sort()
 	{
-		loops.clear();
+		int N = num_nodes;
+
+		std::vector<int> succ_start(N+1), succ(GetSize(edges)), indegree(N);
+		for (auto &e : edges) {
+			succ_start[e.first + 1]++;
+			indegree[e.second]++;
+		}
+		for (int i = 0; i < N; i++)
+			succ_start[i+1] += succ_start[i];
+		std::vector<int> fill(succ_start.begin(), succ_start.end() - 1);
+		for (auto &e : edges)
+			succ[fill[e.first]++] = e.second;
+
 		sorted.clear();
-		found_loops = false;
+		sorted.reserve(N);
+		level.assign(N, -1);
+		loops.clear();
 
-		std::set<T, C> marked_cells;
-		std::set<T, C> active_cells;
-		std::vector<T> active_stack;
+		for (int i = 0; i < N; i++)
+			if (indegree[i] == 0) {
+				level[i] = 0;
+				sorted.push_back(i);
+			}
 
-		for (auto &it : database)
-			sort_worker(it.first, marked_cells, active_cells, active_stack);
+		// process the nodes one level (wavefront) at a time
+		num_levels = 0;
+		for (int begin = 0, end = GetSize(sorted); begin < end; begin = end, end = GetSize(sorted)) {
+			for (int k = begin; k < end; k++) {
+				int n = sorted[k];
+				for (int e = succ_start[n]; e < succ_start[n+1]; e++)
+					if (--indegree[succ[e]] == 0) {
+						level[succ[e]] = num_levels + 1;
+						sorted.push_back(succ[e]);
+					}
+			}
+			num_levels++;
+		}
 
-		log_assert(GetSize(sorted) == GetSize(database));
-		return !found_loops;
+		num_sorted = GetSize(sorted);
+		found_loops = num_sorted < N;
+
+		if (!found_loops)
+			return true;
+
+		// Depth-first search over the predecessors of the remaining nodes,
+		// as in TopoSort::sort(). The sorted nodes are not visited again.
+		std::vector<int> pred_start(N+1), pred(GetSize(edges));
+		for (auto &e : edges)
+			pred_start[e.second + 1]++;
+		for (int i = 0; i < N; i++)
+			pred_start[i+1] += pred_start[i];
+		fill.assign(pred_start.begin(), pred_start.end() - 1);
+		for (auto &e : edges)
+			pred[fill[e.second]++] = e.first;
+
+		std::vector<bool> marked(N), active(N);
+		std::vector<std::pair<int, int>> stack;
+
+		for (int root = 0; root < N; root++)
+		{
+			if (level[root] >= 0 || marked[root])
+				continue;
+
+			active[root] = true;
+			stack.push_back(std::pair<int, int>(root, pred_start[root]));
+
+			while (!stack.empty())
+			{
+				int n = stack.back().first;
+				int p = stack.back().second;
+
+				if (p == pred_start[n+1]) {
+					stack.pop_back();
+					active[n] = false;
+					marked[n] = true;
+					sorted.push_back(n);
+					continue;
+				}
+
+				stack.back().second++;
+				int m = pred[p];
+
+				if (level[m] >= 0 || marked[m])
+					continue;
+
+				if (active[m]) {
+					if (analyze_loops) {
+						std::vector<int> loop;
+						for (int i = GetSize(stack)-1; i >= 0; i--) {
+							loop.push_back(stack[i].first);
+							if (stack[i].first == m)
+								break;
+						}
+						loops.push_back(loop);
+					}
+					continue;
+				}
+
+				active[m] = true;
+				stack.push_back(std::pair<int, int>(m, pred_start[m]));
+			}
+		}
+
+		return false;
 	}
 };
 
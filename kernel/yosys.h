@@ -190,6 +190,7 @@ struct shared_str {
 using hashlib::mkhash;
 using hashlib::mkhash_init;
 using hashlib::mkhash_add;
+using hashlib::mkhash_mix;
 using hashlib::mkhash_xorshift;
 using hashlib::hash_ops;
 using hashlib::hash_cstr_ops;
@@ -239,6 +240,14 @@ namespace hashlib {
 	template<> struct hash_ops<const RTLIL::Design*> : hash_obj_ops {};
 	template<> struct hash_ops<const RTLIL::Monitor*> : hash_obj_ops {};
 	template<> struct hash_ops<const AST::AstNode*> : hash_obj_ops {};
+
+	// most dicts keyed by IdString are the few ports, parameters and
+	// attributes of a single cell or wire, which a linear search handles
+	// fine without a hashtable of its own
+	template<> struct hash_layout<hash_ops<RTLIL::IdString>> {
+		static const bool open_addressing = hashtable_open_addressing;
+		static const int small_size = 8;
+	};
 }
 
 void memhasher_on();
@@ -129,35 +129,56 @@ struct CheckPass : public Pass {
 			log("checking module %s..\n", log_id(module));
 
 			SigMap sigmap(module);
-			dict<SigBit, vector<string>> wire_drivers;
+			dict<SigBit, vector<LogDeferred>> wire_drivers;
 			dict<SigBit, int> wire_drivers_count;
 			pool<SigBit> used_wires;
-			TopoSort<string> topo;
+			IntTopoSort topo;
+			vector<Cell*> topo_cells;
+			vector<SigBit> topo_bits;
+			dict<SigBit, int> topo_bit_nodes;
+
+			auto bit_node = [&](SigBit bit) {
+				auto it = topo_bit_nodes.find(bit);
+				if (it != topo_bit_nodes.end())
+					return it->second;
+				int n = topo.node();
+				topo_cells.push_back(nullptr);
+				topo_bits.push_back(bit);
+				topo_bit_nodes[bit] = n;
+				return n;
+			};
 
 			for (auto cell : module->cells())
-			for (auto &conn : cell->connections()) {
-				SigSpec sig = sigmap(conn.second);
-				bool logic_cell = yosys_celltypes.cell_evaluable(cell->type);
-				if (cell->input(conn.first))
-					for (auto bit : sig)
-						if (bit.wire) {
-							if (logic_cell)
-								topo.edge(stringf("wire %s", log_signal(bit)),
-										stringf("cell %s (%s)", log_id(cell), log_id(cell->type)));
-							used_wires.insert(bit);
+			{
+				int cell_node = -1;
+				if (yosys_celltypes.cell_evaluable(cell->type)) {
+					cell_node = topo.node();
+					topo_cells.push_back(cell);
+					topo_bits.push_back(SigBit());
+				}
+
+				for (auto &conn : cell->connections()) {
+					SigSpec sig = sigmap(conn.second);
+					if (cell->input(conn.first))
+						for (auto bit : sig)
+							if (bit.wire) {
+								if (cell_node >= 0)
+									topo.edge(bit_node(bit), cell_node);
+								used_wires.insert(bit);
+							}
+					if (cell->output(conn.first))
+						for (int i = 0; i < GetSize(sig); i++) {
+							if (sig[i].wire) {
+								if (cell_node >= 0)
+									topo.edge(cell_node, bit_node(sig[i]));
+								wire_drivers[sig[i]].push_back(log_defer("port %s[%d] of cell %s (%s)",
+										conn.first, i, cell->name, cell->type));
+							}
 						}
-				if (cell->output(conn.first))
-					for (int i = 0; i < GetSize(sig); i++) {
-						if (logic_cell)
-							topo.edge(stringf("cell %s (%s)", log_id(cell), log_id(cell->type)),
-									stringf("wire %s", log_signal(sig[i])));
-						if (sig[i].wire)
-							wire_drivers[sig[i]].push_back(stringf("port %s[%d] of cell %s (%s)",
-									log_id(conn.first), i, log_id(cell), log_id(cell->type)));
-					}
-				if (!cell->input(conn.first) && cell->output(conn.first))
-					for (auto bit : sig)
-						if (bit.wire) wire_drivers_count[bit]++;
+					if (!cell->input(conn.first) && cell->output(conn.first))
+						for (auto bit : sig)
+							if (bit.wire) wire_drivers_count[bit]++;
+				}
 			}
 
 			pool<SigBit> init_bits;
@@ -166,7 +187,7 @@ struct CheckPass : public Pass {
 				if (wire->port_input) {
 					SigSpec sig = sigmap(wire);
 					for (int i = 0; i < GetSize(sig); i++)
-						wire_drivers[sig[i]].push_back(stringf("module input %s[%d]", log_id(wire), i));
+						wire_drivers[sig[i]].push_back(log_defer("module input %s[%d]", wire->name, i));
 				}
 				if (wire->port_output)
 					for (auto bit : sigmap(wire))
@@ -186,11 +207,11 @@ struct CheckPass : public Pass {
 				}
 			}
 
-			for (auto it : wire_drivers)
+			for (auto &it : wire_drivers)
 				if (wire_drivers_count[it.first] > 1) {
 					string message = stringf("multiple conflicting drivers for %s.%s:\n", log_id(module), log_signal(it.first));
-					for (auto str : it.second)
-						message += stringf("    %s\n", str.c_str());
+					for (auto &msg : it.second)
+						message += stringf("    %s\n", msg.str().c_str());
 					log_warning("%s", message.c_str());
 					counter++;
 				}
@@ -201,8 +222,21 @@ struct CheckPass : public Pass {
 					counter++;
 				}
 
-			topo.sort();
-			for (auto &loop : topo.loops) {
+			// names are only needed for the nodes of the reported loops
+			std::set<std::set<string>> loops;
+			if (!topo.sort())
+				for (auto &loop : topo.loops) {
+					std::set<string> names;
+					for (int n : loop) {
+						if (topo_cells[n] != nullptr)
+							names.insert(stringf("cell %s (%s)", log_id(topo_cells[n]), log_id(topo_cells[n]->type)));
+						else
+							names.insert(stringf("wire %s", log_signal(topo_bits[n])));
+					}
+					loops.insert(names);
+				}
+
+			for (auto &loop : loops) {
 				string message = stringf("found logic loop in module %s:\n", log_id(module));
 				for (auto &str : loop)
 					message += stringf("    %s\n", str.c_str());
@@ -20,6 +20,7 @@
 #include "kernel/yosys.h"
 #include "kernel/celltypes.h"
 #include "kernel/sigtools.h"
+#include "passes/techmap/libparse.h"
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
@@ -30,15 +31,21 @@ struct LtpWorker
 	RTLIL::Module *module;
 	SigMap sigmap;
 
-	dict<SigBit, tuple<int, SigBit, Cell*>> bits;
-	dict<SigBit, dict<SigBit, Cell*>> bit2bits;
+	// Dense index of all bits in the timing graph. The fanout edges of bit i
+	// are edge_start[i] .. edge_start[i+1]-1 (compressed row storage).
+	idict<SigBit> bit_index;
+	vector<int> edge_start, edge_dst;
+	vector<Cell*> edge_cell;
+	vector<double> edge_delay;
+
 	dict<SigBit, tuple<SigBit, Cell*>> bit2ff;
 
-	int maxlvl;
-	SigBit maxbit;
-	pool<SigBit> busy;
+	vector<double> level;
+	vector<int> from;
+	vector<Cell*> via;
 
-	LtpWorker(RTLIL::Module *module, bool noff) : design(module->design), module(module), sigmap(module)
+	LtpWorker(RTLIL::Module *module, bool noff, const dict<IdString, double> &delays) :
+			design(module->design), module(module), sigmap(module)
 	{
 		CellTypes ff_celltypes;
 
@@ -49,7 +56,9 @@ struct LtpWorker
 
 		for (auto wire : module->selected_wires())
 			for (auto bit : sigmap(wire))
-				bits[bit] = tuple<int, SigBit, Cell*>(-1, State::Sx, nullptr);
+				bit_index(bit);
+
+		vector<tuple<int, int, Cell*, double>> edges;
 
 		for (auto cell : module->selected_cells())
 		{
@@ -57,6 +66,8 @@ struct LtpWorker
 
 			for (auto &conn : cell->connections())
 				for (auto bit : sigmap(conn.second)) {
+					if (bit.wire == nullptr)
+						continue;
 					if (cell->input(conn.first))
 						src_bits.insert(bit);
 					if (cell->output(conn.first))
@@ -72,73 +83,195 @@ struct LtpWorker
 				continue;
 			}
 
+			double delay = delays.count(cell->type) ? delays.at(cell->type) : 1.0;
+
 			for (auto s : src_bits)
 				for (auto d : dst_bits)
-					bit2bits[s][d] = cell;
+					edges.push_back(tuple<int, int, Cell*, double>(bit_index(s), bit_index(d), cell, delay));
 		}
 
-		maxlvl = -1;
-		maxbit = State::Sx;
+		int N = GetSize(bit_index);
+
+		edge_start.assign(N+1, 0);
+		for (auto &edge : edges)
+			edge_start[get<0>(edge) + 1]++;
+		for (int i = 0; i < N; i++)
+			edge_start[i+1] += edge_start[i];
+
+		edge_dst.resize(GetSize(edges));
+		edge_cell.resize(GetSize(edges));
+		edge_delay.resize(GetSize(edges));
+
+		vector<int> edge_fill(edge_start.begin(), edge_start.end() - 1);
+		for (auto &edge : edges) {
+			int e = edge_fill[get<0>(edge)]++;
+			edge_dst[e] = get<1>(edge);
+			edge_cell[e] = get<2>(edge);
+			edge_delay[e] = get<3>(edge);
+		}
 	}
 
-	void runner(SigBit bit, int level, SigBit from, Cell *via)
+	void compute_levels()
 	{
-		auto &bitinfo = bits.at(bit);
+		int N = GetSize(bit_index);
 
-		if (get<0>(bitinfo) >= level)
-			return;
+		level.assign(N, 0);
+		from.assign(N, -1);
+		via.assign(N, nullptr);
 
-		if (busy.count(bit) > 0) {
-			log_warning("Detected loop at %s in %s\n", log_signal(bit), log_id(module));
-			return;
-		}
+		vector<int> indegree(N);
+		for (int dst : edge_dst)
+			indegree[dst]++;
 
-		busy.insert(bit);
-		get<0>(bitinfo) = level;
-		get<1>(bitinfo) = from;
-		get<2>(bitinfo) = via;
+		vector<bool> scheduled(N);
+		vector<int> queue;
+		queue.reserve(N);
 
-		if (level > maxlvl) {
-			maxlvl = level;
-			maxbit = bit;
-		}
+		for (int i = 0; i < N; i++)
+			if (indegree[i] == 0) {
+				scheduled[i] = true;
+				queue.push_back(i);
+			}
 
-		if (bit2bits.count(bit)) {
-			for (auto &it : bit2bits.at(bit))
-				runner(it.first, level+1, bit, it.second);
-		}
+		// Visit bits in topological order, so that each bit is final before
+		// its fanout is relaxed. When the queue runs dry, all remaining bits
+		// are on or behind a loop, which is broken at the next unscheduled bit.
+
+		int loop_cursor = 0;
 
-		busy.erase(bit);
+		for (int qptr = 0; qptr < N; qptr++)
+		{
+			if (qptr == GetSize(queue)) {
+				while (scheduled[loop_cursor])
+					loop_cursor++;
+				log_warning("Detected loop at %s in %s\n", log_signal(bit_index[loop_cursor]), log_id(module));
+				scheduled[loop_cursor] = true;
+				queue.push_back(loop_cursor);
+			}
+
+			int i = queue[qptr];
+
+			for (int e = edge_start[i]; e < edge_start[i+1]; e++)
+			{
+				int j = edge_dst[e];
+				if (scheduled[j])
+					continue;
+
+				double l = level[i] + edge_delay[e];
+				if (from[j] < 0 || l > level[j]) {
+					level[j] = l;
+					from[j] = i;
+					via[j] = edge_cell[e];
+				}
+
+				if (--indegree[j] == 0) {
+					scheduled[j] = true;
+					queue.push_back(j);
+				}
+			}
+		}
 	}
 
-	void printpath(SigBit bit)
+	void printpath(int idx)
 	{
-		auto &bitinfo = bits.at(bit);
-		if (get<2>(bitinfo)) {
-			printpath(get<1>(bitinfo));
-			log("%5d: %s (via %s)\n", get<0>(bitinfo), log_signal(bit), log_id(get<2>(bitinfo)));
-		} else {
-			log("%5d: %s\n", get<0>(bitinfo), log_signal(bit));
+		vector<int> path;
+		for (int i = idx; i >= 0; i = from[i])
+			path.push_back(i);
+
+		for (int k = GetSize(path)-1; k >= 0; k--) {
+			int i = path[k];
+			if (via[i])
+				log("%5g: %s (via %s)\n", level[i], log_signal(bit_index[i]), log_id(via[i]));
+			else
+				log("%5g: %s\n", level[i], log_signal(bit_index[i]));
 		}
+
+		SigBit bit = bit_index[idx];
+		if (bit2ff.count(bit))
+			log("%5s: %s (via %s)\n", "ff", log_signal(get<0>(bit2ff.at(bit))), log_id(get<1>(bit2ff.at(bit))));
 	}
 
-	void run()
+	void run(int num_paths)
 	{
-		for (auto &it : bits)
-			if (get<0>(it.second) < 0)
-				runner(it.first, 0, State::Sx, nullptr);
+		compute_levels();
+
+		// Report the paths ending in the bits without fanout, so that no
+		// reported path is a prefix of another one.
+
+		vector<int> endpoints;
+		for (int i = 0; i < GetSize(bit_index); i++)
+			if (edge_start[i] == edge_start[i+1])
+				endpoints.push_back(i);
+
+		if (endpoints.empty())
+			for (int i = 0; i < GetSize(bit_index); i++)
+				endpoints.push_back(i);
+
+		num_paths = min(num_paths, GetSize(endpoints));
+		std::partial_sort(endpoints.begin(), endpoints.begin() + num_paths, endpoints.end(), [&](int a, int b) {
+			return level[a] != level[b] ? level[a] > level[b] : a < b;
+		});
 
 		log("\n");
-		log("Longest topological path in %s (length=%d):\n", log_id(module), maxlvl);
 
-		if (maxlvl >= 0)
-			printpath(maxbit);
+		if (num_paths == 0) {
+			log("Longest topological path in %s (length=-1):\n", log_id(module));
+			return;
+		}
 
-		if (bit2ff.count(maxbit))
-			log("%5s: %s (via %s)\n", "ff", log_signal(get<0>(bit2ff.at(maxbit))), log_id(get<1>(bit2ff.at(maxbit))));
+		for (int k = 0; k < num_paths; k++) {
+			if (k == 0)
+				log("Longest topological path in %s (length=%g):\n", log_id(module), level[endpoints[k]]);
+			else
+				log("\nLongest topological path #%d in %s (length=%g):\n", k+1, log_id(module), level[endpoints[k]]);
+			printpath(endpoints[k]);
+		}
 	}
 };
 
+void read_liberty_celldelay(dict<IdString, double> &cell_delay, string liberty_file)
+{
+	std::ifstream f;
+	f.open(liberty_file.c_str());
+	yosys_input_files.insert(liberty_file);
+	if (f.fail())
+		log_cmd_error("Can't open liberty file `%s': %s\n", liberty_file.c_str(), strerror(errno));
+	LibertyParser libparser(f);
+	f.close();
+
+	// Only the scalar intrinsic_rise/intrinsic_fall attributes of the timing
+	// groups are used. The cell delay is the worst case over all its arcs.
+	for (auto cell : libparser.ast->children)
+	{
+		if (cell->id != "cell" || cell->args.size() != 1)
+			continue;
+
+		bool found = false;
+		double delay = 0;
+
+		for (auto pin : cell->children)
+		{
+			if (pin->id != "pin")
+				continue;
+
+			for (auto timing : pin->children)
+			{
+				if (timing->id != "timing")
+					continue;
+
+				for (auto attr : timing->children)
+					if ((attr->id == "intrinsic_rise" || attr->id == "intrinsic_fall") && !attr->value.empty()) {
+						delay = max(delay, atof(attr->value.c_str()));
+						found = true;
+					}
+			}
+		}
+
+		if (found)
+			cell_delay["\\" + cell->args[0]] = delay;
+	}
+}
+
 struct LtpPass : public Pass {
 	LtpPass() : Pass("ltp", "print longest topological path") { }
 	void help() YS_OVERRIDE
@@ -153,10 +286,24 @@ struct LtpPass : public Pass {
 		log("    -noff\n");
 		log("        automatically exclude FF cell types\n");
 		log("\n");
+		log("    -paths <num>\n");
+		log("        print the <num> longest paths (ending in different bits) instead of\n");
+		log("        just the longest one\n");
+		log("\n");
+		log("    -delay <cell_type> <value>\n");
+		log("        use the given delay for cells of the given type. (the default delay\n");
+		log("        is 1, i.e. the path length is the number of cells on the path.)\n");
+		log("\n");
+		log("    -liberty <liberty_file>\n");
+		log("        use the largest intrinsic_rise/intrinsic_fall value of each cell in\n");
+		log("        the liberty file as delay for that cell type\n");
+		log("\n");
 	}
 	void execute(std::vector<std::string> args, RTLIL::Design *design) YS_OVERRIDE
 	{
 		bool noff = false;
+		int num_paths = 1;
+		dict<IdString, double> delays;
 
 		log_header(design, "Executing LTP pass (find longest path).\n");
 
@@ -166,6 +313,23 @@ struct LtpPass : public Pass {
 				noff = true;
 				continue;
 			}
+			if (args[argidx] == "-paths" && argidx+1 < args.size()) {
+				num_paths = atoi(args[++argidx].c_str());
+				if (num_paths < 1)
+					log_cmd_error("Invalid number of paths: %s\n", args[argidx].c_str());
+				continue;
+			}
+			if (args[argidx] == "-delay" && argidx+2 < args.size()) {
+				IdString cell_type = RTLIL::escape_id(args[++argidx]);
+				delays[cell_type] = atof(args[++argidx].c_str());
+				continue;
+			}
+			if (args[argidx] == "-liberty" && argidx+1 < args.size()) {
+				string liberty_file = args[++argidx];
+				rewrite_filename(liberty_file);
+				read_liberty_celldelay(delays, liberty_file);
+				continue;
+			}
 			break;
 		}
 
@@ -176,8 +340,8 @@ struct LtpPass : public Pass {
 			if (module->has_processes_warn())
 				continue;
 
-			LtpWorker worker(module, noff);
-			worker.run();
+			LtpWorker worker(module, noff, delays);
+			worker.run(num_paths);
 		}
 	}
 } LtpPass;
@@ -203,6 +203,26 @@ struct QwpWorker
 		}
 	}
 
+	// Symmetric sparse matrix in compressed row storage. The diagonal is
+	// kept in a separate vector, doubling as the Jacobi preconditioner.
+	struct SparseMatrix
+	{
+		int N;
+		vector<double> diag;
+		vector<int> row_start, col_idx;
+		vector<double> values;
+
+		void multiply(const vector<double> &x, vector<double> &y) const
+		{
+			for (int i = 0; i < N; i++) {
+				double sum = diag[i] * x[i];
+				for (int k = row_start[i]; k < row_start[i+1]; k++)
+					sum += values[k] * x[col_idx[k]];
+				y[i] = sum;
+			}
+		}
+	};
+
 	void solve(bool alt_mode = false)
 	{
 		// A := constraint_matrix
@@ -211,18 +231,36 @@ struct QwpWorker
 		// AA = A' * A
 		// Ay = A' * y
 		//
-		// M := [AA Ay]
+		// AA is a weighted graph Laplacian plus a positive diagonal, i.e. it
+		// is sparse, symmetric and positive definite.
 
 		if (config.verbose)
 			log("> System size: %d^2\n", GetSize(nodes));
 
-		// Row major order
-		int N = GetSize(nodes), N1 = N+1;
-		vector<double> M(N * N1);
+		int N = GetSize(nodes);
+
+		SparseMatrix AA;
+		AA.N = N;
+		AA.diag.assign(N, 0.0);
+		AA.row_start.assign(N+1, 0);
+
+		vector<double> Ay(N);
 
 		if (config.verbose)
 			log("> Edge constraints: %d\n", GetSize(edges));
 
+		for (auto &edge : edges) {
+			AA.row_start[edge.first.first + 1]++;
+			AA.row_start[edge.first.second + 1]++;
+		}
+
+		for (int i = 0; i < N; i++)
+			AA.row_start[i+1] += AA.row_start[i];
+
+		AA.col_idx.resize(AA.row_start[N]);
+		AA.values.resize(AA.row_start[N]);
+		vector<int> row_fill(AA.row_start.begin(), AA.row_start.end() - 1);
+
 		// Edge constraints:
 		//   A[i,:] := [ 0 0 .... 0 weight 0 ... 0 -weight 0 ... 0 0], y[i] := 0
 		//
@@ -233,11 +271,14 @@ struct QwpWorker
 			int idx2 = edge.first.second;
 			double weight = edge.second * (1.0 + xorshift32() * 1e-3);
 
-			M[idx1 + idx1*N1] += weight * weight;
-			M[idx2 + idx2*N1] += weight * weight;
+			AA.diag[idx1] += weight * weight;
+			AA.diag[idx2] += weight * weight;
 
-			M[idx1 + idx2*N1] += -weight * weight;
-			M[idx2 + idx1*N1] += -weight * weight;
+			AA.col_idx[row_fill[idx1]] = idx2;
+			AA.values[row_fill[idx1]++] = -weight * weight;
+
+			AA.col_idx[row_fill[idx2]] = idx1;
+			AA.values[row_fill[idx2]++] = -weight * weight;
 		}
 
 		if (config.verbose)
@@ -261,16 +302,17 @@ struct QwpWorker
 				weight = 1e3;
 			weight *= (1.0 + xorshift32() * 1e-3);
 
-			M[idx + idx*N1] += weight * weight;
-			M[N + idx*N1] += rhs * weight * weight;
+			AA.diag[idx] += weight * weight;
+			Ay[idx] += rhs * weight * weight;
 		}
 
 #ifdef LOG_MATRICES
 		log("\n");
 		for (int i = 0; i < N; i++) {
-			for (int j = 0; j < N+1; j++)
-				log(" %10.2e", M[(N+1)*i + j]);
-			log("\n");
+			log(" [%d] %10.2e", i, AA.diag[i]);
+			for (int k = AA.row_start[i]; k < AA.row_start[i+1]; k++)
+				log(" [%d] %10.2e", AA.col_idx[k], AA.values[k]);
+			log(" | %10.2e\n", Ay[i]);
 		}
 #endif
 
@@ -280,79 +322,60 @@ struct QwpWorker
 		// Solve "AA*x = Ay"
 		// (least squares fit for "A*x = y")
 		//
-		// Using gaussian elimination to get M := [Id x]
+		// Using the conjugate gradient method with a Jacobi preconditioner,
+		// starting from the current node positions.
 
-		vector<int> pivot_cache;
-		vector<int> queue;
+		vector<double> x(N), res(N), z(N), p(N), q(N);
+		double rz = 0, yy = 0;
 
 		for (int i = 0; i < N; i++)
-			queue.push_back(i);
+			x[i] = alt_mode ? nodes[i].alt_pos : nodes[i].pos;
 
-		// gaussian elimination
-		for (int i = 0; i < N; i++)
-		{
-			if (config.verbose && N > 15 && ((i+1) % (N/15)) == 0)
-				log("> Solved %d%%: %d/%d\n", (100*(i+1))/N, i+1, N);
-
-			// find best row
-			int best_row = queue.front();
-			int best_row_queue_idx = 0;
-			double best_row_absval = 0;
-
-			for (int k = 0; k < GetSize(queue); k++) {
-				int row = queue[k];
-				double absval = fabs(M[i + row*N1]);
-				if (absval > best_row_absval) {
-					best_row = row;
-					best_row_queue_idx = k;
-					best_row_absval = absval;
-				}
-			}
+		AA.multiply(x, q);
 
-			int row = best_row;
-			pivot_cache.push_back(row);
+		for (int i = 0; i < N; i++) {
+			res[i] = Ay[i] - q[i];
+			z[i] = res[i] / AA.diag[i];
+			p[i] = z[i];
+			rz += res[i] * z[i];
+			yy += Ay[i] * Ay[i] / AA.diag[i];
+		}
 
-			queue[best_row_queue_idx] = queue.back();
-			queue.pop_back();
+		// Convergence is checked on the preconditioned residual, so that the
+		// loosely constrained nodes are not drowned out by the tied ones.
+		double tolerance = 1e-20 * yy;
+		int max_iter = 100 + 10*N, iter;
 
-			// normalize row
-			for (int k = i+1; k < N1; k++)
-				M[k + row*N1] /= M[i + row*N1];
-			M[i + row*N1] = 1.0;
+		for (iter = 0; iter < max_iter && rz > tolerance; iter++)
+		{
+			AA.multiply(p, q);
 
-			// elimination
-			for (int other_row : queue) {
-				double d = M[i + other_row*N1];
-				for (int k = i+1; k < N1; k++)
-					M[k + other_row*N1] -= d*M[k + row*N1];
-				M[i + other_row*N1] = 0.0;
+			double pq = 0;
+			for (int i = 0; i < N; i++)
+				pq += p[i] * q[i];
+
+			double alpha = rz / pq;
+			double new_rz = 0;
+
+			for (int i = 0; i < N; i++) {
+				x[i] += alpha * p[i];
+				res[i] -= alpha * q[i];
+				z[i] = res[i] / AA.diag[i];
+				new_rz += res[i] * z[i];
 			}
-		}
 
-		if (config.verbose)
-			log("> Solved\n");
+			double beta = new_rz / rz;
+			rz = new_rz;
 
-		log_assert(queue.empty());
-		log_assert(GetSize(pivot_cache) == N);
+			for (int i = 0; i < N; i++)
+				p[i] = z[i] + beta * p[i];
 
-		// back substitution
-		for (int i = N-1; i >= 0; i--)
-		for (int j = i+1; j < N; j++)
-		{
-			int row = pivot_cache[i];
-			int other_row = pivot_cache[j];
-			M[N + row*N1] -= M[j + row*N1] * M[N + other_row*N1];
-			M[j + row*N1] = 0.0;
+			if (config.verbose && ((iter+1) % 1000) == 0)
+				log("> Iteration %d: residual %.2e\n", iter+1, sqrt(rz));
 		}
 
-#ifdef LOG_MATRICES
-		log("\n");
-		for (int i = 0; i < N; i++) {
-			for (int j = 0; j < N+1; j++)
-				log(" %10.2e", M[(N+1)*i + j]);
-			log("\n");
-		}
-#endif
+		if (config.verbose)
+			log("> Solved after %d iterations, residual %.2e\n", iter, sqrt(rz));
 
 		if (config.verbose)
 			log("> Update nodes\n");
@@ -360,7 +383,7 @@ struct QwpWorker
 		// update node positions
 		for (int i = 0; i < N; i++)
 		{
-			double v = M[(N+1)*i + N];
+			double v = x[i];
 			double c = alt_mode ? alt_midpos : midpos;
 			double r = alt_mode ? alt_radius : radius;
 
@@ -804,8 +827,9 @@ struct QwpPass : public Pass {
 		log("    -v\n");
 		log("        Verbose solver output for profiling or debugging\n");
 		log("\n");
-		log("Note: This implementation of a quadratic wirelength placer uses exact\n");
-		log("dense matrix operations. It is only a toy-placer for small circuits.\n");
+		log("Note: This implementation of a quadratic wirelength placer solves the sparse\n");
+		log("least-squares problem with a preconditioned conjugate gradient method. It is\n");
+		log("meant as a quick floorplanning estimate, not as a production placer.\n");
 		log("\n");
 	}
 	void execute(std::vector<std::string> args, RTLIL::Design *design) YS_OVERRIDE
@@ -17,17 +17,13 @@
  *
  */
 
-// [[CITE]] Tarjan's strongly connected components algorithm
-// Tarjan, R. E. (1972), "Depth-first search and linear graph algorithms", SIAM Journal on Computing 1 (2): 146-160, doi:10.1137/0201010
-// http://en.wikipedia.org/wiki/Tarjan's_strongly_connected_components_algorithm
-
 #include "kernel/register.h"
 #include "kernel/celltypes.h"
 #include "kernel/sigtools.h"
+#include "kernel/scc.h"
 #include "kernel/log.h"
 #include <stdlib.h>
 #include <stdio.h>
-#include <set>
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
@@ -39,66 +35,8 @@ struct SccWorker
 	SigMap sigmap;
 	CellTypes ct;
 
-	std::set<RTLIL::Cell*> workQueue;
-	std::map<RTLIL::Cell*, std::set<RTLIL::Cell*>> cellToNextCell;
-	std::map<RTLIL::Cell*, RTLIL::SigSpec> cellToPrevSig, cellToNextSig;
-
-	std::map<RTLIL::Cell*, std::pair<int, int>> cellLabels;
-	std::map<RTLIL::Cell*, int> cellDepth;
-	std::set<RTLIL::Cell*> cellsOnStack;
-	std::vector<RTLIL::Cell*> cellStack;
-	int labelCounter;
-
-	std::map<RTLIL::Cell*, int> cell2scc;
-	std::vector<std::set<RTLIL::Cell*>> sccList;
-
-	void run(RTLIL::Cell *cell, int depth, int maxDepth)
-	{
-		log_assert(workQueue.count(cell) > 0);
-
-		workQueue.erase(cell);
-		cellLabels[cell] = std::pair<int, int>(labelCounter, labelCounter);
-		labelCounter++;
-
-		cellsOnStack.insert(cell);
-		cellStack.push_back(cell);
-
-		if (maxDepth >= 0)
-			cellDepth[cell] = depth;
-
-		for (auto nextCell : cellToNextCell[cell])
-			if (cellLabels.count(nextCell) == 0) {
-				run(nextCell, depth+1, maxDepth);
-				cellLabels[cell].second = min(cellLabels[cell].second, cellLabels[nextCell].second);
-			} else
-			if (cellsOnStack.count(nextCell) > 0 && (maxDepth < 0 || cellDepth[nextCell] + maxDepth > depth)) {
-					cellLabels[cell].second = min(cellLabels[cell].second, cellLabels[nextCell].second);
-			}
-
-		if (cellLabels[cell].first == cellLabels[cell].second)
-		{
-			if (cellStack.back() == cell)
-			{
-				cellStack.pop_back();
-				cellsOnStack.erase(cell);
-			}
-			else
-			{
-				log("Found an SCC:");
-				std::set<RTLIL::Cell*> scc;
-				while (cellsOnStack.count(cell) > 0) {
-					RTLIL::Cell *c = cellStack.back();
-					cellStack.pop_back();
-					cellsOnStack.erase(c);
-					log(" %s", RTLIL::id2cstr(c->name));
-					cell2scc[c] = sccList.size();
-					scc.insert(c);
-				}
-				sccList.push_back(scc);
-				log("\n");
-			}
-		}
-	}
+	dict<RTLIL::Cell*, RTLIL::SigSpec> cellToPrevSig, cellToNextSig;
+	std::vector<pool<RTLIL::Cell*>> sccList;
 
 	SccWorker(RTLIL::Design *design, RTLIL::Module *module, bool nofeedbackMode, bool allCellTypes, int maxDepth) :
 			design(design), module(module), sigmap(module)
@@ -116,23 +54,17 @@ struct SccWorker
 		}
 
 		SigPool selectedSignals;
-		SigSet<RTLIL::Cell*> sigToNextCells;
+		SccCellGraph graph;
 
-		for (auto &it : module->wires_)
-			if (design->selected(module, it.second))
-				selectedSignals.add(sigmap(RTLIL::SigSpec(it.second)));
+		for (auto wire : module->selected_wires())
+			selectedSignals.add(sigmap(RTLIL::SigSpec(wire)));
 
-		for (auto &it : module->cells_)
+		for (auto cell : module->selected_cells())
 		{
-			RTLIL::Cell *cell = it.second;
-
-			if (!design->selected(module, cell))
-				continue;
-
 			if (!allCellTypes && !ct.cell_known(cell->type))
 				continue;
 
-			workQueue.insert(cell);
+			graph.add_cell(cell);
 
 			RTLIL::SigSpec inputSignals, outputSignals;
 
@@ -157,36 +89,42 @@ struct SccWorker
 			inputSignals.sort_and_unify();
 			outputSignals.sort_and_unify();
 
+			for (auto bit : inputSignals)
+				graph.add_user(cell, bit);
+			for (auto bit : outputSignals)
+				graph.add_driver(cell, bit);
+
 			cellToPrevSig[cell] = inputSignals;
 			cellToNextSig[cell] = outputSignals;
-			sigToNextCells.insert(inputSignals, cell);
 		}
 
-		for (auto cell : workQueue)
+		graph.find(maxDepth);
+
+		if (!nofeedbackMode)
 		{
-			cellToNextCell[cell] = sigToNextCells.find(cellToNextSig[cell]);
-
-			if (!nofeedbackMode && cellToNextCell[cell].count(cell)) {
-				log("Found an SCC:");
-				std::set<RTLIL::Cell*> scc;
-				log(" %s", RTLIL::id2cstr(cell->name));
-				cell2scc[cell] = sccList.size();
-				scc.insert(cell);
-				sccList.push_back(scc);
-				log("\n");
+			for (int i = 0; i < GetSize(graph.cells); i++)
+			{
+				if (!graph.graph.self_loop[i])
+					continue;
+
+				log("Found an SCC: %s\n", RTLIL::id2cstr(graph.cells[i]->name));
+				sccList.push_back(pool<RTLIL::Cell*>{graph.cells[i]});
 			}
 		}
 
-		labelCounter = 0;
-		cellLabels.clear();
-
-		while (!workQueue.empty())
+		for (auto &scc : graph.graph.sccs)
 		{
-			RTLIL::Cell *cell = *workQueue.begin();
-			log_assert(cellStack.size() == 0);
-			cellDepth.clear();
+			if (GetSize(scc) < 2)
+				continue;
 
-			run(cell, 0, maxDepth);
+			log("Found an SCC:");
+			pool<RTLIL::Cell*> cells;
+			for (int i : scc) {
+				log(" %s", RTLIL::id2cstr(graph.cells[i]->name));
+				cells.insert(graph.cells[i]);
+			}
+			sccList.push_back(cells);
+			log("\n");
 		}
 
 		log("Found %d SCCs in module %s.\n", int(sccList.size()), RTLIL::id2cstr(module->name));
@@ -196,7 +134,7 @@ struct SccWorker
 	{
 		for (int i = 0; i < int(sccList.size()); i++)
 		{
-			std::set<RTLIL::Cell*> &cells = sccList[i];
+			pool<RTLIL::Cell*> &cells = sccList[i];
 			RTLIL::SigSpec prevsig, nextsig, sig;
 
 			for (auto cell : cells) {
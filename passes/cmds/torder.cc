@@ -20,7 +20,7 @@
 #include "kernel/yosys.h"
 #include "kernel/celltypes.h"
 #include "kernel/sigtools.h"
-#include "kernel/utils.h"
+#include "kernel/scc.h"
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
@@ -71,10 +71,13 @@ struct TorderPass : public Pass {
 			log("module %s\n", log_id(module));
 
 			SigMap sigmap(module);
-			dict<SigBit, pool<IdString>> bit_drivers, bit_users;
-			TopoSort<IdString, RTLIL::sort_by_id_str> toposort;
+			SccCellGraph graph;
 
-			for (auto cell : module->selected_cells())
+			// The cells are numbered by name, see the edges below.
+			std::vector<RTLIL::Cell*> cells = module->selected_cells();
+			std::sort(cells.begin(), cells.end(), [](RTLIL::Cell *a, RTLIL::Cell *b) { return RTLIL::sort_by_id_str()(a->name, b->name); });
+
+			for (auto cell : cells)
 			for (auto conn : cell->connections())
 			{
 				if (stop_db.count(cell->type) && stop_db.at(cell->type).count(conn.first))
@@ -89,33 +92,50 @@ struct TorderPass : public Pass {
 
 				if (cell->input(conn.first))
 					for (auto bit : sigmap(conn.second))
-						bit_users[bit].insert(cell->name);
+						graph.add_user(cell, bit);
 
 				if (cell->output(conn.first))
 					for (auto bit : sigmap(conn.second))
-						bit_drivers[bit].insert(cell->name);
+						graph.add_driver(cell, bit);
+
+				graph.add_cell(cell);
+			}
 
-				toposort.node(cell->name);
+			// With edges from each cell to the cells driving it, the post-order
+			// of the SCC search lists drivers before users, with ties broken by
+			// cell name, so the order does not depend on the order in which the
+			// cells were created.
+			for (auto &it : graph.bit_users) {
+				auto drivers = graph.bit_drivers.find(it.first);
+				if (drivers == graph.bit_drivers.end())
+					continue;
+				for (int user : it.second)
+				for (int driver : drivers->second)
+					graph.graph.edge(user, driver);
 			}
 
-			for (auto &it : bit_users)
-				if (bit_drivers.count(it.first))
-					for (auto driver_cell : bit_drivers.at(it.first))
-					for (auto user_cell : it.second)
-						toposort.edge(driver_cell, user_cell);
+			graph.graph.find();
 
-			toposort.analyze_loops = true;
-			toposort.sort();
+			std::set<std::set<IdString, RTLIL::sort_by_id_str>> loops;
+
+			for (auto &scc : graph.graph.sccs) {
+				if (!graph.graph.in_loop(scc.front()))
+					continue;
+				std::set<IdString, RTLIL::sort_by_id_str> loop;
+				for (int i : scc)
+					loop.insert(graph.cells[i]->name);
+				loops.insert(loop);
+			}
 
-			for (auto &it : toposort.loops) {
+			for (auto &it : loops) {
 				log("  loop");
 				for (auto cell : it)
 					log(" %s", log_id(cell));
 				log("\n");
 			}
 
-			for (auto cell : toposort.sorted)
-					log("  cell %s\n", log_id(cell));
+			for (int n : graph.graph.postorder)
+					log("  cell %s\n", log_id(graph.cells[n]));
 		}
 	}
 } TorderPass;
@@ -123,16 +123,16 @@ static bool find_states(RTLIL::SigSpec sig, const RTLIL::SigSpec &dff_out, RTLIL
 	return true;
 }
 
-static RTLIL::Const sig2const(ConstEval &ce, RTLIL::SigSpec sig, RTLIL::State noconst_state, RTLIL::SigSpec dont_care = RTLIL::SigSpec())
+static RTLIL::Const sig2const(ConstEval &ce, RTLIL::SigSpec sig, RTLIL::State noconst_state, const pool<RTLIL::SigBit> *dont_care = nullptr)
 {
-	if (dont_care.size() > 0) {
+	if (dont_care != nullptr && !dont_care->empty()) {
 		for (int i = 0; i < GetSize(sig); i++)
-			if (dont_care.extract(sig[i]).size() > 0)
+			if (dont_care->count(sig[i]))
 				sig[i] = noconst_state;
 	}
 
 	ce.assign_map.apply(sig);
-	ce.values_map.apply(sig);
+	ce.apply_values(sig);
 
 	for (int i = 0; i < GetSize(sig); i++)
 		if (sig[i].wire != NULL)
@@ -141,7 +141,8 @@ static RTLIL::Const sig2const(ConstEval &ce, RTLIL::SigSpec sig, RTLIL::State no
 	return sig.as_const();
 }
 
-static void find_transitions(ConstEval &ce, ConstEval &ce_nostop, FsmData &fsm_data, std::map<RTLIL::Const, int> &states, int state_in, RTLIL::SigSpec ctrl_in, RTLIL::SigSpec ctrl_out, RTLIL::SigSpec dff_in, RTLIL::SigSpec dont_care)
+static void find_transitions(ConstEval &ce, ConstEval &ce_nostop, FsmData &fsm_data, std::map<RTLIL::Const, int> &states, int state_in,
+		const RTLIL::SigSpec &ctrl_in, const dict<RTLIL::SigBit, int> &ctrl_in_bit_indices, RTLIL::SigSpec ctrl_out, RTLIL::SigSpec dff_in, pool<RTLIL::SigBit> &dont_care)
 {
 	bool undef_bit_in_next_state_mode = false;
 	RTLIL::SigSpec undef, constval;
@@ -160,13 +161,9 @@ undef_bit_in_next_state:
 		log_assert(ctrl_out.is_fully_const() && dff_in.is_fully_const());
 
 		FsmData::transition_t tr;
-		tr.ctrl_in = sig2const(ce, ctrl_in, RTLIL::State::Sa, dont_care);
+		tr.ctrl_in = sig2const(ce, ctrl_in, RTLIL::State::Sa, &dont_care);
 		tr.ctrl_out = sig2const(ce, ctrl_out, RTLIL::State::Sx);
 
-		std::map<RTLIL::SigBit, int> ctrl_in_bit_indices;
-		for (int i = 0; i < GetSize(ctrl_in); i++)
-			ctrl_in_bit_indices[ctrl_in[i]] = i;
-
 		for (auto &it : ctrl_in_bit_indices)
 			if (tr.ctrl_in.bits.at(it.second) == State::S1 && exclusive_ctrls.count(it.first) != 0)
 				for (auto &dc_bit : exclusive_ctrls.at(it.first))
@@ -177,16 +174,19 @@ undef_bit_in_next_state:
 		if (state_in >= 0)
 			log_state_in = fsm_data.state_table.at(state_in);
 
-		if (states.count(ce.values_map(ce.assign_map(dff_in)).as_const()) == 0) {
+		RTLIL::Const next_state = ce.values(ce.assign_map(dff_in)).as_const();
+		auto next_state_it = states.find(next_state);
+
+		if (next_state_it == states.end()) {
 			log("  transition: %10s %s -> INVALID_STATE(%s) %s  <ignored invalid transition!>%s\n",
 					log_signal(log_state_in), log_signal(tr.ctrl_in),
-					log_signal(ce.values_map(ce.assign_map(dff_in))), log_signal(tr.ctrl_out),
+					log_signal(next_state), log_signal(tr.ctrl_out),
 					undef_bit_in_next_state_mode ? " SHORTENED" : "");
 			return;
 		}
 
 		tr.state_in = state_in;
-		tr.state_out = states.at(ce.values_map(ce.assign_map(dff_in)).as_const());
+		tr.state_out = next_state_it->second;
 
 		if (dff_in.is_fully_def()) {
 			fsm_data.transition_table.push_back(tr);
@@ -206,7 +206,7 @@ undef_bit_in_next_state:
 			goto undef_bit_in_next_state;
 
 	log_assert(undef.size() > 0);
-	log_assert(ce.stop_signals.check_all(undef));
+	log_assert(ce.all_stopped(undef));
 
 	undef = undef.extract(0, 1);
 	constval = undef;
@@ -214,7 +214,7 @@ undef_bit_in_next_state:
 	if (ce_nostop.eval(constval))
 	{
 		ce.push();
-		dont_care.append(undef);
+		bool new_dont_care = dont_care.insert(undef.as_bit()).second;
 		ce.set(undef, constval.as_const());
 		if (exclusive_ctrls.count(undef) && constval == State::S1)
 			for (auto &bit : exclusive_ctrls.at(undef)) {
@@ -224,8 +224,10 @@ undef_bit_in_next_state:
 				else
 					ce.set(bit, State::S0);
 			}
-		find_transitions(ce, ce_nostop, fsm_data, states, state_in, ctrl_in, ctrl_out, dff_in, dont_care);
+		find_transitions(ce, ce_nostop, fsm_data, states, state_in, ctrl_in, ctrl_in_bit_indices, ctrl_out, dff_in, dont_care);
 	found_contradiction_1:
+		if (new_dont_care)
+			dont_care.erase(undef.as_bit());
 		ce.pop();
 	}
 	else
@@ -233,7 +235,7 @@ undef_bit_in_next_state:
 		ce.push(), ce_nostop.push();
 		ce.set(undef, State::S0);
 		ce_nostop.set(undef, State::S0);
-		find_transitions(ce, ce_nostop, fsm_data, states, state_in, ctrl_in, ctrl_out, dff_in, dont_care);
+		find_transitions(ce, ce_nostop, fsm_data, states, state_in, ctrl_in, ctrl_in_bit_indices, ctrl_out, dff_in, dont_care);
 		ce.pop(), ce_nostop.pop();
 
 		ce.push(), ce_nostop.push();
@@ -247,7 +249,7 @@ undef_bit_in_next_state:
 				else
 					ce.set(bit, State::S0), ce_nostop.set(bit, RTLIL::S0);
 			}
-		find_transitions(ce, ce_nostop, fsm_data, states, state_in, ctrl_in, ctrl_out, dff_in, dont_care);
+		find_transitions(ce, ce_nostop, fsm_data, states, state_in, ctrl_in, ctrl_in_bit_indices, ctrl_out, dff_in, dont_care);
 	found_contradiction_2:
 		ce.pop(), ce_nostop.pop();
 	}
@@ -356,13 +358,18 @@ static void extract_fsm(RTLIL::Wire *wire)
 
 	// Create transition table
 
+	dict<RTLIL::SigBit, int> ctrl_in_bit_indices;
+	for (int i = 0; i < GetSize(ctrl_in); i++)
+		ctrl_in_bit_indices[ctrl_in[i]] = i;
+
 	ConstEval ce(module), ce_nostop(module);
 	ce.stop(ctrl_in);
 	for (int state_idx = 0; state_idx < int(fsm_data.state_table.size()); state_idx++) {
+		pool<RTLIL::SigBit> dont_care;
 		ce.push(), ce_nostop.push();
 		ce.set(dff_out, fsm_data.state_table[state_idx]);
 		ce_nostop.set(dff_out, fsm_data.state_table[state_idx]);
-		find_transitions(ce, ce_nostop, fsm_data, states, state_idx, ctrl_in, ctrl_out, dff_in, RTLIL::SigSpec());
+		find_transitions(ce, ce_nostop, fsm_data, states, state_idx, ctrl_in, ctrl_in_bit_indices, ctrl_out, dff_in, dont_care);
 		ce.pop(), ce_nostop.pop();
 	}
 
@@ -259,6 +259,120 @@ struct FsmOpt
 		set.swap(new_set);
 	}
 
+	// Input patterns as bit vectors, 64 inputs per word: the value words
+	// followed by the don't-care words. Don't-care bits have a value of 0.
+	// Only patterns whose don't-care bits are all Sa (as created by
+	// fsm_extract) can be represented, so that the conversion is exact.
+	typedef std::vector<uint64_t> cube_t;
+
+	int cube_words() const
+	{
+		return (fsm_data.num_inputs + 63) / 64;
+	}
+
+	bool pattern_to_cube(const RTLIL::Const &pattern, cube_t &cube) const
+	{
+		int words = cube_words();
+		cube.assign(2*words, 0);
+		if (GetSize(pattern) != fsm_data.num_inputs)
+			return false;
+		for (int i = 0; i < GetSize(pattern); i++) {
+			uint64_t mask = uint64_t(1) << (i % 64);
+			if (pattern.bits[i] == RTLIL::State::S1)
+				cube[i / 64] |= mask;
+			else if (pattern.bits[i] == RTLIL::State::Sa)
+				cube[words + i / 64] |= mask;
+			else if (pattern.bits[i] != RTLIL::State::S0)
+				return false;
+		}
+		return true;
+	}
+
+	RTLIL::Const cube_to_pattern(const cube_t &cube) const
+	{
+		int words = cube_words();
+		RTLIL::Const pattern(RTLIL::State::S0, fsm_data.num_inputs);
+		for (int i = 0; i < fsm_data.num_inputs; i++) {
+			uint64_t mask = uint64_t(1) << (i % 64);
+			if (cube[words + i / 64] & mask)
+				pattern.bits[i] = RTLIL::State::Sa;
+			else if (cube[i / 64] & mask)
+				pattern.bits[i] = RTLIL::State::S1;
+		}
+		return pattern;
+	}
+
+	// same order as RTLIL::Const::operator< on the patterns (S0 < S1 < Sa)
+	struct cube_less
+	{
+		int words;
+		cube_less(int words) : words(words) { }
+		bool operator()(const cube_t &a, const cube_t &b) const
+		{
+			for (int w = 0; w < words; w++) {
+				uint64_t diff = (a[w] ^ b[w]) | (a[words + w] ^ b[words + w]);
+				if (diff == 0)
+					continue;
+				uint64_t mask = diff & -diff;
+				int code_a = (a[words + w] & mask) ? 2 : (a[w] & mask) ? 1 : 0;
+				int code_b = (b[words + w] & mask) ? 2 : (b[w] & mask) ? 1 : 0;
+				return code_a < code_b;
+			}
+			return false;
+		}
+	};
+
+	// same as opt_find_dont_care_worker() on a sorted vector of cubes,
+	// cube_set holds the same cubes and is kept up to date across calls
+	void opt_find_dont_care_cubes(std::vector<cube_t> &cubes, pool<cube_t> &cube_set, int bit, FsmData::transition_t &tr, bool &did_something)
+	{
+		int words = cube_words();
+		int w = bit / 64;
+		uint64_t mask = uint64_t(1) << (bit % 64);
+
+		std::vector<cube_t> new_cubes, merged_cubes;
+		bool merged = false;
+
+		for (auto &cube : cubes)
+		{
+			if (cube[words + w] & mask) {
+				new_cubes.push_back(cube);
+				continue;
+			}
+
+			cube_t other_cube = cube;
+			other_cube[w] ^= mask;
+
+			if (cube_set.count(other_cube) > 0) {
+				log("  Merging pattern %s and %s from group (%d %d %s).\n", log_signal(cube_to_pattern(cube)),
+						log_signal(cube_to_pattern(other_cube)), tr.state_in, tr.state_out, log_signal(tr.ctrl_out));
+				merged_cubes.push_back(cube);
+				other_cube[w] &= ~mask;
+				other_cube[words + w] |= mask;
+				new_cubes.push_back(other_cube);
+				merged = true;
+				continue;
+			}
+
+			new_cubes.push_back(cube);
+		}
+
+		if (merged) {
+			std::sort(new_cubes.begin(), new_cubes.end(), cube_less(words));
+			new_cubes.erase(std::unique(new_cubes.begin(), new_cubes.end()), new_cubes.end());
+			for (auto &cube : merged_cubes) {
+				cube_set.erase(cube);
+				cube[w] &= ~mask;
+				cube[words + w] |= mask;
+				cube_set.insert(cube);
+			}
+			did_something = true;
+		}
+
+		cubes.swap(new_cubes);
+		log_assert(GetSize(cube_set) == GetSize(cubes));
+	}
+
 	void opt_find_dont_care()
 	{
 		typedef std::pair<std::pair<int, int>, RTLIL::Const> group_t;
@@ -277,6 +391,32 @@ struct FsmOpt
 			tr.state_out = it.first.first.second;
 			tr.ctrl_out = it.first.second;
 
+			std::vector<cube_t> cubes;
+			for (auto &ci : it.second) {
+				cubes.push_back(cube_t());
+				if (!pattern_to_cube(ci, cubes.back())) {
+					cubes.clear();
+					break;
+				}
+			}
+
+			if (!cubes.empty())
+			{
+				pool<cube_t> cube_set(cubes.begin(), cubes.end());
+				bool did_something = true;
+				while (did_something) {
+					did_something = false;
+					for (int i = 0; i < fsm_data.num_inputs; i++)
+						opt_find_dont_care_cubes(cubes, cube_set, i, tr, did_something);
+				}
+
+				for (auto &cube : cubes) {
+					tr.ctrl_in = cube_to_pattern(cube);
+					fsm_data.transition_table.push_back(tr);
+				}
+				continue;
+			}
+
 			bool did_something = true;
 			while (did_something) {
 				did_something = false;
@@ -992,10 +992,81 @@ grow_read_ports:;
 	return true;
 }
 
-void handle_cell(Cell *cell, const rules_t &rules)
+// The mapping decision for a $mem cell only depends on its parameters, on
+// whether it has init data, and on which of its clock and enable bits are
+// constant or equal to each other. Cells with the same shape get the same
+// decision, which is only computed once. If that decision cannot be applied
+// to a cell, all rules are checked again for it.
+//
+// The candidate rules are checked one after another. The replace_cell() dry
+// runs create IdStrings and write to the log, and neither the IdString
+// reference counts nor the log are thread-safe.
+
+struct mapping_t {
+	int rule = -1, variant = -1, mode = 0;
+	dict<string, int> match_properties;
+};
+
+typedef dict<vector<int>, mapping_t> mapping_cache_t;
+
+vector<int> memory_shape(Cell *cell)
+{
+	vector<int> shape;
+
+	for (auto param : {"\\SIZE", "\\ABITS", "\\WIDTH", "\\WR_PORTS", "\\RD_PORTS"})
+		shape.push_back(cell->getParam(param).as_int());
+
+	for (auto param : {"\\WR_CLK_ENABLE", "\\WR_CLK_POLARITY", "\\RD_CLK_ENABLE", "\\RD_CLK_POLARITY", "\\RD_TRANSPARENT"}) {
+		const Const &value = cell->getParam(param);
+		shape.push_back(GetSize(value));
+		for (auto bit : value.bits)
+			shape.push_back(bit);
+	}
+
+	shape.push_back(SigSpec(cell->getParam("\\INIT")).is_fully_undef());
+
+	// constant bits by value, other bits by first occurrence
+	dict<SigBit, int> bit_ids;
+	for (auto port : {"\\WR_CLK", "\\WR_EN", "\\RD_CLK", "\\RD_EN"}) {
+		SigSpec sig = cell->getPort(port);
+		shape.push_back(GetSize(sig));
+		for (auto bit : sig) {
+			if (bit.wire == nullptr)
+				shape.push_back(-1 - bit.data);
+			else
+				shape.push_back(bit_ids.insert(make_pair(bit, GetSize(bit_ids))).first->second);
+		}
+	}
+
+	return shape;
+}
+
+void handle_cell(Cell *cell, const rules_t &rules, mapping_cache_t &mapping_cache)
 {
 	log("Processing %s.%s:\n", log_id(cell->module), log_id(cell));
 
+	vector<int> shape = memory_shape(cell);
+	auto cached = mapping_cache.find(shape);
+
+	if (cached != mapping_cache.end())
+	{
+		mapping_t mapping = cached->second;
+		if (mapping.rule < 0) {
+			log("  No acceptable bram resources found for a memory of the same shape.\n");
+			return;
+		}
+
+		auto &match = rules.matches.at(mapping.rule);
+		auto &bram = rules.brams.at(match.name).at(mapping.variant);
+		log("  Using rule %d.%d, selected for a memory of the same shape.\n", mapping.rule+1, mapping.variant+1);
+		if (replace_cell(cell, rules, bram, match, mapping.match_properties, mapping.mode))
+			return;
+		log("    Mapping to bram type %s failed, checking all rules.\n", log_id(match.name));
+	}
+
+	mapping_t &mapping = mapping_cache[shape];
+	mapping = mapping_t();
+
 	bool cell_init = !SigSpec(cell->getParam("\\INIT")).is_fully_undef();
 
 	dict<string, int> match_properties;
@@ -1136,14 +1207,21 @@ void handle_cell(Cell *cell, const rules_t &rules)
 				auto &best_bram = rules.brams.at(rules.matches.at(best_rule.first).name).at(best_rule.second);
 				if (!replace_cell(cell, rules, best_bram, rules.matches.at(best_rule.first), match_properties, 2))
 					log_error("Mapping to bram type %s (variant %d) after pre-selection failed.\n", log_id(best_bram.name), best_bram.variant);
+				mapping.rule = best_rule.first;
+				mapping.variant = best_rule.second;
+				mapping.mode = 2;
 				return;
 			}
 
+			mapping.match_properties = match_properties;
 			if (!replace_cell(cell, rules, bram, match, match_properties, 0)) {
 				log("    Mapping to bram type %s failed.\n", log_id(match.name));
 				failed_brams.insert(pair<IdString, int>(bram.name, bram.variant));
 				goto next_match_rule;
 			}
+			mapping.rule = i;
+			mapping.variant = vi;
+			mapping.mode = 0;
 			return;
 		}
 	}
@@ -1259,10 +1337,12 @@ struct MemoryBramPass : public Pass {
 		}
 		extra_args(args, argidx, design);
 
+		mapping_cache_t mapping_cache;
+
 		for (auto mod : design->selected_modules())
 		for (auto cell : mod->selected_cells())
 			if (cell->type == "$mem")
-				handle_cell(cell, rules);
+				handle_cell(cell, rules, mapping_cache);
 	}
 } MemoryBramPass;
 
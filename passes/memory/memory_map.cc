@@ -31,7 +31,9 @@ struct MemoryMapWorker
 	RTLIL::Design *design;
 	RTLIL::Module *module;
 
-	std::map<std::pair<RTLIL::SigSpec, RTLIL::SigSpec>, RTLIL::SigBit> decoder_cache;
+	// one-hot address predecoder: (address signal, value) -> select bit,
+	// shared by all ports and memories that use the same address bits
+	dict<std::pair<RTLIL::SigSpec, int>, RTLIL::SigBit> decoder_cache;
 
 	std::string genid(RTLIL::IdString name, std::string token1 = "", int i = -1, std::string token2 = "", int j = -1, std::string token3 = "", int k = -1, std::string token4 = "")
 	{
@@ -55,25 +57,77 @@ struct MemoryMapWorker
 		return sstr.str();
 	}
 
-	RTLIL::Wire *addr_decode(RTLIL::SigSpec addr_sig, RTLIL::SigSpec addr_val)
+	static int addr_field(int addr_val, int offset, int width)
 	{
-		std::pair<RTLIL::SigSpec, RTLIL::SigSpec> key(addr_sig, addr_val);
-		log_assert(GetSize(addr_sig) == GetSize(addr_val));
+		if (offset >= 31)
+			return 0;
+		addr_val >>= offset;
+		return width >= 31 ? addr_val : addr_val & ((1 << width) - 1);
+	}
+
+	RTLIL::SigBit addr_decode(const RTLIL::SigSpec &addr_sig, int addr_val)
+	{
+		std::pair<RTLIL::SigSpec, int> key(addr_sig, addr_val);
+
+		auto it = decoder_cache.find(key);
+		if (it != decoder_cache.end())
+			return it->second;
+
+		RTLIL::SigBit bit;
+		if (GetSize(addr_sig) == 0) {
+			// a memory with a single word: every address selects it
+			bit = State::S1;
+		} else if (GetSize(addr_sig) < 2) {
+			if (addr_val)
+				bit = addr_sig[0];
+			else
+				bit = module->Not(NEW_ID, addr_sig[0]);
+		} else {
+			int split_at = GetSize(addr_sig) / 2;
+			RTLIL::SigBit left_eq = addr_decode(addr_sig.extract(0, split_at), addr_field(addr_val, 0, split_at));
+			RTLIL::SigBit right_eq = addr_decode(addr_sig.extract(split_at, GetSize(addr_sig) - split_at), addr_field(addr_val, split_at, GetSize(addr_sig) - split_at));
+			bit = module->And(NEW_ID, left_eq, right_eq);
+		}
+
+		decoder_cache[key] = bit;
+		return bit;
+	}
+
+	// Selects between two read words. Bits that are equal in both words are
+	// passed through, constant 0/1 pairs become the select bit or its
+	// inverse, and only the remaining bits get a $mux cell.
+	RTLIL::SigSpec rom_mux(RTLIL::IdString name, const RTLIL::SigSpec &a, const RTLIL::SigSpec &b, RTLIL::SigBit s, RTLIL::SigBit &not_s, int &count_mux)
+	{
+		if (a == b)
+			return a;
+
+		RTLIL::SigSpec y = a, mux_a, mux_b;
+		vector<int> mux_bits;
 
-		if (decoder_cache.count(key) == 0) {
-			if (GetSize(addr_sig) < 2) {
-				decoder_cache[key] = module->Eq(NEW_ID, addr_sig, addr_val);
+		for (int i = 0; i < GetSize(a); i++) {
+			if (a[i] == b[i])
+				continue;
+			if (a[i] == State::S0 && b[i] == State::S1) {
+				y[i] = s;
+			} else if (a[i] == State::S1 && b[i] == State::S0) {
+				if (not_s == State::Sx)
+					not_s = module->Not(NEW_ID, s);
+				y[i] = not_s;
 			} else {
-				int split_at = GetSize(addr_sig) / 2;
-				RTLIL::SigBit left_eq = addr_decode(addr_sig.extract(0, split_at), addr_val.extract(0, split_at));
-				RTLIL::SigBit right_eq = addr_decode(addr_sig.extract(split_at, GetSize(addr_sig) - split_at), addr_val.extract(split_at, GetSize(addr_val) - split_at));
-				decoder_cache[key] = module->And(NEW_ID, left_eq, right_eq);
+				mux_a.append(a[i]);
+				mux_b.append(b[i]);
+				mux_bits.push_back(i);
 			}
 		}
 
-		RTLIL::SigBit bit = decoder_cache.at(key);
-		log_assert(bit.wire != nullptr && GetSize(bit.wire) == 1);
-		return bit.wire;
+		if (!mux_bits.empty()) {
+			RTLIL::SigSpec mux_y = module->Mux(name, mux_a, mux_b, s);
+			count_mux++;
+			for (int i = 0; i < GetSize(mux_bits); i++)
+				y[mux_bits[i]] = mux_y[i];
+		}
+
+		return y;
 	}
 
 	void handle_cell(RTLIL::Cell *cell)
@@ -140,6 +194,9 @@ struct MemoryMapWorker
 
 		log("Mapping memory cell %s in module %s:\n", cell->name.c_str(), module->name.c_str());
 
+		// without any write port, the read ports select from the init data
+		bool is_rom = GetSize(static_ports) == wr_ports && static_cells_map.empty();
+
 		std::vector<RTLIL::SigSpec> data_reg_in;
 		std::vector<RTLIL::SigSpec> data_reg_out;
 
@@ -147,7 +204,13 @@ struct MemoryMapWorker
 
 		for (int i = 0; i < mem_size; i++)
 		{
-			if (static_cells_map.count(i) > 0)
+			if (is_rom)
+			{
+				data_reg_in.push_back(RTLIL::SigSpec());
+				data_reg_out.push_back(init_data.extract(i*mem_width, mem_width));
+				count_static++;
+			}
+			else if (static_cells_map.count(i) > 0)
 			{
 				data_reg_in.push_back(RTLIL::SigSpec(RTLIL::State::Sz, mem_width));
 				data_reg_out.push_back(static_cells_map[i]);
@@ -184,7 +247,10 @@ struct MemoryMapWorker
 			}
 		}
 
-		log("  created %d $dff cells and %d static cells of width %d.\n", mem_size-count_static, count_static, mem_width);
+		if (is_rom)
+			log("  read-only memory, using the %d init words of width %d.\n", mem_size, mem_width);
+		else
+			log("  created %d $dff cells and %d static cells of width %d.\n", mem_size-count_static, count_static, mem_width);
 
 		int count_dff = 0, count_mux = 0, count_wrmux = 0;
 
@@ -240,6 +306,34 @@ struct MemoryMapWorker
 				}
 			}
 
+			if (is_rom)
+			{
+				// bottom-up tree over the init words, addresses past the end
+				// of the memory are don't-care
+				std::vector<RTLIL::SigSpec> words = data_reg_out;
+
+				for (int j = 0; j < mem_abits && GetSize(words) > 1; j++)
+				{
+					std::vector<RTLIL::SigSpec> next_words;
+					RTLIL::SigBit not_s = State::Sx;
+
+					for (int k = 0; k < GetSize(words); k += 2) {
+						if (k+1 == GetSize(words)) {
+							next_words.push_back(words[k]);
+							continue;
+						}
+						next_words.push_back(rom_mux(genid(cell->name, "$rdmux", i, "", j, "", k/2),
+								words[k], words[k+1], rd_addr[j], not_s, count_mux));
+					}
+
+					next_words.swap(words);
+				}
+
+				if (!words.empty())
+					module->connect(RTLIL::SigSig(rd_signals.back(), words.front()));
+				continue;
+			}
+
 			for (int j = 0; j < mem_abits; j++)
 			{
 				std::vector<RTLIL::SigSpec> next_rd_signals;
@@ -268,23 +362,45 @@ struct MemoryMapWorker
 
 		log("  read interface: %d $dff and %d $mux cells.\n", count_dff, count_mux);
 
-		for (int i = 0; i < mem_size; i++)
+		// the same for all words, the port signals and address offset are
+		// only computed once per port
+		std::vector<int> active_wr_ports;
+		std::vector<RTLIL::SigSpec> wr_addr_sigs, wr_data_sigs, wr_en_sigs;
+
+		for (int j = 0; j < wr_ports && !is_rom; j++)
+		{
+			RTLIL::SigSpec wr_addr = cell->getPort("\\WR_ADDR").extract(j*mem_abits, mem_abits);
+			RTLIL::SigSpec wr_en = cell->getPort("\\WR_EN").extract(j*mem_width, mem_width);
+
+			// disabled ports and the constant address ports in static_cells_map
+			// never write to the words that are mapped here
+			if (static_ports.count(j))
+				continue;
+
+			if (mem_offset)
+				wr_addr = module->Sub(NEW_ID, wr_addr, SigSpec(mem_offset, GetSize(wr_addr)));
+
+			active_wr_ports.push_back(j);
+			wr_addr_sigs.push_back(wr_addr);
+			wr_data_sigs.push_back(cell->getPort("\\WR_DATA").extract(j*mem_width, mem_width));
+			wr_en_sigs.push_back(wr_en);
+		}
+
+		for (int i = 0; i < mem_size && !is_rom; i++)
 		{
 			if (static_cells_map.count(i) > 0)
 				continue;
 
 			RTLIL::SigSpec sig = data_reg_out[i];
 
-			for (int j = 0; j < cell->parameters["\\WR_PORTS"].as_int(); j++)
+			for (int p = 0; p < GetSize(active_wr_ports); p++)
 			{
-				RTLIL::SigSpec wr_addr = cell->getPort("\\WR_ADDR").extract(j*mem_abits, mem_abits);
-				RTLIL::SigSpec wr_data = cell->getPort("\\WR_DATA").extract(j*mem_width, mem_width);
-				RTLIL::SigSpec wr_en = cell->getPort("\\WR_EN").extract(j*mem_width, mem_width);
+				int j = active_wr_ports[p];
+				const RTLIL::SigSpec &wr_addr = wr_addr_sigs[p];
+				const RTLIL::SigSpec &wr_data = wr_data_sigs[p];
+				const RTLIL::SigSpec &wr_en = wr_en_sigs[p];
 
-				if (mem_offset)
-					wr_addr = module->Sub(NEW_ID, wr_addr, SigSpec(mem_offset, GetSize(wr_addr)));
-
-				RTLIL::Wire *w_seladdr = addr_decode(wr_addr, RTLIL::SigSpec(i, mem_abits));
+				RTLIL::SigBit seladdr = addr_decode(wr_addr, i);
 
 				int wr_offset = 0;
 				while (wr_offset < wr_en.size())
@@ -299,7 +415,7 @@ struct MemoryMapWorker
 						wr_width++;
 					}
 
-					RTLIL::Wire *w = w_seladdr;
+					RTLIL::SigSpec w = seladdr;
 
 					if (wr_bit != State::S1)
 					{
@@ -361,6 +477,10 @@ struct MemoryMapPass : public Pass {
 		log("This pass converts multiport memory cells as generated by the memory_collect\n");
 		log("pass to word-wide DFFs and address decoders.\n");
 		log("\n");
+		log("Memories without (enabled) write ports are mapped to a tree of multiplexers\n");
+		log("that selects from the init data. Bits that are the same in both halves of a\n");
+		log("subtree are not multiplexed.\n");
+		log("\n");
 	}
 	void execute(std::vector<std::string> args, RTLIL::Design *design) YS_OVERRIDE {
 		log_header(design, "Executing MEMORY_MAP pass (converting $mem cells to logic and flip-flops).\n");
@@ -18,6 +18,7 @@
  */
 
 #include "kernel/register.h"
+#include "kernel/sigtools.h"
 #include "kernel/log.h"
 #include <stdlib.h>
 #include <stdio.h>
@@ -25,6 +26,251 @@
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
+// Records which cells and wires have been touched by the opt_* passes, so that
+// the next iteration of the opt loop only needs to look at the affected frontier.
+//
+// The monitor also keeps an index from wire bits to the cells connected to them
+// and to the bits they are connected to by module connections. It is built once
+// per module and then kept up to date from the notifications, so the frontier
+// can be found by walking from the touched bits instead of scanning the module.
+// Everything is stored by name because opt_clean removes objects, and because
+// opt_clean rewrites cell connections between connected bits without notifying
+// the monitors, which the alias edges take care of.
+struct OptIncrementalMonitor : public RTLIL::Monitor
+{
+	typedef std::pair<RTLIL::IdString, int> bitname_t;
+
+	struct ModuleIndex {
+		dict<bitname_t, pool<RTLIL::IdString>> bit_cells;
+		dict<bitname_t, pool<bitname_t>> bit_aliases;
+		pool<RTLIL::IdString> dirty_cells;
+		pool<bitname_t> dirty_bits;
+	};
+
+	pool<RTLIL::Module*> dirty_modules;
+	dict<RTLIL::Module*, ModuleIndex> indices;
+
+	void index_module(RTLIL::Module *module)
+	{
+		ModuleIndex &index = indices[module];
+		for (auto cell : module->cells())
+			for (auto &conn : cell->connections())
+				for (auto bit : conn.second)
+					if (bit.wire != nullptr)
+						index.bit_cells[bitname_t(bit.wire->name, bit.offset)].insert(cell->name);
+		for (auto &conn : module->connections())
+			add_aliases(index, conn);
+	}
+
+	void add_aliases(ModuleIndex &index, const RTLIL::SigSig &conn)
+	{
+		for (int i = 0; i < GetSize(conn.first); i++) {
+			RTLIL::SigBit lhs = conn.first[i], rhs = conn.second[i];
+			if (lhs.wire != nullptr && rhs.wire != nullptr && lhs != rhs) {
+				index.bit_aliases[bitname_t(lhs.wire->name, lhs.offset)].insert(bitname_t(rhs.wire->name, rhs.offset));
+				index.bit_aliases[bitname_t(rhs.wire->name, rhs.offset)].insert(bitname_t(lhs.wire->name, lhs.offset));
+			}
+		}
+	}
+
+	void notify_module_add(RTLIL::Module *module) YS_OVERRIDE
+	{
+		dirty_modules.insert(module);
+	}
+
+	void notify_module_del(RTLIL::Module *module) YS_OVERRIDE
+	{
+		dirty_modules.erase(module);
+		indices.erase(module);
+	}
+
+	void notify_connect(RTLIL::Cell *cell, const RTLIL::IdString &port, const RTLIL::SigSpec &old_sig, RTLIL::SigSpec &sig) YS_OVERRIDE
+	{
+		auto it = indices.find(cell->module);
+		if (it == indices.end())
+			return;
+		ModuleIndex &index = it->second;
+		index.dirty_cells.insert(cell->name);
+
+		if (!old_sig.empty()) {
+			pool<RTLIL::SigBit> other_bits;
+			for (auto &conn : cell->connections())
+				if (conn.first != port)
+					for (auto bit : conn.second)
+						other_bits.insert(bit);
+			for (auto bit : old_sig) {
+				if (bit.wire == nullptr)
+					continue;
+				bitname_t name(bit.wire->name, bit.offset);
+				index.dirty_bits.insert(name);
+				if (!other_bits.count(bit))
+					index.bit_cells[name].erase(cell->name);
+			}
+		}
+
+		for (auto bit : sig) {
+			if (bit.wire == nullptr)
+				continue;
+			bitname_t name(bit.wire->name, bit.offset);
+			index.dirty_bits.insert(name);
+			index.bit_cells[name].insert(cell->name);
+		}
+	}
+
+	void mark_sig(ModuleIndex &index, const RTLIL::SigSpec &sig)
+	{
+		for (auto bit : sig)
+			if (bit.wire != nullptr)
+				index.dirty_bits.insert(bitname_t(bit.wire->name, bit.offset));
+	}
+
+	void notify_connect(RTLIL::Module *module, const RTLIL::SigSig &sigsig) YS_OVERRIDE
+	{
+		auto it = indices.find(module);
+		if (it == indices.end())
+			return;
+		mark_sig(it->second, sigsig.first);
+		mark_sig(it->second, sigsig.second);
+		add_aliases(it->second, sigsig);
+	}
+
+	void notify_connect(RTLIL::Module *module, const std::vector<RTLIL::SigSig> &sigsig_vec) YS_OVERRIDE
+	{
+		auto it = indices.find(module);
+		if (it == indices.end())
+			return;
+		for (auto &sigsig : sigsig_vec) {
+			mark_sig(it->second, sigsig.first);
+			mark_sig(it->second, sigsig.second);
+			add_aliases(it->second, sigsig);
+		}
+	}
+
+	void notify_cells_del(RTLIL::Module *module, const pool<RTLIL::Cell*> &cells) YS_OVERRIDE
+	{
+		auto it = indices.find(module);
+		if (it == indices.end())
+			return;
+		ModuleIndex &index = it->second;
+		for (auto cell : cells)
+			for (auto &conn : cell->connections())
+				for (auto bit : conn.second) {
+					if (bit.wire == nullptr)
+						continue;
+					bitname_t name(bit.wire->name, bit.offset);
+					index.dirty_bits.insert(name);
+					index.bit_cells[name].erase(cell->name);
+				}
+	}
+
+	void notify_blackout(RTLIL::Module *module) YS_OVERRIDE
+	{
+		dirty_modules.insert(module);
+	}
+
+	void clear()
+	{
+		dirty_modules.clear();
+		for (auto &it : indices) {
+			it.second.dirty_cells.clear();
+			it.second.dirty_bits.clear();
+		}
+	}
+
+	// Build a selection with the touched cells and wires and all (selected) cells
+	// that drive or consume any of the signals connected to them.
+	RTLIL::Selection frontier(RTLIL::Design *design, int &frontier_cells, int &total_cells)
+	{
+		RTLIL::Selection sel(false);
+		frontier_cells = 0;
+		total_cells = 0;
+
+		for (auto module : design->selected_modules())
+		{
+			int module_cells = 0;
+			if (design->selected_whole_module(module))
+				module_cells = GetSize(module->cells_);
+			else
+				for (auto cell : module->cells())
+					if (design->selected(module, cell))
+						module_cells++;
+			total_cells += module_cells;
+
+			auto it = indices.find(module);
+			if (dirty_modules.count(module) || it == indices.end()) {
+				for (auto wire : module->wires())
+					if (design->selected(module, wire))
+						sel.select(module, wire);
+				for (auto cell : module->cells())
+					if (design->selected(module, cell))
+						sel.select(module, cell);
+				frontier_cells += module_cells;
+				if (it == indices.end())
+					index_module(module);
+				continue;
+			}
+
+			ModuleIndex &index = it->second;
+			pool<bitname_t> bits;
+			std::vector<bitname_t> queue;
+
+			auto add_bit = [&](const bitname_t &name) {
+				if (bits.insert(name).second)
+					queue.push_back(name);
+			};
+
+			for (auto &name : index.dirty_bits)
+				add_bit(name);
+
+			for (auto name : index.dirty_cells) {
+				RTLIL::Cell *cell = module->cell(name);
+				if (cell == nullptr)
+					continue;
+				for (auto &conn : cell->connections())
+					for (auto bit : conn.second)
+						if (bit.wire != nullptr)
+							add_bit(bitname_t(bit.wire->name, bit.offset));
+			}
+
+			// bits that are connected to a touched bit are touched as well
+			while (!queue.empty()) {
+				bitname_t name = queue.back();
+				queue.pop_back();
+				auto alias_it = index.bit_aliases.find(name);
+				if (alias_it != index.bit_aliases.end())
+					for (auto &alias : alias_it->second)
+						add_bit(alias);
+			}
+
+			pool<RTLIL::IdString> cells = index.dirty_cells;
+			pool<RTLIL::IdString> wires;
+			for (auto &name : bits) {
+				wires.insert(name.first);
+				auto cells_it = index.bit_cells.find(name);
+				if (cells_it != index.bit_cells.end())
+					for (auto cell_name : cells_it->second)
+						cells.insert(cell_name);
+			}
+
+			for (auto name : wires) {
+				RTLIL::Wire *wire = module->wire(name);
+				if (wire != nullptr && design->selected(module, wire))
+					sel.select(module, wire);
+			}
+
+			for (auto name : cells) {
+				RTLIL::Cell *cell = module->cell(name);
+				if (cell == nullptr || !design->selected(module, cell))
+					continue;
+				sel.select(module, cell);
+				frontier_cells++;
+			}
+		}
+
+		return sel;
+	}
+};
+
 struct OptPass : public Pass {
 	OptPass() : Pass("opt", "perform simple optimizations") { }
 	void help() YS_OVERRIDE
@@ -62,6 +308,12 @@ struct OptPass : public Pass {
 		log("Note: Options in square brackets (such as [-keepdc]) are passed through to\n");
 		log("the opt_* commands when given to 'opt'.\n");
 		log("\n");
+		log("When called with -incremental, the opt_expr, opt_reduce, opt_merge and opt_rmdff\n");
+		log("passes in all but the first iteration only operate on the cells that have been\n");
+		log("touched in the previous iteration and the cells connected to them. Once such an\n");
+		log("iteration does not change the design, a final iteration on the full selection\n");
+		log("is performed to make sure that there is nothing left to do.\n");
+		log("\n");
 		log("\n");
 	}
 	void execute(std::vector<std::string> args, RTLIL::Design *design) YS_OVERRIDE
@@ -73,6 +325,7 @@ struct OptPass : public Pass {
 		std::string opt_rmdff_args;
 		bool opt_share = false;
 		bool fast_mode = false;
+		bool incremental = false;
 
 		log_header(design, "Executing OPT pass (performing simple optimizations).\n");
 		log_push();
@@ -127,44 +380,93 @@ struct OptPass : public Pass {
 				fast_mode = true;
 				continue;
 			}
+			if (args[argidx] == "-incremental") {
+				incremental = true;
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
 
-		if (fast_mode)
-		{
-			while (1) {
-				Pass::call(design, "opt_expr" + opt_expr_args);
-				Pass::call(design, "opt_merge" + opt_merge_args);
-				design->scratchpad_unset("opt.did_something");
-				Pass::call(design, "opt_rmdff" + opt_rmdff_args);
-				if (design->scratchpad_get_bool("opt.did_something") == false)
-					break;
-				Pass::call(design, "opt_clean" + opt_clean_args);
-				log_header(design, "Rerunning OPT passes. (Removed registers in this run.)\n");
+		OptIncrementalMonitor monitor;
+		RTLIL::Selection frontier;
+		bool full_iteration = true;
+
+		// call a pass on the full selection or (in incremental mode) on the frontier
+		auto call_opt = [&](std::string command) {
+			if (full_iteration)
+				Pass::call(design, command);
+			else
+				Pass::call_on_selection(design, frontier, command);
+		};
+
+		auto next_iteration = [&](bool did_something, const char *rerun_msg) {
+			if (!did_something) {
+				if (!incremental || full_iteration)
+					return false;
+				full_iteration = true;
+				monitor.clear();
+				log_header(design, "Rerunning OPT passes. (Checking full selection..)\n");
+				return true;
+			}
+			log_header(design, "%s", rerun_msg);
+			if (incremental) {
+				int frontier_cells, total_cells;
+				frontier = monitor.frontier(design, frontier_cells, total_cells);
+				full_iteration = false;
+				monitor.clear();
+				log("Re-examining %d of %d selected cells in this iteration.\n", frontier_cells, total_cells);
 			}
-			Pass::call(design, "opt_clean" + opt_clean_args);
+			return true;
+		};
+
+		if (incremental) {
+			for (auto module : design->selected_modules())
+				monitor.index_module(module);
+			design->monitors.insert(&monitor);
 		}
-		else
-		{
-			Pass::call(design, "opt_expr" + opt_expr_args);
-			Pass::call(design, "opt_merge -nomux" + opt_merge_args);
-			while (1) {
-				design->scratchpad_unset("opt.did_something");
-				Pass::call(design, "opt_muxtree");
-				Pass::call(design, "opt_reduce" + opt_reduce_args);
-				Pass::call(design, "opt_merge" + opt_merge_args);
-				if (opt_share)
-					Pass::call(design, "opt_share");
-				Pass::call(design, "opt_rmdff" + opt_rmdff_args);
+
+		try {
+			if (fast_mode)
+			{
+				while (1) {
+					call_opt("opt_expr" + opt_expr_args);
+					call_opt("opt_merge" + opt_merge_args);
+					design->scratchpad_unset("opt.did_something");
+					call_opt("opt_rmdff" + opt_rmdff_args);
+					bool did_something = design->scratchpad_get_bool("opt.did_something");
+					if (did_something)
+						Pass::call(design, "opt_clean" + opt_clean_args);
+					if (!next_iteration(did_something, "Rerunning OPT passes. (Removed registers in this run.)\n"))
+						break;
+				}
 				Pass::call(design, "opt_clean" + opt_clean_args);
+			}
+			else
+			{
 				Pass::call(design, "opt_expr" + opt_expr_args);
-				if (design->scratchpad_get_bool("opt.did_something") == false)
-					break;
-				log_header(design, "Rerunning OPT passes. (Maybe there is more to do..)\n");
+				Pass::call(design, "opt_merge -nomux" + opt_merge_args);
+				while (1) {
+					design->scratchpad_unset("opt.did_something");
+					Pass::call(design, "opt_muxtree");
+					call_opt("opt_reduce" + opt_reduce_args);
+					call_opt("opt_merge" + opt_merge_args);
+					if (opt_share)
+						Pass::call(design, "opt_share");
+					call_opt("opt_rmdff" + opt_rmdff_args);
+					Pass::call(design, "opt_clean" + opt_clean_args);
+					call_opt("opt_expr" + opt_expr_args);
+					if (!next_iteration(design->scratchpad_get_bool("opt.did_something"), "Rerunning OPT passes. (Maybe there is more to do..)\n"))
+						break;
+				}
 			}
+		} catch (...) {
+			design->monitors.erase(&monitor);
+			throw;
 		}
 
+		design->monitors.erase(&monitor);
+
 		design->optimize();
 		design->sort();
 		design->check();
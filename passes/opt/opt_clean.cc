@@ -87,7 +87,7 @@ void rmunused_module_cells(Module *module, bool verbose)
 	pool<Cell*> queue, unused;
 	pool<SigBit> used_raw_bits;
 	dict<SigBit, pool<Cell*>> wire2driver;
-	dict<SigBit, vector<string>> driver_driver_logs;
+	dict<SigBit, vector<LogDeferred>> driver_driver_logs;
 
 	SigMap raw_sigmap;
 	for (auto &it : module->connections_) {
@@ -107,9 +107,9 @@ void rmunused_module_cells(Module *module, bool verbose)
 					continue;
 				auto bit = sigmap(raw_bit);
 				if (bit.wire == nullptr && ct_all.cell_known(cell->type))
-					driver_driver_logs[raw_sigmap(raw_bit)].push_back(stringf("Driver-driver conflict "
+					driver_driver_logs[raw_sigmap(raw_bit)].push_back(log_defer("Driver-driver conflict "
 							"for %s between cell %s.%s and constant %s in %s: Resolved using constant.",
-							log_signal(raw_bit), log_id(cell), log_id(it2.first), log_signal(bit), log_id(module)));
+							raw_bit, cell->name, it2.first, bit, module->name));
 				if (bit.wire != nullptr)
 					wire2driver[bit].insert(cell);
 			}
@@ -153,9 +153,9 @@ void rmunused_module_cells(Module *module, bool verbose)
 		if (verbose)
 			log_debug("  removing unused `%s' cell `%s'.\n", cell->type.c_str(), cell->name.c_str());
 		module->design->scratchpad_set_bool("opt.did_something", true);
-		module->remove(cell);
 		count_rm_cells++;
 	}
+	module->remove(unused);
 
 	for (auto &it : module->cells_) {
 		Cell *cell = it.second;
@@ -167,10 +167,10 @@ void rmunused_module_cells(Module *module, bool verbose)
 		}
 	}
 
-	for (auto it : driver_driver_logs) {
+	for (auto &it : driver_driver_logs) {
 		if (used_raw_bits.count(it.first))
-			for (auto msg : it.second)
-				log_warning("%s\n", msg.c_str());
+			for (auto &msg : it.second)
+				log_warning("%s\n", msg.str().c_str());
 	}
 }
 
@@ -478,7 +478,7 @@ void rmunused_module(RTLIL::Module *module, bool purge_mode, bool verbose, bool
 	if (verbose)
 		log("Finding unused cells or wires in module %s..\n", module->name.c_str());
 
-	std::vector<RTLIL::Cell*> delcells;
+	pool<RTLIL::Cell*> delcells;
 	for (auto cell : module->cells())
 		if (cell->type.in(ID($pos), ID($_BUF_)) && !cell->has_keep_attr()) {
 			bool is_signed = cell->type == ID($pos) && cell->getParam(ID(A_SIGNED)).as_bool();
@@ -486,14 +486,13 @@ void rmunused_module(RTLIL::Module *module, bool purge_mode, bool verbose, bool
 			RTLIL::SigSpec y = cell->getPort(ID::Y);
 			a.extend_u0(GetSize(y), is_signed);
 			module->connect(y, a);
-			delcells.push_back(cell);
+			delcells.insert(cell);
 		}
-	for (auto cell : delcells) {
-		if (verbose)
+	if (verbose)
+		for (auto cell : delcells)
 			log_debug("  removing buffer cell `%s': %s = %s\n", cell->name.c_str(),
 					log_signal(cell->getPort(ID::Y)), log_signal(cell->getPort(ID::A)));
-		module->remove(cell);
-	}
+	module->remove(delcells);
 	if (!delcells.empty())
 		module->design->scratchpad_set_bool("opt.did_something", true);
 
@@ -522,10 +521,16 @@ struct OptCleanPass : public Pass {
 		log("    -purge\n");
 		log("        also remove internal nets if they have a public name\n");
 		log("\n");
+		log("    -compact\n");
+		log("        afterwards move the remaining wires and cells of each module to new\n");
+		log("        storage in iteration order. This is useful after passes like techmap\n");
+		log("        or abc that replace most of the cells of a module.\n");
+		log("\n");
 	}
 	void execute(std::vector<std::string> args, RTLIL::Design *design) YS_OVERRIDE
 	{
 		bool purge_mode = false;
+		bool compact_mode = false;
 
 		log_header(design, "Executing OPT_CLEAN pass (remove unused cells and wires).\n");
 		log_push();
@@ -536,6 +541,10 @@ struct OptCleanPass : public Pass {
 				purge_mode = true;
 				continue;
 			}
+			if (args[argidx] == "-compact") {
+				compact_mode = true;
+				continue;
+			}
 			break;
 		}
 		extra_args(args, argidx, design);
@@ -559,6 +568,9 @@ struct OptCleanPass : public Pass {
 			module->check();
 
 			rmunused_module(module, purge_mode, true, true);
+
+			if (compact_mode)
+				module->compact();
 		}
 
 		if (count_rm_cells > 0 || count_rm_wires > 0)
@@ -21,7 +21,7 @@
 #include "kernel/satgen.h"
 #include "kernel/sigtools.h"
 #include "kernel/modtools.h"
-#include "kernel/utils.h"
+#include "kernel/scc.h"
 #include "kernel/macc.h"
 
 USING_YOSYS_NAMESPACE
@@ -57,6 +57,8 @@ struct ShareWorker
 	SigMap topo_sigmap;
 	std::map<RTLIL::Cell*, std::set<RTLIL::Cell*, cell_ptr_cmp>, cell_ptr_cmp> topo_cell_drivers;
 	std::map<RTLIL::SigBit, std::set<RTLIL::Cell*, cell_ptr_cmp>> topo_bit_drivers;
+	std::vector<RTLIL::Cell*> topo_order;
+	bool topo_order_valid = false;
 
 	std::vector<std::pair<RTLIL::SigBit, RTLIL::SigBit>> exclusive_ctrls;
 
@@ -999,48 +1001,192 @@ struct ShareWorker
 		ct.setup_internals();
 		ct.setup_stdcells();
 
-		TopoSort<RTLIL::Cell*, cell_ptr_cmp> toposort;
-		toposort.analyze_loops = false;
+		SccCellGraph graph;
 
 		topo_sigmap.set(module);
 		topo_bit_drivers.clear();
-
-		dict<RTLIL::Cell*, pool<RTLIL::SigBit>> cell_to_bits;
-		dict<RTLIL::SigBit, pool<RTLIL::Cell*>> bit_to_cells;
+		topo_cell_drivers.clear();
 
 		for (auto cell : module->cells())
 			if (ct.cell_known(cell->type))
 				for (auto &conn : cell->connections()) {
 					if (ct.cell_output(cell->type, conn.first))
 						for (auto bit : topo_sigmap(conn.second)) {
-							cell_to_bits[cell].insert(bit);
+							graph.add_driver(cell, bit);
 							topo_bit_drivers[bit].insert(cell);
 						}
 					else
 						for (auto bit : topo_sigmap(conn.second))
-							bit_to_cells[bit].insert(cell);
+							graph.add_user(cell, bit);
 				}
 
-		for (auto &it : cell_to_bits)
+		graph.find();
+
+		for (auto &edge : graph.graph.edges)
+			topo_cell_drivers[graph.cells[edge.second]].insert(graph.cells[edge.first]);
+
+		bool found_scc = graph.graph.found_loops();
+		topo_order = graph.sorted();
+		topo_order_valid = !found_scc;
+
+		for (auto &scc : graph.graph.sccs) {
+			if (!graph.graph.in_loop(scc.front()))
+				continue;
+			std::vector<RTLIL::Cell*> loop;
+			for (int i : scc)
+				loop.push_back(graph.cells[i]);
+			std::sort(loop.begin(), loop.end(), [](RTLIL::Cell *a, RTLIL::Cell *b) { return RTLIL::sort_by_id_str()(a->name, b->name); });
+			log("### loop ###\n");
+			for (auto c : loop)
+				log("%s (%s)\n", log_id(c), log_id(c->type));
+		}
+
+		return found_scc;
+	}
+
+	// ---------------------------------------------------------------------------------
+	// Reachability index for input cone queries. For each shareable cell we store the
+	// set of shareable cells in its input cone as a bit vector (indexed via cone_cells).
+	// The index is built with a single sweep over topo_order and is kept in sync with
+	// topo_cell_drivers when cells are merged. Queries involving cells that are not in
+	// the index (or modules with loops) fall back to a DFS over topo_cell_drivers.
+	// ---------------------------------------------------------------------------------
+
+	typedef std::vector<uint64_t> cone_bits_t;
+
+	bool cone_index_valid = false;
+	idict<RTLIL::Cell*> cone_cells;
+	dict<RTLIL::Cell*, cone_bits_t> cone_index;
+	PerformanceTimer cone_timer;
+	int cone_queries = 0;
+
+	static bool cone_bits_get(const cone_bits_t &bits, int idx)
+	{
+		if (idx / 64 >= GetSize(bits))
+			return false;
+		return (bits[idx / 64] >> (idx % 64)) & 1;
+	}
+
+	static void cone_bits_set(cone_bits_t &bits, int idx)
+	{
+		if (idx / 64 >= GetSize(bits))
+			bits.resize(idx / 64 + 1);
+		bits[idx / 64] |= uint64_t(1) << (idx % 64);
+	}
+
+	static void cone_bits_merge(cone_bits_t &bits, const cone_bits_t &other)
+	{
+		if (GetSize(other) > GetSize(bits))
+			bits.resize(GetSize(other));
+		for (int i = 0; i < GetSize(other); i++)
+			bits[i] |= other[i];
+	}
+
+	void build_cone_index()
+	{
+		cone_index_valid = false;
+		cone_cells.clear();
+		cone_index.clear();
+
+		if (!topo_order_valid)
+			return;
+
+		for (auto cell : shareable_cells)
+			cone_cells(cell);
+
+		dict<RTLIL::Cell*, int> fanout_count;
+		for (auto cell : topo_order)
+			for (auto c : topo_cell_drivers[cell])
+				fanout_count[c]++;
+
+		// Input cone sets of non-shareable cells are only kept until their last consumer is processed
+		dict<RTLIL::Cell*, cone_bits_t> frontier;
+
+		for (auto cell : topo_order)
 		{
-			RTLIL::Cell *c1 = it.first;
+			cone_bits_t bits;
 
-			for (auto bit : it.second)
-			for (auto c2 : bit_to_cells[bit])
-				toposort.edge(c1, c2);
+			for (auto c : topo_cell_drivers[cell])
+			{
+				if (cone_cells.count(c)) {
+					cone_bits_merge(bits, cone_index.at(c));
+					cone_bits_set(bits, cone_cells.at(c));
+				} else {
+					cone_bits_merge(bits, frontier.at(c));
+					if (--fanout_count.at(c) == 0)
+						frontier.erase(c);
+				}
+			}
+
+			if (cone_cells.count(cell))
+				cone_index[cell] = std::move(bits);
+			else if (fanout_count.count(cell))
+				frontier[cell] = std::move(bits);
 		}
 
-		bool found_scc = !toposort.sort();
-		topo_cell_drivers = std::move(toposort.database);
+		for (auto cell : shareable_cells)
+			if (!cone_index.count(cell))
+				cone_index[cell] = cone_bits_t();
+
+		cone_index_valid = true;
+	}
+
+	// Set of indexed cells in the input cone of an arbitrary cell
+	cone_bits_t find_input_cone_bits(RTLIL::Cell *root)
+	{
+		cone_bits_t bits;
 
-		if (found_scc && toposort.analyze_loops)
-			for (auto &loop : toposort.loops) {
-				log("### loop ###\n");
-				for (auto &c : loop)
-					log("%s (%s)\n", log_id(c), log_id(c->type));
+		if (cone_index.count(root)) {
+			bits = cone_index.at(root);
+			return bits;
+		}
+
+		pool<RTLIL::Cell*> visited;
+		std::vector<RTLIL::Cell*> stack;
+		stack.push_back(root);
+		visited.insert(root);
+
+		while (!stack.empty())
+		{
+			RTLIL::Cell *cell = stack.back();
+			stack.pop_back();
+
+			for (auto c : topo_cell_drivers[cell]) {
+				if (cone_index.count(c)) {
+					cone_bits_merge(bits, cone_index.at(c));
+					cone_bits_set(bits, cone_cells.at(c));
+				} else if (!visited.count(c)) {
+					visited.insert(c);
+					stack.push_back(c);
+				}
 			}
+		}
 
-		return found_scc;
+		return bits;
+	}
+
+	// Mirror the topo_cell_drivers update for a merged cell pair in the reachability index
+	void update_cone_index(RTLIL::Cell *supercell, RTLIL::Cell *cell, RTLIL::Cell *other_cell)
+	{
+		if (!cone_index_valid)
+			return;
+
+		int supercell_idx = cone_cells(supercell);
+		cone_bits_t supercell_bits = find_input_cone_bits(supercell);
+		cone_index[supercell] = supercell_bits;
+
+		cone_bits_t bits = supercell_bits;
+		cone_bits_set(bits, supercell_idx);
+
+		int cell_idx = cone_cells(cell);
+		int other_cell_idx = cone_cells(other_cell);
+
+		for (auto &it : cone_index)
+			if (cone_bits_get(it.second, cell_idx) || cone_bits_get(it.second, other_cell_idx))
+				cone_bits_merge(it.second, bits);
+
+		cone_index[cell] = bits;
+		cone_index[other_cell] = bits;
 	}
 
 	bool find_in_input_cone_worker(RTLIL::Cell *root, RTLIL::Cell *needle, pool<RTLIL::Cell*> &stop)
@@ -1061,8 +1207,21 @@ struct ShareWorker
 
 	bool find_in_input_cone(RTLIL::Cell *root, RTLIL::Cell *needle)
 	{
-		pool<RTLIL::Cell*> stop;
-		return find_in_input_cone_worker(root, needle, stop);
+		cone_timer.begin();
+		cone_queries++;
+
+		bool found;
+		if (root == needle) {
+			found = true;
+		} else if (cone_index_valid && cone_index.count(root) && cone_cells.count(needle)) {
+			found = cone_bits_get(cone_index.at(root), cone_cells.at(needle));
+		} else {
+			pool<RTLIL::Cell*> stop;
+			found = find_in_input_cone_worker(root, needle, stop);
+		}
+
+		cone_timer.end();
+		return found;
 	}
 
 	bool is_part_of_scc(RTLIL::Cell *cell)
@@ -1152,6 +1311,10 @@ struct ShareWorker
 		log("Found %d cells in module %s that may be considered for resource sharing.\n",
 				GetSize(shareable_cells), log_id(module));
 
+		cone_timer.begin();
+		build_cone_index();
+		cone_timer.end();
+
 		for (auto cell : module->cells())
 			if (cell->type == ID($pmux))
 				for (auto bit : cell->getPort(ID(S)))
@@ -1399,6 +1562,10 @@ struct ShareWorker
 				topo_cell_drivers[cell] = { supercell };
 				topo_cell_drivers[other_cell] = { supercell };
 
+				cone_timer.begin();
+				update_cone_index(supercell, cell, other_cell);
+				cone_timer.end();
+
 				if (config.limit > 0)
 					config.limit--;
 
@@ -1416,6 +1583,9 @@ struct ShareWorker
 
 		log_assert(recursion_state.empty());
 
+		log("Performed %d input cone queries (%s).\n", cone_queries, cone_index_valid ? "indexed" : "dfs");
+		log_debug("Spent %.3f seconds in input cone queries.\n", cone_timer.sec());
+
 	#ifndef NDEBUG
 		bool after_scc = before_scc || module_has_scc();
 		log_assert(before_scc == after_scc);
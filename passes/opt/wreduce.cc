@@ -51,11 +51,15 @@ struct WreduceWorker
 	ModIndex mi;
 
 	std::set<Cell*, IdString::compare_ptr_by_name<Cell>> work_queue_cells;
-	std::set<SigBit> work_queue_bits;
+	pool<SigBit> work_queue_bits;
 	pool<SigBit> keep_bits;
 	dict<SigBit, State> init_bits;
 	pool<SigBit> remove_init_bits;
 
+	// number of changes made to cells, and the cells that were changed
+	int count_changes = 0;
+	pool<IdString> reduced_cells;
+
 	WreduceWorker(WreduceConfig *config, Module *module) :
 			config(config), module(module), mi(module) { }
 
@@ -100,6 +104,8 @@ struct WreduceWorker
 		for (int i = GetSize(bits_removed)-1; i >= 0; i--)
 			sig_removed.append_bit(bits_removed[i]);
 
+		count_changes++;
+
 		if (GetSize(bits_removed) == GetSize(sig_y)) {
 			log("Removed cell %s.%s (%s).\n", log_id(module), log_id(cell), log_id(cell->type));
 			module->connect(sig_y, sig_removed);
@@ -197,6 +203,8 @@ struct WreduceWorker
 		if (width_before == GetSize(sig_q))
 			return;
 
+		count_changes++;
+
 		if (GetSize(sig_q) == 0) {
 			log("Removed cell %s.%s (%s).\n", log_id(module), log_id(cell), log_id(cell->type));
 			module->remove(cell);
@@ -252,6 +260,7 @@ struct WreduceWorker
 			log("Removed top %d bits (of %d) from port %c of cell %s.%s (%s).\n",
 					bits_removed, GetSize(sig) + bits_removed, port, log_id(module), log_id(cell), log_id(cell->type));
 			cell->setPort(stringf("\\%c", port), sig);
+			count_changes++;
 			did_something = true;
 		}
 	}
@@ -304,6 +313,7 @@ struct WreduceWorker
 				cell->setParam(ID(B_SIGNED), 0);
 				port_a_signed = false;
 				port_b_signed = false;
+				count_changes++;
 				did_something = true;
 			}
 		}
@@ -315,6 +325,7 @@ struct WreduceWorker
 						log_id(module), log_id(cell), log_id(cell->type));
 				cell->setParam(ID(A_SIGNED), 0);
 				port_a_signed = false;
+				count_changes++;
 				did_something = true;
 			}
 		}
@@ -367,6 +378,7 @@ struct WreduceWorker
 		if (GetSize(sig) == 0) {
 			log("Removed cell %s.%s (%s).\n", log_id(module), log_id(cell), log_id(cell->type));
 			module->remove(cell);
+			count_changes++;
 			return;
 		}
 
@@ -374,6 +386,7 @@ struct WreduceWorker
 			log("Removed top %d bits (of %d) from port Y of cell %s.%s (%s).\n",
 					bits_removed, GetSize(sig) + bits_removed, log_id(module), log_id(cell), log_id(cell->type));
 			cell->setPort(ID::Y, sig);
+			count_changes++;
 			did_something = true;
 		}
 
@@ -415,8 +428,13 @@ struct WreduceWorker
 		while (!work_queue_cells.empty())
 		{
 			work_queue_bits.clear();
-			for (auto c : work_queue_cells)
+			for (auto c : work_queue_cells) {
+				IdString name = c->name;
+				int changes_before = count_changes;
 				run_cell(c);
+				if (count_changes != changes_before)
+					reduced_cells.insert(name);
+			}
 
 			work_queue_cells.clear();
 			for (auto bit : work_queue_bits)
@@ -520,11 +538,17 @@ struct WreducePass : public Pass {
 		}
 		extra_args(args, argidx, design);
 
+		PerformanceTimer timer;
+		int count_modules = 0, count_cells = 0;
+		timer.begin();
+
 		for (auto module : design->selected_modules())
 		{
 			if (module->has_processes_warn())
 				continue;
 
+			pool<IdString> reduced_cells;
+
 			for (auto c : module->selected_cells())
 			{
 				if (c->type.in(ID($reduce_and), ID($reduce_or), ID($reduce_xor), ID($reduce_xnor), ID($reduce_bool),
@@ -536,6 +560,7 @@ struct WreducePass : public Pass {
 						c->setParam(ID(Y_WIDTH), 1);
 						sig.remove(0);
 						module->connect(sig, Const(0, GetSize(sig)));
+						reduced_cells.insert(c->name);
 					}
 				}
 
@@ -555,6 +580,7 @@ struct WreducePass : public Pass {
 								original_a_width-GetSize(A), original_a_width, log_id(module), log_id(c), log_id(c->type));
 						c->setPort(ID::A, A);
 						c->setParam(ID(A_WIDTH), GetSize(A));
+						reduced_cells.insert(c->name);
 					}
 
 					SigSpec B = c->getPort(ID::B);
@@ -571,6 +597,7 @@ struct WreducePass : public Pass {
 								original_b_width-GetSize(B), original_b_width, log_id(module), log_id(c), log_id(c->type));
 						c->setPort(ID::B, B);
 						c->setParam(ID(B_WIDTH), GetSize(B));
+						reduced_cells.insert(c->name);
 					}
 				}
 
@@ -587,6 +614,7 @@ struct WreducePass : public Pass {
 									log_id(module), log_id(c), log_id(memid));
 							c->setParam(ID(ABITS), max_addrbits);
 							c->setPort(ID(ADDR), c->getPort(ID(ADDR)).extract(0, max_addrbits));
+							reduced_cells.insert(c->name);
 						}
 					}
 				}
@@ -594,7 +622,17 @@ struct WreducePass : public Pass {
 
 			WreduceWorker worker(&config, module);
 			worker.run();
+
+			for (auto name : worker.reduced_cells)
+				reduced_cells.insert(name);
+			count_cells += GetSize(reduced_cells);
+			count_modules++;
 		}
+
+		timer.end();
+		log("Reduced %d cells in %d modules.\n", count_cells, count_modules);
+		log_debug("Spent %.3f seconds (%.0f cells per second).\n",
+				timer.sec(), timer.sec() > 0 ? count_cells / timer.sec() : 0.0);
 	}
 } WreducePass;
 
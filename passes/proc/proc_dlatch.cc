@@ -123,9 +123,9 @@ struct proc_dlatch_db_t
 
 		unsigned int hash() const {
 			unsigned int h = mkhash_init;
-			mkhash(h, signal.hash());
-			mkhash(h, match.hash());
-			for (auto i : children) mkhash(h, i);
+			h = mkhash(h, signal.hash());
+			h = mkhash(h, match.hash());
+			for (auto i : children) h = mkhash(h, i);
 			return h;
 		}
 	};
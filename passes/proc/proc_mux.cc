@@ -113,6 +113,13 @@ struct SnippetSwCache
 	const SigSnippets *snippets;
 	int current_snippet;
 
+	// the cases that assign each snippet, in tree order
+	dict<int, vector<int>> snippet_cases;
+	int case_counter = 0;
+
+	// compare logic of each case, shared by all snippets
+	dict<RTLIL::CaseRule*, RTLIL::SigSpec, hash_ptr_ops> cmp_cache;
+
 	bool check(RTLIL::SwitchRule *sw)
 	{
 		return cache[sw].count(current_snippet) != 0;
@@ -120,6 +127,8 @@ struct SnippetSwCache
 
 	void insert(const RTLIL::CaseRule *cs, vector<RTLIL::SwitchRule*> &sw_stack)
 	{
+		int case_idx = case_counter++;
+
 		for (auto &action : cs->actions)
 		for (auto bit : action.first) {
 			int sn = snippets->bit2snippet.at(bit, -1);
@@ -127,6 +136,9 @@ struct SnippetSwCache
 				continue;
 			for (auto sw : sw_stack)
 				cache[sw].insert(sn);
+			vector<int> &cases = snippet_cases[sn];
+			if (cases.empty() || cases.back() != case_idx)
+				cases.push_back(case_idx);
 		}
 
 		for (auto sw : cs->switches) {
@@ -150,8 +162,14 @@ void apply_attrs(RTLIL::Cell *cell, const RTLIL::SwitchRule *sw, const RTLIL::Ca
 	cell->add_strpool_attribute("\\src", cs->get_strpool_attribute("\\src"));
 }
 
-RTLIL::SigSpec gen_cmp(RTLIL::Module *mod, const RTLIL::SigSpec &signal, const std::vector<RTLIL::SigSpec> &compare, RTLIL::SwitchRule *sw, RTLIL::CaseRule *cs, bool ifxmode)
+RTLIL::SigSpec gen_cmp(RTLIL::Module *mod, SnippetSwCache &swcache, const RTLIL::SigSpec &signal, const std::vector<RTLIL::SigSpec> &compare, RTLIL::SwitchRule *sw, RTLIL::CaseRule *cs, bool ifxmode)
 {
+	auto cached = swcache.cmp_cache.find(cs);
+	if (cached != swcache.cmp_cache.end())
+		return cached->second;
+
+	RTLIL::SigSpec &ctrl_sig = swcache.cmp_cache[cs];
+
 	std::stringstream sstr;
 	sstr << "$procmux$" << (autoidx++);
 
@@ -169,7 +187,7 @@ RTLIL::SigSpec gen_cmp(RTLIL::Module *mod, const RTLIL::SigSpec &signal, const s
 				comp.remove(i--);
 			}
 		if (comp.size() == 0)
-			return RTLIL::SigSpec();
+			return ctrl_sig;
 
 		if (sig.size() == 1 && comp == RTLIL::SigSpec(1,1) && !ifxmode)
 		{
@@ -215,10 +233,11 @@ RTLIL::SigSpec gen_cmp(RTLIL::Module *mod, const RTLIL::SigSpec &signal, const s
 		any_cell->setPort("\\Y", RTLIL::SigSpec(ctrl_wire));
 	}
 
-	return RTLIL::SigSpec(ctrl_wire);
+	ctrl_sig = ctrl_wire;
+	return ctrl_sig;
 }
 
-RTLIL::SigSpec gen_mux(RTLIL::Module *mod, const RTLIL::SigSpec &signal, const std::vector<RTLIL::SigSpec> &compare, RTLIL::SigSpec when_signal, RTLIL::SigSpec else_signal, RTLIL::Cell *&last_mux_cell, RTLIL::SwitchRule *sw, RTLIL::CaseRule *cs, bool ifxmode)
+RTLIL::SigSpec gen_mux(RTLIL::Module *mod, SnippetSwCache &swcache, const RTLIL::SigSpec &signal, const std::vector<RTLIL::SigSpec> &compare, RTLIL::SigSpec when_signal, RTLIL::SigSpec else_signal, RTLIL::Cell *&last_mux_cell, RTLIL::SwitchRule *sw, RTLIL::CaseRule *cs, bool ifxmode)
 {
 	log_assert(when_signal.size() == else_signal.size());
 
@@ -230,7 +249,7 @@ RTLIL::SigSpec gen_mux(RTLIL::Module *mod, const RTLIL::SigSpec &signal, const s
 		return when_signal;
 
 	// compare results
-	RTLIL::SigSpec ctrl_sig = gen_cmp(mod, signal, compare, sw, cs, ifxmode);
+	RTLIL::SigSpec ctrl_sig = gen_cmp(mod, swcache, signal, compare, sw, cs, ifxmode);
 	if (ctrl_sig.size() == 0)
 		return when_signal;
 	log_assert(ctrl_sig.size() == 1);
@@ -252,7 +271,7 @@ RTLIL::SigSpec gen_mux(RTLIL::Module *mod, const RTLIL::SigSpec &signal, const s
 	return RTLIL::SigSpec(result_wire);
 }
 
-void append_pmux(RTLIL::Module *mod, const RTLIL::SigSpec &signal, const std::vector<RTLIL::SigSpec> &compare, RTLIL::SigSpec when_signal, RTLIL::Cell *last_mux_cell, RTLIL::SwitchRule *sw, RTLIL::CaseRule *cs, bool ifxmode)
+void append_pmux(RTLIL::Module *mod, SnippetSwCache &swcache, const RTLIL::SigSpec &signal, const std::vector<RTLIL::SigSpec> &compare, RTLIL::SigSpec when_signal, RTLIL::Cell *last_mux_cell, RTLIL::SwitchRule *sw, RTLIL::CaseRule *cs, bool ifxmode)
 {
 	log_assert(last_mux_cell != NULL);
 	log_assert(when_signal.size() == last_mux_cell->getPort("\\A").size());
@@ -260,7 +279,7 @@ void append_pmux(RTLIL::Module *mod, const RTLIL::SigSpec &signal, const std::ve
 	if (when_signal == last_mux_cell->getPort("\\A"))
 		return;
 
-	RTLIL::SigSpec ctrl_sig = gen_cmp(mod, signal, compare, sw, cs, ifxmode);
+	RTLIL::SigSpec ctrl_sig = gen_cmp(mod, swcache, signal, compare, sw, cs, ifxmode);
 	log_assert(ctrl_sig.size() == 1);
 	last_mux_cell->type = "$pmux";
 
@@ -401,9 +420,9 @@ RTLIL::SigSpec signal_to_mux_tree(RTLIL::Module *mod, SnippetSwCache &swcache, d
 			RTLIL::CaseRule *cs2 = sw->cases[case_idx];
 			RTLIL::SigSpec value = signal_to_mux_tree(mod, swcache, swpara, cs2, sig, initial_val, ifxmode);
 			if (last_mux_cell && pgroups[case_idx] == pgroups[case_idx+1])
-				append_pmux(mod, sw->signal, cs2->compare, value, last_mux_cell, sw, cs2, ifxmode);
+				append_pmux(mod, swcache, sw->signal, cs2->compare, value, last_mux_cell, sw, cs2, ifxmode);
 			else
-				result = gen_mux(mod, sw->signal, cs2->compare, value, result, last_mux_cell, sw, cs2, ifxmode);
+				result = gen_mux(mod, swcache, sw->signal, cs2->compare, value, result, last_mux_cell, sw, cs2, ifxmode);
 		}
 	}
 
@@ -423,13 +442,23 @@ void proc_mux(RTLIL::Module *mod, RTLIL::Process *proc, bool ifxmode)
 
 	dict<RTLIL::SwitchRule*, bool, hash_ptr_ops> swpara;
 
-	int cnt = 0;
+	// Snippets that are assigned in the same cases go through the same
+	// switches and get the same mux structure, so they are handled together
+	// and share one wide $mux/$pmux per switch.
+	dict<vector<int>, vector<int>> snippet_groups;
 	for (int idx : sigsnip.snippets)
+		snippet_groups[swcache.snippet_cases[idx]].push_back(idx);
+
+	int cnt = 0;
+	for (auto &it : snippet_groups)
 	{
-		swcache.current_snippet = idx;
-		RTLIL::SigSpec sig = sigsnip.sigidx[idx];
+		swcache.current_snippet = it.second.front();
+		RTLIL::SigSpec sig;
+		for (int idx : it.second)
+			sig.append(sigsnip.sigidx[idx]);
 
-		log("%6d/%d: %s\n", ++cnt, GetSize(sigsnip.snippets), log_signal(sig));
+		cnt += GetSize(it.second);
+		log("%6d/%d: %s\n", cnt, GetSize(sigsnip.snippets), log_signal(sig));
 
 		RTLIL::SigSpec value = signal_to_mux_tree(mod, swcache, swpara, &proc->root_case, sig, RTLIL::SigSpec(RTLIL::State::Sx, sig.size()), ifxmode);
 		mod->connect(RTLIL::SigSig(sig, value));
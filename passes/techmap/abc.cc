@@ -45,7 +45,9 @@
 #include "kernel/sigtools.h"
 #include "kernel/celltypes.h"
 #include "kernel/cost.h"
+#include "kernel/scc.h"
 #include "kernel/log.h"
+#include "kernel/log_trace.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -60,6 +62,7 @@
 #endif
 
 #include "frontends/blif/blifparse.h"
+#include "passes/techmap/abc_link.h"
 
 #ifdef YOSYS_LINK_ABC
 extern "C" int Abc_RealMain(int argc, char *argv[]);
@@ -164,29 +167,30 @@ void mark_port(RTLIL::SigSpec sig)
 			signal_list[signal_map[bit]].is_port = true;
 }
 
-void extract_cell(RTLIL::Cell *cell, bool keepff)
+// returns true if the cell was turned into gates for abc and must be removed
+bool extract_cell(RTLIL::Cell *cell, bool keepff)
 {
 	if (cell->type.in(ID($_DFF_N_), ID($_DFF_P_)))
 	{
 		if (clk_polarity != (cell->type == ID($_DFF_P_)))
-			return;
+			return false;
 		if (clk_sig != assign_map(cell->getPort(ID(C))))
-			return;
+			return false;
 		if (GetSize(en_sig) != 0)
-			return;
+			return false;
 		goto matching_dff;
 	}
 
 	if (cell->type.in(ID($_DFFE_NN_), ID($_DFFE_NP_), ID($_DFFE_PN_), ID($_DFFE_PP_)))
 	{
 		if (clk_polarity != cell->type.in(ID($_DFFE_PN_), ID($_DFFE_PP_)))
-			return;
+			return false;
 		if (en_polarity != cell->type.in(ID($_DFFE_NP_), ID($_DFFE_PP_)))
-			return;
+			return false;
 		if (clk_sig != assign_map(cell->getPort(ID(C))))
-			return;
+			return false;
 		if (en_sig != assign_map(cell->getPort(ID(E))))
-			return;
+			return false;
 		goto matching_dff;
 	}
 
@@ -205,8 +209,7 @@ void extract_cell(RTLIL::Cell *cell, bool keepff)
 
 		map_signal(sig_q, G(FF), map_signal(sig_d));
 
-		module->remove(cell);
-		return;
+		return true;
 	}
 
 	if (cell->type.in(ID($_BUF_), ID($_NOT_)))
@@ -219,8 +222,7 @@ void extract_cell(RTLIL::Cell *cell, bool keepff)
 
 		map_signal(sig_y, cell->type == ID($_BUF_) ? G(BUF) : G(NOT), map_signal(sig_a));
 
-		module->remove(cell);
-		return;
+		return true;
 	}
 
 	if (cell->type.in(ID($_AND_), ID($_NAND_), ID($_OR_), ID($_NOR_), ID($_XOR_), ID($_XNOR_), ID($_ANDNOT_), ID($_ORNOT_)))
@@ -255,8 +257,7 @@ void extract_cell(RTLIL::Cell *cell, bool keepff)
 		else
 			log_abort();
 
-		module->remove(cell);
-		return;
+		return true;
 	}
 
 	if (cell->type.in(ID($_MUX_), ID($_NMUX_)))
@@ -277,8 +278,7 @@ void extract_cell(RTLIL::Cell *cell, bool keepff)
 
 		map_signal(sig_y, cell->type == ID($_MUX_) ? G(MUX) : G(NMUX), mapped_a, mapped_b, mapped_s);
 
-		module->remove(cell);
-		return;
+		return true;
 	}
 
 	if (cell->type.in(ID($_AOI3_), ID($_OAI3_)))
@@ -299,8 +299,7 @@ void extract_cell(RTLIL::Cell *cell, bool keepff)
 
 		map_signal(sig_y, cell->type == ID($_AOI3_) ? G(AOI3) : G(OAI3), mapped_a, mapped_b, mapped_c);
 
-		module->remove(cell);
-		return;
+		return true;
 	}
 
 	if (cell->type.in(ID($_AOI4_), ID($_OAI4_)))
@@ -324,9 +323,10 @@ void extract_cell(RTLIL::Cell *cell, bool keepff)
 
 		map_signal(sig_y, cell->type == ID($_AOI4_) ? G(AOI4) : G(OAI4), mapped_a, mapped_b, mapped_c, mapped_d);
 
-		module->remove(cell);
-		return;
+		return true;
 	}
+
+	return false;
 }
 
 std::string remap_name(RTLIL::IdString abc_name, RTLIL::Wire **orig_wire = nullptr)
@@ -409,6 +409,26 @@ void handle_loops()
 	FILE *dot_f = NULL;
 	int dot_nr = 0;
 
+	// most netlists have no loops at all: check that first with a
+	// linear-time SCC search before running the loop breaking below
+
+	SccGraph scc_graph;
+	for (int i = 0; i < GetSize(signal_list); i++)
+		scc_graph.node();
+
+	for (auto &g : signal_list) {
+		if (g.type == G(NONE) || g.type == G(FF))
+			continue;
+		for (int in : {g.in1, g.in2, g.in3, g.in4})
+			if (in >= 0)
+				scc_graph.edge(in, g.id);
+	}
+
+	scc_graph.find();
+
+	if (!scc_graph.found_loops())
+		return;
+
 	// uncomment for troubleshooting the loop detection code
 	// dot_f = fopen("test.dot", "w");
 
@@ -655,11 +675,36 @@ struct abc_output_filter
 	}
 };
 
+// SOP cover (in BLIF notation) for the internal gate types
+const char *gate_cover(gate_type_t type)
+{
+	switch (type) {
+		case G(BUF):    return "1 1\n";
+		case G(NOT):    return "0 1\n";
+		case G(AND):    return "11 1\n";
+		case G(NAND):   return "0- 1\n-0 1\n";
+		case G(OR):     return "-1 1\n1- 1\n";
+		case G(NOR):    return "00 1\n";
+		case G(XOR):    return "01 1\n10 1\n";
+		case G(XNOR):   return "00 1\n11 1\n";
+		case G(ANDNOT): return "10 1\n";
+		case G(ORNOT):  return "1- 1\n-0 1\n";
+		case G(MUX):    return "1-0 1\n-11 1\n";
+		case G(NMUX):   return "0-0 1\n-01 1\n";
+		case G(AOI3):   return "-00 1\n0-0 1\n";
+		case G(OAI3):   return "00- 1\n--0 1\n";
+		case G(AOI4):   return "-0-0 1\n-00- 1\n0--0 1\n0-0- 1\n";
+		case G(OAI4):   return "00-- 1\n--00 1\n";
+		default:        log_abort();
+	}
+}
+
 void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::string script_file, std::string exe_file,
 		std::string liberty_file, std::string constr_file, bool cleanup, vector<int> lut_costs, bool dff_mode, std::string clk_str,
 		bool keepff, std::string delay_target, std::string sop_inputs, std::string sop_products, std::string lutin_shared, bool fast_mode,
 		const std::vector<RTLIL::Cell*> &cells, bool show_tempdir, bool sop_mode, bool abc_dress)
 {
+	LogTraceSpan trace_span("abc module", current_module);
 	module = current_module;
 	map_autoidx = autoidx++;
 
@@ -706,10 +751,23 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 	if (!cleanup)
 		tempdir_name[0] = tempdir_name[4] = '_';
 	tempdir_name = make_temp_dir(tempdir_name);
-	log_header(design, "Extracting gate netlist of module `%s' to `%s/input.blif'..\n",
-			module->name.c_str(), replace_tempdir(tempdir_name, tempdir_name, show_tempdir).c_str());
 
-	std::string abc_script = stringf("read_blif %s/input.blif; ", tempdir_name.c_str());
+	// With a linked-in ABC the netlist is passed to ABC in memory, unless the
+	// user wants to inspect the temp files or 'dress' needs the input file.
+#ifdef YOSYS_LINK_ABC
+	bool link_mode = cleanup && !abc_dress;
+#else
+	bool link_mode = false;
+#endif
+
+	std::string abc_script;
+	if (link_mode) {
+		log_header(design, "Extracting gate netlist of module `%s'..\n", module->name.c_str());
+	} else {
+		log_header(design, "Extracting gate netlist of module `%s' to `%s/input.blif'..\n",
+				module->name.c_str(), replace_tempdir(tempdir_name, tempdir_name, show_tempdir).c_str());
+		abc_script += stringf("read_blif %s/input.blif; ", tempdir_name.c_str());
+	}
 
 	if (!liberty_file.empty()) {
 		abc_script += stringf("read_lib -w %s; ", liberty_file.c_str());
@@ -760,16 +818,20 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 		abc_script = abc_script.substr(0, pos) + lutin_shared + abc_script.substr(pos+3);
 	if (abc_dress)
 		abc_script += "; dress";
-	abc_script += stringf("; write_blif %s/output.blif", tempdir_name.c_str());
+	if (!link_mode)
+		abc_script += stringf("; write_blif %s/output.blif", tempdir_name.c_str());
 	abc_script = add_echos_to_abc_cmd(abc_script);
 
-	for (size_t i = 0; i+1 < abc_script.size(); i++)
-		if (abc_script[i] == ';' && abc_script[i+1] == ' ')
-			abc_script[i+1] = '\n';
+	FILE *f;
+	if (!link_mode) {
+		for (size_t i = 0; i+1 < abc_script.size(); i++)
+			if (abc_script[i] == ';' && abc_script[i+1] == ' ')
+				abc_script[i+1] = '\n';
 
-	FILE *f = fopen(stringf("%s/abc.script", tempdir_name.c_str()).c_str(), "wt");
-	fprintf(f, "%s\n", abc_script.c_str());
-	fclose(f);
+		f = fopen(stringf("%s/abc.script", tempdir_name.c_str()).c_str(), "wt");
+		fprintf(f, "%s\n", abc_script.c_str());
+		fclose(f);
+	}
 
 	if (dff_mode || !clk_str.empty())
 	{
@@ -783,8 +845,11 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 		}
 	}
 
+	pool<RTLIL::Cell*> extracted_cells;
 	for (auto c : cells)
-		extract_cell(c, keepff);
+		if (extract_cell(c, keepff))
+			extracted_cells.insert(c);
+	module->remove(extracted_cells);
 
 	for (auto &wire_it : module->wires_) {
 		if (wire_it.second->port_id > 0 || wire_it.second->get_bool_attribute(ID::keep))
@@ -803,123 +868,94 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 
 	handle_loops();
 
-	std::string buffer = stringf("%s/input.blif", tempdir_name.c_str());
-	f = fopen(buffer.c_str(), "wt");
-	if (f == NULL)
-		log_error("Opening %s for writing failed: %s\n", buffer.c_str(), strerror(errno));
-
-	fprintf(f, ".model netlist\n");
-
-	int count_input = 0;
-	fprintf(f, ".inputs");
+	int count_input = 0, count_output = 0, count_gates = 0;
 	for (auto &si : signal_list) {
-		if (!si.is_port || si.type != G(NONE))
-			continue;
-		fprintf(f, " ys__n%d", si.id);
-		pi_map[count_input++] = log_signal(si.bit);
+		if (si.is_port && si.type == G(NONE))
+			pi_map[count_input++] = log_signal(si.bit);
+		if (si.is_port && si.type != G(NONE))
+			po_map[count_output++] = log_signal(si.bit);
+		if (si.type == G(FF) && (si.init == State::S0 || si.init == State::S1))
+			recover_init = true;
+		if (si.type != G(NONE))
+			count_gates++;
 	}
-	if (count_input == 0)
-		fprintf(f, " dummy_input\n");
-	fprintf(f, "\n");
 
-	int count_output = 0;
-	fprintf(f, ".outputs");
-	for (auto &si : signal_list) {
-		if (!si.is_port || si.type == G(NONE))
-			continue;
-		fprintf(f, " ys__n%d", si.id);
-		po_map[count_output++] = log_signal(si.bit);
+	std::string buffer;
+	AbcLinkNetwork link_network;
+
+	if (link_mode)
+	{
+		for (auto &si : signal_list) {
+			if (si.is_port && si.type == G(NONE))
+				link_network.inputs.push_back(si.id);
+			if (si.is_port && si.type != G(NONE))
+				link_network.outputs.push_back(si.id);
+			if (si.bit.wire == NULL)
+				link_network.nodes.push_back({si.id, {}, si.bit == RTLIL::State::S1 ? " 1\n" : " 0\n"});
+			if (si.type == G(FF))
+				link_network.latches.push_back({si.in1, si.id, si.init == State::S0 ? 0 : si.init == State::S1 ? 1 : 2});
+			else if (si.type != G(NONE)) {
+				AbcLinkNetwork::node_t node = {si.id, {}, gate_cover(si.type)};
+				for (int in : {si.in1, si.in2, si.in3, si.in4})
+					if (in >= 0)
+						node.inputs.push_back(in);
+				link_network.nodes.push_back(node);
+			}
+		}
 	}
-	fprintf(f, "\n");
+	else
+	{
+		buffer = stringf("%s/input.blif", tempdir_name.c_str());
+		f = fopen(buffer.c_str(), "wt");
+		if (f == NULL)
+			log_error("Opening %s for writing failed: %s\n", buffer.c_str(), strerror(errno));
 
-	for (auto &si : signal_list)
-		fprintf(f, "# ys__n%-5d %s\n", si.id, log_signal(si.bit));
+		fprintf(f, ".model netlist\n");
 
-	for (auto &si : signal_list) {
-		if (si.bit.wire == NULL) {
-			fprintf(f, ".names ys__n%d\n", si.id);
-			if (si.bit == RTLIL::State::S1)
-				fprintf(f, "1\n");
+		fprintf(f, ".inputs");
+		for (auto &si : signal_list)
+			if (si.is_port && si.type == G(NONE))
+				fprintf(f, " ys__n%d", si.id);
+		if (count_input == 0)
+			fprintf(f, " dummy_input\n");
+		fprintf(f, "\n");
+
+		fprintf(f, ".outputs");
+		for (auto &si : signal_list)
+			if (si.is_port && si.type != G(NONE))
+				fprintf(f, " ys__n%d", si.id);
+		fprintf(f, "\n");
+
+		for (auto &si : signal_list)
+			fprintf(f, "# ys__n%-5d %s\n", si.id, log_signal(si.bit));
+
+		for (auto &si : signal_list) {
+			if (si.bit.wire == NULL) {
+				fprintf(f, ".names ys__n%d\n", si.id);
+				if (si.bit == RTLIL::State::S1)
+					fprintf(f, "1\n");
+			}
 		}
-	}
 
-	int count_gates = 0;
-	for (auto &si : signal_list) {
-		if (si.type == G(BUF)) {
-			fprintf(f, ".names ys__n%d ys__n%d\n", si.in1, si.id);
-			fprintf(f, "1 1\n");
-		} else if (si.type == G(NOT)) {
-			fprintf(f, ".names ys__n%d ys__n%d\n", si.in1, si.id);
-			fprintf(f, "0 1\n");
-		} else if (si.type == G(AND)) {
-			fprintf(f, ".names ys__n%d ys__n%d ys__n%d\n", si.in1, si.in2, si.id);
-			fprintf(f, "11 1\n");
-		} else if (si.type == G(NAND)) {
-			fprintf(f, ".names ys__n%d ys__n%d ys__n%d\n", si.in1, si.in2, si.id);
-			fprintf(f, "0- 1\n");
-			fprintf(f, "-0 1\n");
-		} else if (si.type == G(OR)) {
-			fprintf(f, ".names ys__n%d ys__n%d ys__n%d\n", si.in1, si.in2, si.id);
-			fprintf(f, "-1 1\n");
-			fprintf(f, "1- 1\n");
-		} else if (si.type == G(NOR)) {
-			fprintf(f, ".names ys__n%d ys__n%d ys__n%d\n", si.in1, si.in2, si.id);
-			fprintf(f, "00 1\n");
-		} else if (si.type == G(XOR)) {
-			fprintf(f, ".names ys__n%d ys__n%d ys__n%d\n", si.in1, si.in2, si.id);
-			fprintf(f, "01 1\n");
-			fprintf(f, "10 1\n");
-		} else if (si.type == G(XNOR)) {
-			fprintf(f, ".names ys__n%d ys__n%d ys__n%d\n", si.in1, si.in2, si.id);
-			fprintf(f, "00 1\n");
-			fprintf(f, "11 1\n");
-		} else if (si.type == G(ANDNOT)) {
-			fprintf(f, ".names ys__n%d ys__n%d ys__n%d\n", si.in1, si.in2, si.id);
-			fprintf(f, "10 1\n");
-		} else if (si.type == G(ORNOT)) {
-			fprintf(f, ".names ys__n%d ys__n%d ys__n%d\n", si.in1, si.in2, si.id);
-			fprintf(f, "1- 1\n");
-			fprintf(f, "-0 1\n");
-		} else if (si.type == G(MUX)) {
-			fprintf(f, ".names ys__n%d ys__n%d ys__n%d ys__n%d\n", si.in1, si.in2, si.in3, si.id);
-			fprintf(f, "1-0 1\n");
-			fprintf(f, "-11 1\n");
-		} else if (si.type == G(NMUX)) {
-			fprintf(f, ".names ys__n%d ys__n%d ys__n%d ys__n%d\n", si.in1, si.in2, si.in3, si.id);
-			fprintf(f, "0-0 1\n");
-			fprintf(f, "-01 1\n");
-		} else if (si.type == G(AOI3)) {
-			fprintf(f, ".names ys__n%d ys__n%d ys__n%d ys__n%d\n", si.in1, si.in2, si.in3, si.id);
-			fprintf(f, "-00 1\n");
-			fprintf(f, "0-0 1\n");
-		} else if (si.type == G(OAI3)) {
-			fprintf(f, ".names ys__n%d ys__n%d ys__n%d ys__n%d\n", si.in1, si.in2, si.in3, si.id);
-			fprintf(f, "00- 1\n");
-			fprintf(f, "--0 1\n");
-		} else if (si.type == G(AOI4)) {
-			fprintf(f, ".names ys__n%d ys__n%d ys__n%d ys__n%d ys__n%d\n", si.in1, si.in2, si.in3, si.in4, si.id);
-			fprintf(f, "-0-0 1\n");
-			fprintf(f, "-00- 1\n");
-			fprintf(f, "0--0 1\n");
-			fprintf(f, "0-0- 1\n");
-		} else if (si.type == G(OAI4)) {
-			fprintf(f, ".names ys__n%d ys__n%d ys__n%d ys__n%d ys__n%d\n", si.in1, si.in2, si.in3, si.in4, si.id);
-			fprintf(f, "00-- 1\n");
-			fprintf(f, "--00 1\n");
-		} else if (si.type == G(FF)) {
-			if (si.init == State::S0 || si.init == State::S1) {
-				fprintf(f, ".latch ys__n%d ys__n%d %d\n", si.in1, si.id, si.init == State::S1 ? 1 : 0);
-				recover_init = true;
-			} else
-				fprintf(f, ".latch ys__n%d ys__n%d 2\n", si.in1, si.id);
-		} else if (si.type != G(NONE))
-			log_abort();
-		if (si.type != G(NONE))
-			count_gates++;
-	}
+		for (auto &si : signal_list) {
+			if (si.type == G(FF)) {
+				if (si.init == State::S0 || si.init == State::S1)
+					fprintf(f, ".latch ys__n%d ys__n%d %d\n", si.in1, si.id, si.init == State::S1 ? 1 : 0);
+				else
+					fprintf(f, ".latch ys__n%d ys__n%d 2\n", si.in1, si.id);
+			} else if (si.type != G(NONE)) {
+				fprintf(f, ".names");
+				for (int in : {si.in1, si.in2, si.in3, si.in4})
+					if (in >= 0)
+						fprintf(f, " ys__n%d", in);
+				fprintf(f, " ys__n%d\n", si.id);
+				fprintf(f, "%s", gate_cover(si.type));
+			}
+		}
 
-	fprintf(f, ".end\n");
-	fclose(f);
+		fprintf(f, ".end\n");
+		fclose(f);
+	}
 
 	log("Extracted %d gates and %d wires to a netlist network with %d inputs and %d outputs.\n",
 			count_gates, GetSize(signal_list), count_input, count_output);
@@ -984,41 +1020,55 @@ void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std::strin
 			fclose(f);
 		}
 
-		buffer = stringf("%s -s -f %s/abc.script 2>&1", exe_file.c_str(), tempdir_name.c_str());
-		log("Running ABC command: %s\n", replace_tempdir(buffer, tempdir_name, show_tempdir).c_str());
+		bool builtin_lib = liberty_file.empty();
+		RTLIL::Design *mapped_design = new RTLIL::Design;
+
+		if (link_mode)
+		{
+#ifdef YOSYS_LINK_ABC
+			log("Running linked ABC on in-memory netlist: %s\n", replace_tempdir(abc_script, tempdir_name, show_tempdir).c_str());
+
+			abc_output_filter filt(tempdir_name, show_tempdir);
+			abc_link_run(link_network, abc_script, mapped_design, builtin_lib ? ID(DFF) : ID(_dff_), sop_mode,
+					std::bind(&abc_output_filter::next_line, filt, std::placeholders::_1));
+#endif
+		}
+		else
+		{
+			buffer = stringf("%s -s -f %s/abc.script 2>&1", exe_file.c_str(), tempdir_name.c_str());
+			log("Running ABC command: %s\n", replace_tempdir(buffer, tempdir_name, show_tempdir).c_str());
 
 #ifndef YOSYS_LINK_ABC
-		abc_output_filter filt(tempdir_name, show_tempdir);
-		int ret = run_command(buffer, std::bind(&abc_output_filter::next_line, filt, std::placeholders::_1));
+			abc_output_filter filt(tempdir_name, show_tempdir);
+			int ret = run_command(buffer, std::bind(&abc_output_filter::next_line, filt, std::placeholders::_1));
 #else
-		// These needs to be mutable, supposedly due to getopt
-		char *abc_argv[5];
-		string tmp_script_name = stringf("%s/abc.script", tempdir_name.c_str());
-		abc_argv[0] = strdup(exe_file.c_str());
-		abc_argv[1] = strdup("-s");
-		abc_argv[2] = strdup("-f");
-		abc_argv[3] = strdup(tmp_script_name.c_str());
-		abc_argv[4] = 0;
-		int ret = Abc_RealMain(4, abc_argv);
-		free(abc_argv[0]);
-		free(abc_argv[1]);
-		free(abc_argv[2]);
-		free(abc_argv[3]);
+			// These needs to be mutable, supposedly due to getopt
+			char *abc_argv[5];
+			string tmp_script_name = stringf("%s/abc.script", tempdir_name.c_str());
+			abc_argv[0] = strdup(exe_file.c_str());
+			abc_argv[1] = strdup("-s");
+			abc_argv[2] = strdup("-f");
+			abc_argv[3] = strdup(tmp_script_name.c_str());
+			abc_argv[4] = 0;
+			int ret = Abc_RealMain(4, abc_argv);
+			free(abc_argv[0]);
+			free(abc_argv[1]);
+			free(abc_argv[2]);
+			free(abc_argv[3]);
 #endif
-		if (ret != 0)
-			log_error("ABC: execution of command \"%s\" failed: return code %d.\n", buffer.c_str(), ret);
+			if (ret != 0)
+				log_error("ABC: execution of command \"%s\" failed: return code %d.\n", buffer.c_str(), ret);
 
-		buffer = stringf("%s/%s", tempdir_name.c_str(), "output.blif");
-		std::ifstream ifs;
-		ifs.open(buffer);
-		if (ifs.fail())
-			log_error("Can't open ABC output file `%s'.\n", buffer.c_str());
+			buffer = stringf("%s/%s", tempdir_name.c_str(), "output.blif");
+			std::ifstream ifs;
+			ifs.open(buffer);
+			if (ifs.fail())
+				log_error("Can't open ABC output file `%s'.\n", buffer.c_str());
 
-		bool builtin_lib = liberty_file.empty();
-		RTLIL::Design *mapped_design = new RTLIL::Design;
-		parse_blif(mapped_design, ifs, builtin_lib ? ID(DFF) : ID(_dff_), false, sop_mode);
+			parse_blif(mapped_design, ifs, builtin_lib ? ID(DFF) : ID(_dff_), false, sop_mode);
 
-		ifs.close();
+			ifs.close();
+		}
 
 		log_header(design, "Re-integrating ABC results.\n");
 		RTLIL::Module *mapped_mod = mapped_design->modules_[ID(netlist)];
@@ -1462,6 +1512,12 @@ struct AbcPass : public Pass {
 		log("When neither -liberty nor -lut is used, the Yosys standard cell library is\n");
 		log("loaded into ABC before the ABC script is executed.\n");
 		log("\n");
+		log("When Yosys is built with LINK_ABC=1, the extracted netlist is passed to the\n");
+		log("linked-in ABC in memory instead of being written to input.blif, the ABC\n");
+		log("commands run in the Yosys process and the mapped netlist is read back from\n");
+		log("memory. The file based flow is still used when -nocleanup or -dress is\n");
+		log("specified.\n");
+		log("\n");
 		log("Note that this is a logic optimization pass within Yosys that is calling ABC\n");
 		log("internally. This is not going to \"run ABC on your design\". It will instead run\n");
 		log("ABC on logic snippets extracted from your design. You will not get any useful\n");
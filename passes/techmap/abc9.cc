@@ -41,16 +41,20 @@
 #include "kernel/celltypes.h"
 #include "kernel/cost.h"
 #include "kernel/log.h"
+#include "kernel/log_trace.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <cerrno>
 #include <sstream>
 #include <climits>
+#include <chrono>
+#include <deque>
 
 #ifndef _WIN32
 #  include <unistd.h>
 #  include <dirent.h>
+#  include <poll.h>
 #endif
 
 #include "frontends/aiger/aigerparse.h"
@@ -71,6 +75,45 @@ RTLIL::Module *module;
 bool clk_polarity, en_polarity;
 RTLIL::SigSpec clk_sig, en_sig;
 
+// An extracted module whose ABC process may still be running. The extraction
+// and re-integration steps are serial (they modify the design), but the ABC
+// processes of independent modules can run concurrently in between.
+struct Abc9Job
+{
+	RTLIL::Module *module;
+	int map_autoidx;
+	std::string tempdir_name;
+	std::string command;
+	bool count_output;
+	bool cleanup;
+	FILE *abc_pipe;
+	std::string abc_output;
+	bool abc_eof;
+	int abc_ret;
+};
+
+// The jobs that have been started with 'abc9 -j N' but not re-integrated yet.
+std::deque<Abc9Job> running_jobs;
+
+// log_error() ends the process without unwinding the stack. Close the pipes of
+// all running jobs and remove their temp directories before an error is
+// reported, so that no ABC processes and temp files are left behind.
+void abc9_cleanup_jobs()
+{
+	for (auto &job : running_jobs) {
+		if (job.abc_pipe != nullptr) {
+			pclose(job.abc_pipe);
+			job.abc_pipe = nullptr;
+		}
+		if (job.cleanup)
+			remove_directory(job.tempdir_name);
+	}
+	running_jobs.clear();
+}
+
+PerformanceTimer extract_timer, reintegrate_timer;
+int64_t abc_wait_ns;
+
 inline std::string remap_name(RTLIL::IdString abc_name)
 {
 	return stringf("$abc$%d$%s", map_autoidx, abc_name.c_str()+1);
@@ -284,12 +327,20 @@ struct abc_output_filter
 	}
 };
 
-void abc9_module(RTLIL::Design *design, RTLIL::Module *current_module, std::string script_file, std::string exe_file,
+int64_t wall_clock_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Abc9Job abc9_module_extract(RTLIL::Design *design, RTLIL::Module *current_module, std::string script_file, std::string exe_file,
 		bool cleanup, vector<int> lut_costs, bool dff_mode, std::string clk_str,
 		bool /*keepff*/, std::string delay_target, std::string /*lutin_shared*/, bool fast_mode,
 		bool show_tempdir, std::string box_file, std::string lut_file,
-		std::string wire_delay, const dict<int,IdString> &box_lookup)
+		std::string wire_delay)
 {
+	LogTraceSpan trace_span("abc9 extract", current_module);
+	extract_timer.begin();
+
 	module = current_module;
 	map_autoidx = autoidx++;
 
@@ -419,6 +470,7 @@ void abc9_module(RTLIL::Design *design, RTLIL::Module *current_module, std::stri
 		}
 	}
 
+	std::string buffer;
 	log_push();
 
 	if (count_output)
@@ -436,9 +488,8 @@ void abc9_module(RTLIL::Design *design, RTLIL::Module *current_module, std::stri
 
 		Pass::call(design, stringf("write_xaiger -map %s/input.sym %s/input.xaig", tempdir_name.c_str(), tempdir_name.c_str()));
 
-		std::string buffer;
-		std::ifstream ifs;
 #if 0
+		std::ifstream ifs;
 		buffer = stringf("%s/%s", tempdir_name.c_str(), "input.xaig");
 		ifs.open(buffer);
 		if (ifs.fail())
@@ -479,8 +530,10 @@ void abc9_module(RTLIL::Design *design, RTLIL::Module *current_module, std::stri
 		if (!lut_costs.empty()) {
 			buffer = stringf("%s/lutdefs.txt", tempdir_name.c_str());
 			f = fopen(buffer.c_str(), "wt");
-			if (f == NULL)
+			if (f == NULL) {
+				abc9_cleanup_jobs();
 				log_error("Opening %s for writing failed: %s\n", buffer.c_str(), strerror(errno));
+			}
 			for (int i = 0; i < GetSize(lut_costs); i++)
 				fprintf(f, "%d %d.00 1.00\n", i+1, lut_costs.at(i));
 			fclose(f);
@@ -488,32 +541,168 @@ void abc9_module(RTLIL::Design *design, RTLIL::Module *current_module, std::stri
 
 		buffer = stringf("%s -s -f %s/abc.script 2>&1", exe_file.c_str(), tempdir_name.c_str());
 		log("Running ABC command: %s\n", replace_tempdir(buffer, tempdir_name, show_tempdir).c_str());
+	}
+	else
+	{
+		log("Don't call ABC as there is nothing to map.\n");
+	}
+
+	log_pop();
+
+	Abc9Job job;
+	job.module = module;
+	job.map_autoidx = map_autoidx;
+	job.tempdir_name = tempdir_name;
+	job.command = buffer;
+	job.count_output = count_output;
+	job.cleanup = cleanup;
+	job.abc_pipe = nullptr;
+	job.abc_eof = false;
+	job.abc_ret = 0;
+
+	extract_timer.end();
+	return job;
+}
+
+void abc9_module_start(Abc9Job &job, std::string exe_file YS_ATTRIBUTE(unused))
+{
+	if (!job.count_output)
+		return;
 
 #ifndef YOSYS_LINK_ABC
-		abc_output_filter filt(tempdir_name, show_tempdir);
-		int ret = run_command(buffer, std::bind(&abc_output_filter::next_line, filt, std::placeholders::_1));
+	job.abc_pipe = popen(job.command.c_str(), "r");
+	if (job.abc_pipe == nullptr)
+		job.abc_ret = -1;
+#else
+	// The linked-in ABC is not reentrant, so it runs to completion here.
+	// These needs to be mutable, supposedly due to getopt
+	char *abc_argv[5];
+	string tmp_script_name = stringf("%s/abc.script", job.tempdir_name.c_str());
+	abc_argv[0] = strdup(exe_file.c_str());
+	abc_argv[1] = strdup("-s");
+	abc_argv[2] = strdup("-f");
+	abc_argv[3] = strdup(tmp_script_name.c_str());
+	abc_argv[4] = 0;
+	int64_t start_ns = wall_clock_ns();
+	job.abc_ret = Abc_RealMain(4, abc_argv);
+	abc_wait_ns += wall_clock_ns() - start_ns;
+	free(abc_argv[0]);
+	free(abc_argv[1]);
+	free(abc_argv[2]);
+	free(abc_argv[3]);
+#endif
+}
+
+// Collects the output of running ABC processes. The output is only logged
+// once a job is re-integrated, but it has to be read as it is produced: a
+// process that fills its pipe blocks until the pipe is drained. With a
+// 'wait_job' this blocks until that job has closed its output, without one it
+// only reads what is available right now.
+void abc9_poll_jobs(const std::vector<Abc9Job*> &jobs, Abc9Job *wait_job)
+{
+	int64_t start_ns = wall_clock_ns();
+	char buffer[4096];
+
+#ifdef _WIN32
+	(void)jobs;
+	if (wait_job != nullptr && wait_job->abc_pipe != nullptr) {
+		size_t len;
+		while ((len = fread(buffer, 1, sizeof(buffer), wait_job->abc_pipe)) > 0)
+			wait_job->abc_output.append(buffer, len);
+		wait_job->abc_eof = true;
+	}
+#else
+	while (wait_job == nullptr || !wait_job->abc_eof)
+	{
+		std::vector<pollfd> fds;
+		std::vector<Abc9Job*> fd_jobs;
+		for (auto job : jobs) {
+			if (job->abc_pipe == nullptr || job->abc_eof)
+				continue;
+			pollfd pfd;
+			pfd.fd = fileno(job->abc_pipe);
+			pfd.events = POLLIN;
+			pfd.revents = 0;
+			fds.push_back(pfd);
+			fd_jobs.push_back(job);
+		}
+		if (fds.empty())
+			break;
+
+		int ready = poll(fds.data(), fds.size(), wait_job != nullptr ? -1 : 0);
+		if (ready < 0 && errno == EINTR)
+			continue;
+		if (ready < 0) {
+			abc9_cleanup_jobs();
+			log_error("ABC: waiting for the output of ABC failed: %s\n", strerror(errno));
+		}
+		if (ready == 0)
+			break;
+
+		for (int i = 0; i < GetSize(fds); i++) {
+			if (fds[i].revents == 0)
+				continue;
+			ssize_t len = read(fds[i].fd, buffer, sizeof(buffer));
+			if (len > 0)
+				fd_jobs[i]->abc_output.append(buffer, len);
+			else if (len == 0 || errno != EINTR)
+				fd_jobs[i]->abc_eof = true;
+		}
+	}
+#endif
+
+	if (wait_job != nullptr)
+		abc_wait_ns += wall_clock_ns() - start_ns;
+}
+
+void abc9_module_finish(RTLIL::Design *design, Abc9Job &job, bool cleanup, vector<int> lut_costs,
+		bool show_tempdir, std::string lut_file, const dict<int,IdString> &box_lookup)
+{
+	LogTraceSpan trace_span("abc9 re-integrate", job.module);
+	std::string tempdir_name = job.tempdir_name;
+
+	if (job.abc_pipe != nullptr) {
+		abc9_poll_jobs({&job}, &job);
+		int ret = pclose(job.abc_pipe);
+		job.abc_pipe = nullptr;
+#ifdef _WIN32
+		job.abc_ret = ret;
 #else
-		// These needs to be mutable, supposedly due to getopt
-		char *abc_argv[5];
-		string tmp_script_name = stringf("%s/abc.script", tempdir_name.c_str());
-		abc_argv[0] = strdup(exe_file.c_str());
-		abc_argv[1] = strdup("-s");
-		abc_argv[2] = strdup("-f");
-		abc_argv[3] = strdup(tmp_script_name.c_str());
-		abc_argv[4] = 0;
-		int ret = Abc_RealMain(4, abc_argv);
-		free(abc_argv[0]);
-		free(abc_argv[1]);
-		free(abc_argv[2]);
-		free(abc_argv[3]);
+		job.abc_ret = ret < 0 ? -1 : WEXITSTATUS(ret);
 #endif
-		if (ret != 0)
-			log_error("ABC: execution of command \"%s\" failed: return code %d.\n", buffer.c_str(), ret);
+		abc_output_filter filt(tempdir_name, show_tempdir);
+		for (size_t pos = 0; pos < job.abc_output.size();) {
+			size_t end = job.abc_output.find('\n', pos);
+			end = end == std::string::npos ? job.abc_output.size() : end + 1;
+			filt.next_line(job.abc_output.substr(pos, end - pos));
+			pos = end;
+		}
+		job.abc_output.clear();
+	}
+
+	reintegrate_timer.begin();
+
+	module = job.module;
+	map_autoidx = job.map_autoidx;
+
+	log_push();
+
+	if (job.count_output)
+	{
+		std::string buffer;
+		std::ifstream ifs;
+
+		if (job.abc_ret != 0) {
+			abc9_cleanup_jobs();
+			log_error("ABC: execution of command \"%s\" failed: return code %d.\n", job.command.c_str(), job.abc_ret);
+		}
 
 		buffer = stringf("%s/%s", tempdir_name.c_str(), "output.aig");
 		ifs.open(buffer);
-		if (ifs.fail())
+		if (ifs.fail()) {
+			abc9_cleanup_jobs();
 			log_error("Can't open ABC output file `%s'.\n", buffer.c_str());
+		}
 
 		buffer = stringf("%s/%s", tempdir_name.c_str(), "input.sym");
 		log_assert(!design->module(ID($__abc9__)));
@@ -526,10 +715,12 @@ void abc9_module(RTLIL::Design *design, RTLIL::Module *current_module, std::stri
 		Pass::call(design, stringf("write_verilog -noexpr -norename"));
 #endif
 
-		log_header(design, "Re-integrating ABC9 results.\n");
+		log_header(design, "Re-integrating ABC9 results for module `%s'.\n", log_id(module));
 		RTLIL::Module *mapped_mod = design->module(ID($__abc9__));
-		if (mapped_mod == NULL)
+		if (mapped_mod == NULL) {
+			abc9_cleanup_jobs();
 			log_error("ABC output file does not contain a module `$__abc9__'.\n");
+		}
 
 		pool<RTLIL::SigBit> output_bits;
 		for (auto &it : mapped_mod->wires_) {
@@ -555,10 +746,11 @@ void abc9_module(RTLIL::Design *design, RTLIL::Module *current_module, std::stri
 
 		dict<IdString, bool> abc_box;
 		vector<RTLIL::Cell*> boxes;
+		pool<RTLIL::Cell*> removed_cells;
 		for (const auto &it : module->cells_) {
 			auto cell = it.second;
 			if (cell->type.in(ID($_AND_), ID($_NOT_))) {
-				module->remove(cell);
+				removed_cells.insert(cell);
 				continue;
 			}
 			auto jt = abc_box.find(cell->type);
@@ -683,7 +875,8 @@ void abc9_module(RTLIL::Design *design, RTLIL::Module *current_module, std::stri
 		}
 
 		for (auto cell : boxes)
-			module->remove(cell);
+			removed_cells.insert(cell);
+		module->remove(removed_cells);
 
 		// Copy connections (and rename) from mapped_mod to module
 		for (auto conn : mapped_mod->connections()) {
@@ -813,10 +1006,6 @@ clone_lut:
 
 		design->remove(mapped_mod);
 	}
-	else
-	{
-		log("Don't call ABC as there is nothing to map.\n");
-	}
 
 	if (cleanup)
 	{
@@ -825,6 +1014,20 @@ clone_lut:
 	}
 
 	log_pop();
+
+	reintegrate_timer.end();
+}
+
+void abc9_module(RTLIL::Design *design, RTLIL::Module *current_module, std::string script_file, std::string exe_file,
+		bool cleanup, vector<int> lut_costs, bool dff_mode, std::string clk_str,
+		bool keepff, std::string delay_target, std::string lutin_shared, bool fast_mode,
+		bool show_tempdir, std::string box_file, std::string lut_file,
+		std::string wire_delay, const dict<int,IdString> &box_lookup)
+{
+	Abc9Job job = abc9_module_extract(design, current_module, script_file, exe_file, cleanup, lut_costs, dff_mode, clk_str,
+			keepff, delay_target, lutin_shared, fast_mode, show_tempdir, box_file, lut_file, wire_delay);
+	abc9_module_start(job, exe_file);
+	abc9_module_finish(design, job, cleanup, lut_costs, show_tempdir, lut_file, box_lookup);
 }
 
 struct Abc9Pass : public Pass {
@@ -925,6 +1128,11 @@ struct Abc9Pass : public Pass {
 		log("    -box <file>\n");
 		log("        pass this file with box library to ABC. Use with -lut.\n");
 		log("\n");
+		log("    -j <N>\n");
+		log("        run up to N ABC processes for independent modules concurrently. The\n");
+		log("        modules are still extracted and re-integrated one at a time, so the\n");
+		log("        result does not depend on this option. (default: 1)\n");
+		log("\n");
 		log("Note that this is a logic optimization pass within Yosys that is calling ABC\n");
 		log("internally. This is not going to \"run ABC on your design\". It will instead run\n");
 		log("ABC on logic snippets extracted from your design. You will not get any useful\n");
@@ -952,6 +1160,7 @@ struct Abc9Pass : public Pass {
 		bool fast_mode = false, dff_mode = false, keepff = false, cleanup = true;
 		bool show_tempdir = false;
 		vector<int> lut_costs;
+		int max_jobs = 1;
 		markgroups = false;
 
 #if 0
@@ -1072,6 +1281,10 @@ struct Abc9Pass : public Pass {
 					box_file = std::string(pwd) + "/" + box_file;
 				continue;
 			}
+			if (arg == "-j" && argidx+1 < args.size()) {
+				max_jobs = std::max(atoi(args[++argidx].c_str()), 1);
+				continue;
+			}
 			if (arg == "-W" && argidx+1 < args.size()) {
 				wire_delay = "-W " + args[++argidx];
 				continue;
@@ -1095,6 +1308,24 @@ struct Abc9Pass : public Pass {
 			log_assert(r.second);
 		}
 
+		extract_timer = PerformanceTimer();
+		reintegrate_timer = PerformanceTimer();
+		abc_wait_ns = 0;
+		int module_count = 0;
+
+		log_assert(running_jobs.empty());
+		auto poll_running_jobs = [&](Abc9Job *wait_job) {
+			std::vector<Abc9Job*> jobs;
+			for (auto &job : running_jobs)
+				jobs.push_back(&job);
+			abc9_poll_jobs(jobs, wait_job);
+		};
+		auto finish_oldest_job = [&]() {
+			poll_running_jobs(&running_jobs.front());
+			abc9_module_finish(design, running_jobs.front(), cleanup, lut_costs, show_tempdir, lut_file, box_lookup);
+			running_jobs.pop_front();
+		};
+
 		for (auto mod : design->selected_modules())
 		{
 			if (mod->attributes.count(ID(abc_box_id)))
@@ -1106,14 +1337,23 @@ struct Abc9Pass : public Pass {
 			}
 
 			assign_map.set(mod);
+			module_count++;
 
 			if (!dff_mode || !clk_str.empty()) {
-				abc9_module(design, mod, script_file, exe_file, cleanup, lut_costs, dff_mode, clk_str, keepff,
-						delay_target, lutin_shared, fast_mode, show_tempdir,
-						box_file, lut_file, wire_delay, box_lookup);
+				while (GetSize(running_jobs) >= max_jobs)
+					finish_oldest_job();
+				running_jobs.push_back(abc9_module_extract(design, mod, script_file, exe_file, cleanup, lut_costs, dff_mode, clk_str,
+						keepff, delay_target, lutin_shared, fast_mode, show_tempdir, box_file, lut_file, wire_delay));
+				abc9_module_start(running_jobs.back(), exe_file);
+				poll_running_jobs(nullptr);
 				continue;
 			}
 
+			// Clock domains of one module are mapped back to back, as each
+			// re-integration changes the netlist the next one is cut from.
+			while (!running_jobs.empty())
+				finish_oldest_job();
+
 			CellTypes ct(design);
 
 			std::vector<RTLIL::Cell*> all_cells = mod->selected_cells();
@@ -1261,8 +1501,15 @@ struct Abc9Pass : public Pass {
 			}
 		}
 
+		while (!running_jobs.empty())
+			finish_oldest_job();
+
 		assign_map.clear();
 
+		log("Mapped %d modules (up to %d concurrent ABC runs).\n", module_count, max_jobs);
+		log_debug("Spent %.3f seconds extracting, %.3f seconds waiting for ABC and %.3f seconds re-integrating.\n",
+				extract_timer.sec(), abc_wait_ns * 1e-9, reintegrate_timer.sec());
+
 		// The "clean" pass also contains a design->check() call
 		Pass::call(design, "clean");
 
@@ -0,0 +1,307 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+// In-process interface to a linked-in ABC (LINK_ABC=1). Instead of writing the
+// network to input.blif and running yosys-abc, the network is constructed
+// directly as an ABC logic network and handed to the global ABC frame. The
+// mapped network is read back from the ABC frame in the same way.
+
+#include "kernel/yosys.h"
+#include "passes/techmap/abc_link.h"
+
+#include <cerrno>
+
+#ifndef _WIN32
+#  include <unistd.h>
+#else
+#  include <io.h>
+#endif
+
+#ifdef YOSYS_LINK_ABC
+
+#include "base/abc/abc.h"
+#include "base/main/main.h"
+#include "base/cmd/cmd.h"
+#include "map/mio/mio.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+static Abc_Frame_t *abc_link_frame()
+{
+	static bool started = false;
+	if (!started) {
+		Abc_Start();
+		started = true;
+	}
+	return Abc_FrameGetGlobalFrame();
+}
+
+static void abc_link_name(Abc_Obj_t *obj, int id, const char *suffix = nullptr)
+{
+	std::string name = stringf("ys__n%d", id);
+	Abc_ObjAssignName(obj, (char*)name.c_str(), (char*)suffix);
+}
+
+static Abc_Ntk_t *abc_link_build(const AbcLinkNetwork &network)
+{
+	Abc_Ntk_t *ntk = Abc_NtkAlloc(ABC_NTK_LOGIC, ABC_FUNC_SOP, 1);
+	ntk->pName = Abc_UtilStrsav((char*)"netlist");
+
+	dict<int, Abc_Obj_t*> drivers, latch_inputs;
+
+	for (int id : network.inputs) {
+		Abc_Obj_t *obj = Abc_NtkCreatePi(ntk);
+		abc_link_name(obj, id);
+		drivers[id] = obj;
+	}
+
+	if (network.inputs.empty())
+		Abc_ObjAssignName(Abc_NtkCreatePi(ntk), (char*)"dummy_input", nullptr);
+
+	for (auto &latch : network.latches) {
+		Abc_Obj_t *obj = Abc_NtkCreateLatch(ntk);
+		Abc_Obj_t *obj_in = Abc_NtkCreateBi(ntk);
+		Abc_Obj_t *obj_out = Abc_NtkCreateBo(ntk);
+		Abc_ObjAddFanin(obj, obj_in);
+		Abc_ObjAddFanin(obj_out, obj);
+		abc_link_name(obj_in, latch.q, "_in");
+		abc_link_name(obj_out, latch.q);
+		if (latch.init == 0)
+			Abc_LatchSetInit0(obj);
+		else if (latch.init == 1)
+			Abc_LatchSetInit1(obj);
+		else
+			Abc_LatchSetInitDc(obj);
+		drivers[latch.q] = obj_out;
+		latch_inputs[latch.q] = obj_in;
+	}
+
+	// create all nodes first, so that fanins can be connected in any order
+	for (auto &node : network.nodes)
+		drivers[node.id] = Abc_NtkCreateNode(ntk);
+
+	// Signals without a driver (e.g. undriven wires that are not ports) get a
+	// constant 0 driver, like ABC does for non-driven nets when reading BLIF.
+	auto driver = [&](int id) -> Abc_Obj_t* {
+		auto it = drivers.find(id);
+		if (it != drivers.end())
+			return it->second;
+		Abc_Obj_t *obj = Abc_NtkCreateNode(ntk);
+		obj->pData = Abc_SopRegister((Mem_Flex_t*)ntk->pManFunc, (char*)" 0\n");
+		drivers[id] = obj;
+		return obj;
+	};
+
+	for (auto &node : network.nodes) {
+		Abc_Obj_t *obj = drivers.at(node.id);
+		for (int id : node.inputs)
+			Abc_ObjAddFanin(obj, driver(id));
+		obj->pData = Abc_SopRegister((Mem_Flex_t*)ntk->pManFunc, (char*)node.cover.c_str());
+	}
+
+	for (auto &latch : network.latches)
+		Abc_ObjAddFanin(latch_inputs.at(latch.q), driver(latch.d));
+
+	for (int id : network.outputs) {
+		Abc_Obj_t *obj = Abc_NtkCreatePo(ntk);
+		Abc_ObjAddFanin(obj, driver(id));
+		abc_link_name(obj, id);
+	}
+
+	if (!Abc_NtkCheck(ntk))
+		log_error("ABC: network check failed for in-memory netlist.\n");
+
+	return ntk;
+}
+
+// Create the mapped network as module 'netlist', with the same wires and cells
+// that parse_blif() creates when it reads the network from a BLIF file.
+static void abc_link_extract(Abc_Ntk_t *ntk, RTLIL::Design *design, IdString dff_name, bool sop_mode)
+{
+	if (!Abc_NtkHasSop(ntk) && !Abc_NtkHasMapping(ntk))
+		Abc_NtkToSop(ntk, -1, ABC_INFINITY);
+
+	Abc_Ntk_t *netlist = Abc_NtkToNetlist(ntk);
+	if (netlist == nullptr)
+		log_error("ABC: converting the mapped network to a netlist failed.\n");
+
+	RTLIL::Module *module = design->addModule(ID(netlist));
+
+	auto net_wire = [&](Abc_Obj_t *net) -> RTLIL::Wire* {
+		IdString name = RTLIL::escape_id(Abc_ObjName(net));
+		RTLIL::Wire *wire = module->wire(name);
+		if (wire == nullptr)
+			wire = module->addWire(name);
+		return wire;
+	};
+
+	Abc_Obj_t *obj, *fanin;
+	int i, k;
+
+	Abc_NtkForEachPi(netlist, obj, i)
+		net_wire(Abc_ObjFanout0(obj))->port_input = true;
+
+	Abc_NtkForEachPo(netlist, obj, i)
+		net_wire(Abc_ObjFanin0(obj))->port_output = true;
+
+	Abc_NtkForEachLatch(netlist, obj, i) {
+		RTLIL::Wire *d = net_wire(Abc_ObjFanin0(Abc_ObjFanin0(obj)));
+		RTLIL::Wire *q = net_wire(Abc_ObjFanout0(Abc_ObjFanout0(obj)));
+		if (Abc_LatchIsInit0(obj) || Abc_LatchIsInit1(obj))
+			q->attributes[ID(init)] = RTLIL::Const(Abc_LatchIsInit1(obj) ? 1 : 0, 1);
+		RTLIL::Cell *cell = module->addCell(NEW_ID, dff_name);
+		cell->setPort(ID(D), d);
+		cell->setPort(ID(Q), q);
+	}
+
+	Abc_NtkForEachNode(netlist, obj, i)
+	{
+		RTLIL::Wire *y = net_wire(Abc_ObjFanout0(obj));
+
+		if (Abc_NtkHasMapping(netlist)) {
+			Mio_Gate_t *gate = (Mio_Gate_t*)obj->pData;
+			RTLIL::Cell *cell = module->addCell(NEW_ID, RTLIL::escape_id(Mio_GateReadName(gate)));
+			k = 0;
+			for (Mio_Pin_t *pin = Mio_GateReadPins(gate); pin != nullptr; pin = Mio_PinReadNext(pin))
+				cell->setPort(RTLIL::escape_id(Mio_PinReadName(pin)), net_wire(Abc_ObjFanin(obj, k++)));
+			cell->setPort(RTLIL::escape_id(Mio_GateReadOutName(gate)), y);
+			continue;
+		}
+
+		RTLIL::SigSpec sig_a;
+		Abc_ObjForEachFanin(obj, fanin, k)
+			sig_a.append(net_wire(fanin));
+
+		// each cube is the input pattern, a blank, the output value and a newline
+		char *sop = (char*)obj->pData, *cube;
+		int width = GetSize(sig_a);
+
+		if (width == 0) {
+			module->connect(y, *sop && sop[1] == '1' ? RTLIL::State::S1 : RTLIL::State::S0);
+			continue;
+		}
+
+		if (sop_mode)
+		{
+			RTLIL::Cell *cell = module->addCell(NEW_ID, ID($sop));
+			RTLIL::Const table;
+			int depth = 0;
+			Abc_SopForEachCube(sop, width, cube) {
+				for (int j = 0; j < width; j++) {
+					table.bits.push_back(cube[j] == '0' ? RTLIL::State::S1 : RTLIL::State::S0);
+					table.bits.push_back(cube[j] == '1' ? RTLIL::State::S1 : RTLIL::State::S0);
+				}
+				depth++;
+			}
+			cell->parameters[ID(WIDTH)] = RTLIL::Const(width);
+			cell->parameters[ID(DEPTH)] = depth;
+			cell->parameters[ID(TABLE)] = table;
+			cell->setPort(ID::A, sig_a);
+			if (sop[width+1] == '0') {
+				RTLIL::Wire *tempnet = module->addWire(NEW_ID);
+				module->addNotGate(NEW_ID, tempnet, y);
+				cell->setPort(ID::Y, tempnet);
+			} else
+				cell->setPort(ID::Y, y);
+		}
+		else
+		{
+			RTLIL::Const lut(RTLIL::State::Sx, 1 << width);
+			RTLIL::State default_state = RTLIL::State::Sx;
+			Abc_SopForEachCube(sop, width, cube) {
+				RTLIL::State value = cube[width+1] == '0' ? RTLIL::State::S0 : RTLIL::State::S1;
+				for (int j = 0; j < (1 << width); j++) {
+					for (int l = 0; l < width; l++)
+						if (cube[l] != '-' && (cube[l] == '1') != ((j & (1 << l)) != 0))
+							goto next_value;
+					lut.bits[j] = value;
+				next_value:;
+				}
+				default_state = value == RTLIL::State::S0 ? RTLIL::State::S1 : RTLIL::State::S0;
+			}
+			for (auto &bit : lut.bits)
+				if (bit == RTLIL::State::Sx)
+					bit = default_state;
+			RTLIL::Cell *cell = module->addCell(NEW_ID, ID($lut));
+			cell->parameters[ID(WIDTH)] = RTLIL::Const(width);
+			cell->parameters[ID(LUT)] = lut;
+			cell->setPort(ID::A, sig_a);
+			cell->setPort(ID::Y, y);
+		}
+	}
+
+	module->fixup_ports();
+	Abc_NtkDelete(netlist);
+}
+
+void abc_link_run(const AbcLinkNetwork &network, const std::string &commands, RTLIL::Design *design,
+		IdString dff_name, bool sop_mode, std::function<void(const std::string&)> process_line)
+{
+	Abc_Frame_t *frame = abc_link_frame();
+	Abc_FrameReplaceCurrentNetwork(frame, abc_link_build(network));
+
+	// ABC prints to stdout and stderr. Both go to a temporary file while the
+	// commands run, so that the output can be filtered like the output of an
+	// external ABC process.
+	FILE *output = tmpfile();
+	if (output == nullptr)
+		log_error("ABC: creating a temporary file for the output of ABC failed: %s\n", strerror(errno));
+
+	fflush(stdout);
+	fflush(stderr);
+	int saved_stdout = dup(fileno(stdout));
+	int saved_stderr = dup(fileno(stderr));
+	dup2(fileno(output), fileno(stdout));
+	dup2(fileno(output), fileno(stderr));
+
+	int ret = Cmd_CommandExecute(frame, commands.c_str());
+
+	fflush(stdout);
+	fflush(stderr);
+	dup2(saved_stdout, fileno(stdout));
+	dup2(saved_stderr, fileno(stderr));
+	close(saved_stdout);
+	close(saved_stderr);
+
+	rewind(output);
+	std::string line;
+	char logbuf[128];
+	while (fgets(logbuf, 128, output) != NULL) {
+		line += logbuf;
+		if (!line.empty() && line.back() == '\n')
+			process_line(line), line.clear();
+	}
+	if (!line.empty())
+		process_line(line);
+	fclose(output);
+
+	if (ret != 0)
+		log_error("ABC: execution of in-process commands failed: return code %d.\n", ret);
+
+	Abc_Ntk_t *ntk = Abc_FrameReadNtk(frame);
+	if (ntk == nullptr)
+		log_error("ABC: no network after executing the in-process commands.\n");
+
+	abc_link_extract(ntk, design, dff_name, sop_mode);
+	Abc_FrameDeleteAllNetworks(frame);
+}
+
+YOSYS_NAMESPACE_END
+
+#endif
@@ -0,0 +1,59 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#ifndef ABC_LINK_H
+#define ABC_LINK_H
+
+#include "kernel/yosys.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+// A gate-level network in the form 'abc' would write it to input.blif. Signals
+// are identified by integer ids and named ys__n<id> inside ABC. Node functions
+// are given as SOP covers in BLIF notation (e.g. "11 1\n", or " 1\n" for const 1).
+struct AbcLinkNetwork
+{
+	struct node_t {
+		int id;
+		std::vector<int> inputs;
+		std::string cover;
+	};
+
+	struct latch_t {
+		int d, q;
+		int init; // 0, 1 or 2 (don't care)
+	};
+
+	std::vector<int> inputs, outputs;
+	std::vector<node_t> nodes;
+	std::vector<latch_t> latches;
+};
+
+#ifdef YOSYS_LINK_ABC
+// Pass the network directly to the linked-in ABC and run the given ABC commands
+// on it. The output of ABC is passed to 'process_line' line by line. The
+// resulting network is added to 'design' as module 'netlist', with the same
+// cells and wires that parse_blif() creates for the BLIF file written by ABC.
+extern void abc_link_run(const AbcLinkNetwork &network, const std::string &commands, RTLIL::Design *design,
+		IdString dff_name, bool sop_mode, std::function<void(const std::string&)> process_line);
+#endif
+
+YOSYS_NAMESPACE_END
+
+#endif
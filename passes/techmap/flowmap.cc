@@ -1394,7 +1394,7 @@ struct FlowmapWorker
 				{
 					string env;
 					for (auto input_node : input_nodes)
-						env += stringf("  %s = %s\n", log_signal(input_node), log_signal(ce.values_map(input_node)));
+						env += stringf("  %s = %s\n", log_signal(input_node), log_signal(ce.values(ce.assign_map(input_node))));
 					log_error("Cannot evaluate %s because %s is not defined.\nEvaluation environment:\n%s",
 					          log_signal(node), log_signal(undef), env.c_str());
 				}
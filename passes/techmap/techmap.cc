@@ -378,8 +378,6 @@ struct TechmapWorker
 			port_signal_map.apply(c.second);
 			module->connect(c);
 		}
-
-		module->remove(cell);
 	}
 
 	bool techmap_module(RTLIL::Design *design, RTLIL::Module *module, RTLIL::Design *map, std::set<RTLIL::Cell*> &handled_cells,
@@ -460,6 +458,9 @@ struct TechmapWorker
 
 		cells.sort();
 
+		// mapped cells are removed together after the loop
+		pool<RTLIL::Cell*> removed_cells;
+
 		for (auto cell : cells.sorted)
 		{
 			log_assert(handled_cells.count(cell) == 0);
@@ -592,7 +593,7 @@ struct TechmapWorker
 								maccmap(module, cell);
 							}
 
-							module->remove(cell);
+							removed_cells.insert(cell);
 							cell = NULL;
 						}
 
@@ -894,6 +895,7 @@ struct TechmapWorker
 					}
 					log_debug("%s %s.%s (%s) using %s.\n", mapmsg_prefix.c_str(), log_id(module), log_id(cell), log_id(cell->type), log_id(tpl));
 					techmap_module_worker(design, module, cell, tpl);
+					removed_cells.insert(cell);
 					cell = NULL;
 				}
 				did_something = true;
@@ -907,6 +909,8 @@ struct TechmapWorker
 			handled_cells.insert(cell);
 		}
 
+		module->remove(removed_cells);
+
 		if (log_continue) {
 			log_header(design, "Continuing TECHMAP pass.\n");
 			log_continue = false;
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include "kernel/yosys.h"
+#include "kernel/consteval.h"
+#include "fixtures.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+typedef YosysFixture KernelConstEvalTest;
+
+TEST_F(KernelConstEvalTest, pushPop)
+{
+	RTLIL::Design design;
+	RTLIL::Module *module = design.addModule("\\top");
+	RTLIL::Wire *a = module->addWire("\\a", 4);
+	RTLIL::Wire *b = module->addWire("\\b", 4);
+	RTLIL::Wire *y = module->addWire("\\y", 4);
+	RTLIL::Wire *z = module->addWire("\\z", 4);
+	module->addAnd(NEW_ID, a, b, y);
+	module->addXor(NEW_ID, y, a, z);
+
+	ConstEval ce(module);
+	ce.set(a, RTLIL::Const(12, 4));
+
+	RTLIL::SigSpec sig = z, undef;
+	EXPECT_FALSE(ce.eval(sig, undef));
+	EXPECT_EQ(undef, RTLIL::SigSpec(b));
+
+	ce.push();
+	ce.set(b, RTLIL::Const(10, 4));
+	sig = z;
+	EXPECT_TRUE(ce.eval(sig));
+	EXPECT_EQ(sig, RTLIL::SigSpec(RTLIL::Const(4, 4)));
+	EXPECT_EQ(ce.values(y), RTLIL::SigSpec(RTLIL::Const(8, 4)));
+
+	ce.push();
+	ce.stop(b);
+	ce.pop();
+	ce.pop();
+
+	// only the values set after push() are gone, stop signals stay
+	EXPECT_EQ(ce.values(a), RTLIL::SigSpec(RTLIL::Const(12, 4)));
+	EXPECT_EQ(ce.values(y), RTLIL::SigSpec(y));
+	EXPECT_TRUE(ce.all_stopped(b));
+
+	ce.clear();
+	EXPECT_EQ(ce.values(a), RTLIL::SigSpec(a));
+	EXPECT_FALSE(ce.all_stopped(b));
+}
+
+TEST_F(KernelConstEvalTest, compatViews)
+{
+	RTLIL::Design design;
+	RTLIL::Module *module = design.addModule("\\top");
+	RTLIL::Wire *a = module->addWire("\\a", 4);
+	RTLIL::Wire *b = module->addWire("\\b", 4);
+	RTLIL::Wire *y = module->addWire("\\y", 4);
+	module->addAnd(NEW_ID, a, b, y);
+
+	ConstEval ce(module);
+	ce.values_map.add(a, RTLIL::Const(12, 4));
+	ce.stop_signals.add(b);
+
+	RTLIL::SigSpec sig = y, undef;
+	EXPECT_FALSE(ce.eval(sig, undef));
+	EXPECT_EQ(undef, RTLIL::SigSpec(b));
+	EXPECT_TRUE(ce.stop_signals.check_all(b));
+	EXPECT_FALSE(ce.stop_signals.check_any(a));
+	EXPECT_EQ(ce.stop_signals.extract(RTLIL::SigSpec({a, b})), RTLIL::SigSpec(b));
+
+	// a copy has its own state, and its views refer to it
+	ConstEval ce2 = ce;
+	ce2.clear();
+	ce2.set(b, RTLIL::Const(10, 4));
+	EXPECT_EQ(ce2.values_map(b), RTLIL::SigSpec(RTLIL::Const(10, 4)));
+	EXPECT_EQ(ce2.values_map(a), RTLIL::SigSpec(a));
+	EXPECT_FALSE(ce2.stop_signals.check_any(b));
+
+	sig = a;
+	ce.values_map.apply(sig);
+	EXPECT_EQ(sig, RTLIL::SigSpec(RTLIL::Const(12, 4)));
+	EXPECT_EQ(ce.values_map(b), RTLIL::SigSpec(b));
+	EXPECT_TRUE(ce.stop_signals.check_all(b));
+}
+
+YOSYS_NAMESPACE_END
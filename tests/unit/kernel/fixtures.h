@@ -0,0 +1,34 @@
+#ifndef UNIT_TEST_FIXTURES_H
+#define UNIT_TEST_FIXTURES_H
+
+#include <gtest/gtest.h>
+
+#include "kernel/yosys.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+// Calls yosys_setup() once per test suite: ID::A, ID::Y etc. are only
+// initialized there, and cells created with addAnd() etc. need them.
+struct YosysFixture : public ::testing::Test
+{
+	static void SetUpTestCase()
+	{
+		yosys_setup();
+	}
+};
+
+// A fresh design with an empty module \top for each test.
+struct ModuleFixture : public YosysFixture
+{
+	RTLIL::Design design;
+	RTLIL::Module *module;
+
+	void SetUp() override
+	{
+		module = design.addModule("\\top");
+	}
+};
+
+YOSYS_NAMESPACE_END
+
+#endif
@@ -0,0 +1,257 @@
+#include <gtest/gtest.h>
+
+#include "kernel/yosys.h"
+#include "kernel/rtlil.h"
+#include "fixtures.h"
+
+#include <chrono>
+
+YOSYS_NAMESPACE_BEGIN
+
+namespace {
+
+// same hash functions as the default, but with the open addressing layout
+template<typename K> struct OpenOps : hash_ops<K> { };
+
+// same hash functions as the default, with and without a hashtable for small dicts
+template<typename K> struct ChainedOps : hash_ops<K> { };
+template<typename K> struct SmallOps : hash_ops<K> { };
+template<typename K> struct OpenSmallOps : hash_ops<K> { };
+
+}
+
+namespace hashlib {
+	template<typename K> struct hash_layout<OpenOps<K>> {
+		static const bool open_addressing = true;
+		static const int small_size = 0;
+	};
+	template<typename K> struct hash_layout<ChainedOps<K>> {
+		static const bool open_addressing = false;
+		static const int small_size = 0;
+	};
+	template<typename K> struct hash_layout<SmallOps<K>> {
+		static const bool open_addressing = false;
+		static const int small_size = 8;
+	};
+	template<typename K> struct hash_layout<OpenSmallOps<K>> {
+		static const bool open_addressing = true;
+		static const int small_size = 8;
+	};
+}
+
+namespace {
+
+struct HashlibFixture : public ModuleFixture
+{
+	std::vector<RTLIL::IdString> ids;
+	std::vector<RTLIL::SigBit> bits;
+	std::vector<RTLIL::Cell*> cells;
+
+	void SetUp() override
+	{
+		ModuleFixture::SetUp();
+		for (int i = 0; i < 2000; i++) {
+			RTLIL::Wire *wire = module->addWire(stringf("\\w%d", i), 16);
+			for (int j = 0; j < 16; j++)
+				bits.push_back(RTLIL::SigBit(wire, j));
+			ids.push_back(wire->name);
+			cells.push_back(module->addCell(stringf("\\c%d", i), "$and"));
+		}
+	}
+
+	// fraction of keys that share their bucket with an earlier key, for a
+	// hashtable at the size dict<> would use after reserve(keys.size())
+	template<typename K, typename OPS = hash_ops<K>>
+	double collision_rate(const std::vector<K> &keys)
+	{
+		int size = hashlib::hashtable_size(GetSize(keys) * hashlib::hashtable_size_factor);
+		std::vector<bool> used(size);
+		int collisions = 0;
+		for (auto &k : keys) {
+			int bucket = OPS::hash(k) % (unsigned int)size;
+			collisions += used[bucket];
+			used[bucket] = true;
+		}
+		return double(collisions) / GetSize(keys);
+	}
+
+	// insert all keys, look up all keys, erase every other key, look up again
+	template<typename K, typename OPS>
+	double bench(const std::vector<K> &keys)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (int round = 0; round < 10; round++)
+		{
+			dict<K, int, OPS> d;
+			for (int i = 0; i < GetSize(keys); i++)
+				d[keys[i]] = i;
+
+			int found = 0;
+			for (auto &k : keys)
+				found += d.count(k);
+			EXPECT_EQ(found, GetSize(keys));
+
+			for (int i = 0; i < GetSize(keys); i += 2)
+				d.erase(keys[i]);
+
+			found = 0;
+			for (auto &k : keys)
+				found += d.count(k);
+			EXPECT_EQ(found, GetSize(keys) / 2);
+		}
+		auto stop = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::milli>(stop - start).count();
+	}
+
+	template<typename K>
+	void compare(const char *name, const std::vector<K> &keys)
+	{
+		double chained = bench<K, ChainedOps<K>>(keys);
+		double open = bench<K, OpenOps<K>>(keys);
+		printf("[ BENCH    ] %-8s %6d keys: chained %8.2f ms, open addressing %8.2f ms\n",
+				name, GetSize(keys), chained, open);
+	}
+};
+
+}
+
+TEST_F(HashlibFixture, sameBehaviour)
+{
+	dict<RTLIL::SigBit, int> chained;
+	dict<RTLIL::SigBit, int, OpenOps<RTLIL::SigBit>> open;
+
+	for (int i = 0; i < GetSize(bits); i++) {
+		chained[bits[(i * 7919) % GetSize(bits)]] = i;
+		open[bits[(i * 7919) % GetSize(bits)]] = i;
+	}
+	for (int i = 0; i < GetSize(bits); i += 3) {
+		EXPECT_EQ(chained.erase(bits[i]), open.erase(bits[i]));
+	}
+
+	ASSERT_EQ(chained.size(), open.size());
+	auto it = open.begin();
+	for (auto &c : chained) {
+		EXPECT_EQ(c.first, it->first);
+		EXPECT_EQ(c.second, it->second);
+		++it;
+	}
+
+	pool<RTLIL::Cell*, OpenOps<RTLIL::Cell*>> cell_pool(cells.begin(), cells.end());
+	idict<RTLIL::IdString, 0, OpenOps<RTLIL::IdString>> id_index;
+	for (auto id : ids)
+		id_index(id);
+	for (int i = 0; i < GetSize(ids); i++) {
+		EXPECT_TRUE(cell_pool.count(cells[i]));
+		EXPECT_EQ(id_index.at(ids[i]), i);
+	}
+}
+
+TEST_F(HashlibFixture, smallDicts)
+{
+	// grow and shrink across the small size, compare with the default layout
+	dict<RTLIL::IdString, int, ChainedOps<RTLIL::IdString>> chained;
+	dict<RTLIL::IdString, int, SmallOps<RTLIL::IdString>> small;
+
+	for (int i = 0; i < 40; i++) {
+		int k = (i * 7) % 13;
+		if (i % 3 == 2) {
+			EXPECT_EQ(chained.erase(ids[k]), small.erase(ids[k]));
+		} else {
+			chained[ids[k]] = i;
+			small[ids[k]] = i;
+		}
+
+		ASSERT_EQ(chained.size(), small.size());
+		auto it = small.begin();
+		for (auto &c : chained) {
+			EXPECT_EQ(c.first, it->first);
+			EXPECT_EQ(c.second, it->second);
+			++it;
+		}
+		for (int k = 0; k < 13; k++)
+			EXPECT_EQ(chained.count(ids[k]), small.count(ids[k]));
+	}
+
+	dict<RTLIL::IdString, int, SmallOps<RTLIL::IdString>> copy = small;
+	copy.sort(RTLIL::sort_by_id_str());
+	EXPECT_TRUE(copy == small);
+}
+
+TEST_F(HashlibFixture, openSmallDicts)
+{
+	// without a hashtable, lookups compare the cached hashes of the open
+	// addressing layout; grow past the small size, shrink back below it and
+	// drop the hashtable with a rehash (sort), compare with the default layout
+	dict<RTLIL::SigBit, int, ChainedOps<RTLIL::SigBit>> chained;
+	dict<RTLIL::SigBit, int, OpenSmallOps<RTLIL::SigBit>> open_small;
+
+	auto check = [&]() {
+		ASSERT_EQ(chained.size(), open_small.size());
+		auto it = open_small.begin();
+		for (auto &c : chained) {
+			EXPECT_EQ(c.first, it->first);
+			EXPECT_EQ(c.second, it->second);
+			++it;
+		}
+		for (int k = 0; k < 64; k++)
+			EXPECT_EQ(chained.count(bits[k]), open_small.count(bits[k]));
+	};
+
+	for (int i = 0; i < 6; i++) {
+		chained[bits[i]] = i;
+		open_small[bits[i]] = i;
+		check();
+	}
+
+	for (int i = 6; i < 48; i++) {
+		chained[bits[(i * 5) % 64]] = i;
+		open_small[bits[(i * 5) % 64]] = i;
+	}
+	check();
+
+	for (int i = 0; i < 64; i++) {
+		if (i % 9 != 0) {
+			EXPECT_EQ(chained.erase(bits[i]), open_small.erase(bits[i]));
+		}
+	}
+	check();
+
+	chained.sort();
+	open_small.sort();
+	check();
+
+	for (int i = 0; i < 12; i++) {
+		chained[bits[i]] = -i;
+		open_small[bits[i]] = -i;
+		check();
+	}
+}
+
+TEST_F(HashlibFixture, collisionRate)
+{
+	// uniform hashing at a load factor of 1/3 gives about 15%
+	std::vector<std::pair<RTLIL::IdString, int>> id_offsets;
+	std::vector<std::pair<RTLIL::Cell*, RTLIL::SigBit>> cell_bits;
+	for (int i = 0; i < GetSize(bits); i++) {
+		id_offsets.push_back(std::make_pair(bits[i].wire->name, bits[i].offset));
+		cell_bits.push_back(std::make_pair(cells[i % GetSize(cells)], bits[i]));
+	}
+
+	EXPECT_LT(collision_rate(bits), 0.25);
+	EXPECT_LT(collision_rate(ids), 0.25);
+	EXPECT_LT(collision_rate(cells), 0.25);
+	EXPECT_LT((collision_rate<RTLIL::Cell*, hash_ptr_ops>(cells)), 0.25);
+	EXPECT_LT(collision_rate(id_offsets), 0.25);
+	EXPECT_LT(collision_rate(cell_bits), 0.25);
+}
+
+// Timings vary from run to run, so this is not part of the normal unit test
+// run. Run it with --gtest_also_run_disabled_tests --gtest_filter='*benchmark'.
+TEST_F(HashlibFixture, DISABLED_benchmark)
+{
+	compare("IdString", ids);
+	compare("SigBit", bits);
+	compare("Cell*", cells);
+}
+
+YOSYS_NAMESPACE_END
@@ -11,4 +11,22 @@ TEST(KernelLogTest, logvValidValues)
 	EXPECT_EQ(7, 7);
 }
 
+TEST(KernelLogTest, logDefer)
+{
+	RTLIL::Design design;
+	RTLIL::Module *module = design.addModule("\\top");
+	RTLIL::Wire *wire = module->addWire("\\a", 4);
+	RTLIL::Cell *cell = module->addCell("$c", "$and");
+
+	std::string name = "x";
+	LogDeferred msg = log_defer("%s %s %s.%s %d %s", RTLIL::SigSpec(wire), RTLIL::SigBit(wire, 2),
+			module, cell->name, 42, name);
+	name = "y";
+
+	// arguments are copies, formatting only happens in str()
+	EXPECT_EQ(msg.str(), "\\a \\a [2] top.$c 42 x");
+	LogDeferred copy = msg;
+	EXPECT_EQ(copy.str(), msg.str());
+}
+
 YOSYS_NAMESPACE_END
@@ -2,6 +2,7 @@
 
 #include "kernel/yosys.h"
 #include "kernel/rtlil.h"
+#include "fixtures.h"
 
 YOSYS_NAMESPACE_BEGIN
 
@@ -11,4 +12,104 @@ TEST(KernelRtlilTest, getReferenceValid)
 	EXPECT_EQ(33, 33);
 }
 
+typedef ModuleFixture KernelRtlilModuleTest;
+
+TEST_F(KernelRtlilModuleTest, compactModule)
+{
+	std::vector<RTLIL::Wire*> wires;
+	for (int i = 0; i < 100; i++)
+		wires.push_back(module->addWire(stringf("\\w%d", i), 4));
+	for (int i = 0; i < 99; i++)
+		module->addAnd(stringf("\\c%d", i), wires[i], wires[i+1], wires[(i+2) % 100]);
+	module->connect(wires[0], RTLIL::SigSpec(wires[1]).extract(0, 2).repeat(2));
+
+	// freed objects are reused
+	RTLIL::Cell *cell = module->cell("\\c10");
+	module->remove(cell);
+	EXPECT_EQ(module->addCell("\\c10", ID($_NOT_)), cell);
+	module->remove(cell);
+
+	std::vector<unsigned int> wire_hashes, cell_hashes;
+	for (auto wire : module->wires())
+		wire_hashes.push_back(wire->hash());
+	for (auto cell : module->cells())
+		cell_hashes.push_back(cell->hash());
+
+	module->compact();
+
+	int k = 0;
+	for (auto wire : module->wires()) {
+		EXPECT_EQ(wire->module, module);
+		EXPECT_EQ(wire->hash(), wire_hashes[k++]);
+	}
+	k = 0;
+	for (auto cell : module->cells())
+		EXPECT_EQ(cell->hash(), cell_hashes[k++]);
+
+	RTLIL::Cell *c5 = module->cell("\\c5");
+	EXPECT_EQ(c5->getPort(ID::A), RTLIL::SigSpec(module->wire("\\w5")));
+	EXPECT_EQ(c5->getPort(ID::Y), RTLIL::SigSpec(module->wire("\\w7")));
+	EXPECT_EQ(module->connections().front().first, RTLIL::SigSpec(module->wire("\\w0")));
+	EXPECT_EQ(module->cell("\\c10"), nullptr);
+	module->check();
+}
+
+TEST_F(KernelRtlilModuleTest, compactWithMonitor)
+{
+	RTLIL::Wire *a = module->addWire("\\a"), *y = module->addWire("\\y");
+	RTLIL::Cell *cell = module->addNotGate("\\n", a, y);
+
+	// with a monitor attached, the objects must stay where they are
+	RTLIL::Monitor monitor;
+	module->monitors.insert(&monitor);
+	module->compact();
+	EXPECT_EQ(module->wire("\\a"), a);
+	EXPECT_EQ(module->cell("\\n"), cell);
+	module->monitors.erase(&monitor);
+
+	design.monitors.insert(&monitor);
+	module->compact();
+	EXPECT_EQ(module->wire("\\y"), y);
+	EXPECT_EQ(module->cell("\\n"), cell);
+	design.monitors.erase(&monitor);
+}
+
+TEST(KernelRtlilTest, removeCells)
+{
+	struct CountMonitor : RTLIL::Monitor
+	{
+		int connects = 0, batches = 0;
+
+		void notify_connect(RTLIL::Cell*, const RTLIL::IdString&, const RTLIL::SigSpec&, RTLIL::SigSpec&) YS_OVERRIDE {
+			connects++;
+		}
+		void notify_cells_del(RTLIL::Module *module, const pool<RTLIL::Cell*> &cells) YS_OVERRIDE {
+			batches++;
+			RTLIL::Monitor::notify_cells_del(module, cells);
+		}
+	};
+
+	RTLIL::Design design;
+	RTLIL::Module *module = design.addModule("\\top");
+	RTLIL::Wire *a = module->addWire("\\a"), *b = module->addWire("\\b");
+
+	pool<RTLIL::Cell*> cells;
+	for (int i = 0; i < 10; i++) {
+		RTLIL::Cell *cell = module->addNotGate(stringf("\\n%d", i), a, b);
+		if (i % 2)
+			cells.insert(cell);
+	}
+
+	CountMonitor monitor;
+	module->monitors.insert(&monitor);
+	module->remove(cells);
+	module->monitors.erase(&monitor);
+
+	EXPECT_EQ(monitor.batches, 1);
+	EXPECT_EQ(monitor.connects, 10);
+	EXPECT_EQ(GetSize(module->cells_), 5);
+	EXPECT_NE(module->cell("\\n0"), nullptr);
+	EXPECT_EQ(module->cell("\\n1"), nullptr);
+}
+
 YOSYS_NAMESPACE_END
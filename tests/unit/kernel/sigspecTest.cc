@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+#include "kernel/yosys.h"
+#include "kernel/rtlil.h"
+#include "fixtures.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+namespace {
+
+struct SigSpecFixture : public ModuleFixture
+{
+	RTLIL::Wire *a, *b;
+
+	void SetUp() override
+	{
+		ModuleFixture::SetUp();
+		a = module->addWire("\\a", 64);
+		b = module->addWire("\\b", 64);
+	}
+
+	// runs fn n times and prints the time per iteration
+	template<typename T>
+	void bench(const char *name, int n, T fn)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < n; i++)
+			fn(i);
+		auto stop = std::chrono::steady_clock::now();
+		double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+		printf("[ BENCH    ] %-24s %10.1f ns/iter\n", name, ns / n);
+	}
+};
+
+}
+
+TEST_F(SigSpecFixture, mixedRepresentations)
+{
+	RTLIL::SigSpec sig = RTLIL::SigSpec(a, 0, 8);
+	sig.append(RTLIL::State::S1);
+	sig.append(RTLIL::SigSpec(a, 9, 8));
+
+	// bits() must not drop the chunk form, so both must stay consistent
+	EXPECT_EQ(GetSize(sig.bits()), 17);
+	EXPECT_EQ(GetSize(sig.chunks()), 3);
+	EXPECT_EQ(sig[8], RTLIL::SigBit(RTLIL::State::S1));
+
+	sig[8] = RTLIL::SigBit(a, 30);
+	EXPECT_EQ(GetSize(sig.chunks()), 3);
+	EXPECT_EQ(sig[8], RTLIL::SigBit(a, 30));
+	EXPECT_EQ(sig[9], RTLIL::SigBit(a, 9));
+
+	sig[8] = RTLIL::SigBit(a, 8);
+	EXPECT_EQ(sig, RTLIL::SigSpec(a, 0, 17));
+	EXPECT_EQ(GetSize(sig.chunks()), 1);
+}
+
+TEST_F(SigSpecFixture, hashIndependentOfForm)
+{
+	std::vector<RTLIL::SigBit> bits;
+	for (int i = 0; i < 32; i++)
+		bits.push_back(RTLIL::SigBit(i % 3 ? a : b, i));
+	bits.push_back(RTLIL::State::S0);
+	bits.push_back(RTLIL::State::Sx);
+
+	RTLIL::SigSpec unpacked(bits);
+	RTLIL::SigSpec packed(bits);
+	packed.chunks();
+	RTLIL::SigSpec copy;
+	copy = unpacked;
+
+	EXPECT_EQ(unpacked.hash(), packed.hash());
+	EXPECT_EQ(unpacked.hash(), copy.hash());
+	EXPECT_TRUE(unpacked == packed);
+	EXPECT_FALSE(unpacked < packed);
+	EXPECT_FALSE(packed < unpacked);
+}
+
+TEST_F(SigSpecFixture, extractAndReplace)
+{
+	RTLIL::SigSpec sig = {RTLIL::SigSpec(b, 4, 4), RTLIL::Const(5, 4), RTLIL::SigSpec(a, 0, 8)};
+
+	EXPECT_EQ(sig.extract(0, 8), RTLIL::SigSpec(a, 0, 8));
+	EXPECT_EQ(sig.extract(2, 8), RTLIL::SigSpec({RTLIL::Const(1, 2), RTLIL::SigSpec(a, 2, 6)}));
+	EXPECT_EQ(sig.extract(10, 6), RTLIL::SigSpec({RTLIL::SigSpec(b, 4, 4), RTLIL::Const(1, 2)}));
+
+	sig.replace(RTLIL::SigSpec(a, 2, 2), RTLIL::SigSpec(b, 0, 2));
+	EXPECT_EQ(sig.extract(0, 4), RTLIL::SigSpec({RTLIL::SigSpec(b, 0, 2), RTLIL::SigSpec(a, 0, 2)}));
+
+	sig.remove(0, 8);
+	EXPECT_EQ(sig, RTLIL::SigSpec({RTLIL::SigSpec(b, 4, 4), RTLIL::Const(5, 4)}));
+	sig.append(sig);
+	EXPECT_EQ(GetSize(sig), 16);
+	EXPECT_EQ(sig.extract(8, 8), sig.extract(0, 8));
+}
+
+// Timings vary from run to run, so this is not part of the normal unit test
+// run. Run it with --gtest_also_run_disabled_tests --gtest_filter='*benchmark'.
+TEST_F(SigSpecFixture, DISABLED_benchmark)
+{
+	const int n = 20000;
+	RTLIL::SigSpec wide(a);
+	wide.append(b);
+
+	bench("append chunks", n, [&](int) {
+		RTLIL::SigSpec sig;
+		for (int i = 0; i < 8; i++)
+			sig.append(RTLIL::SigSpec(i % 2 ? a : b, 8*i, 8));
+		EXPECT_EQ(GetSize(sig), 64);
+	});
+
+	bench("append_bit", n, [&](int) {
+		RTLIL::SigSpec sig;
+		for (int i = 0; i < 64; i++)
+			sig.append(RTLIL::SigBit(a, i));
+		EXPECT_EQ(GetSize(sig.chunks()), 1);
+	});
+
+	bench("extract packed", n, [&](int i) {
+		RTLIL::SigSpec sig = wide.extract(i % 64, 32);
+		EXPECT_EQ(GetSize(sig), 32);
+	});
+
+	bench("extract unpacked", n, [&](int i) {
+		wide.bits();
+		RTLIL::SigSpec sig = wide.extract(i % 64, 32);
+		EXPECT_EQ(GetSize(sig), 32);
+	});
+
+	bench("replace", n, [&](int i) {
+		RTLIL::SigSpec sig = wide;
+		sig.replace(i % 96, RTLIL::SigSpec(RTLIL::State::S0, 32));
+		EXPECT_EQ(GetSize(sig), 128);
+	});
+
+	bench("hash", n, [&](int i) {
+		RTLIL::SigSpec sig = wide.extract(i % 64, 64);
+		sig.bits();
+		EXPECT_NE(sig.hash(), 0u);
+	});
+
+	bench("iterate bits", n, [&](int) {
+		int count = 0;
+		for (auto bit : wide)
+			count += bit.wire == a;
+		EXPECT_EQ(count, 64);
+	});
+
+	bench("chunks/bits alternate", n, [&](int i) {
+		RTLIL::SigSpec sig = wide.extract(i % 64, 64);
+		for (int k = 0; k < 4; k++) {
+			EXPECT_EQ(GetSize(sig.chunks()), 2 - (i % 64 == 0));
+			EXPECT_EQ(GetSize(sig.bits()), 64);
+		}
+	});
+}
+
+YOSYS_NAMESPACE_END
@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+
+#include "kernel/yosys.h"
+#include "kernel/utils.h"
+
+YOSYS_NAMESPACE_BEGIN
+
+namespace {
+
+// the recursive search TopoSort used to do, as a reference for its order
+struct RecursiveTopoSort
+{
+	std::map<int, std::set<int>> database;
+	std::set<std::set<int>> loops;
+	std::vector<int> sorted;
+
+	void edge(int left, int right)
+	{
+		database[left];
+		database[right].insert(left);
+	}
+
+	void worker(int n, std::set<int> &marked, std::vector<int> &active)
+	{
+		auto it = std::find(active.begin(), active.end(), n);
+		if (it != active.end()) {
+			loops.insert(std::set<int>(it, active.end()));
+			return;
+		}
+		if (marked.count(n))
+			return;
+		if (!database.at(n).empty()) {
+			active.push_back(n);
+			for (int left : database.at(n))
+				worker(left, marked, active);
+			active.pop_back();
+		}
+		marked.insert(n);
+		sorted.push_back(n);
+	}
+
+	void sort()
+	{
+		std::set<int> marked;
+		std::vector<int> active;
+		for (auto &it : database)
+			worker(it.first, marked, active);
+	}
+};
+
+}
+
+TEST(KernelUtilsTest, topoSortOrder)
+{
+	for (int seed = 1; seed <= 20; seed++)
+	{
+		TopoSort<int> topo;
+		RecursiveTopoSort ref;
+
+		uint32_t x = seed;
+		for (int i = 0; i < 200; i++) {
+			x ^= x << 13, x ^= x >> 17, x ^= x << 5;
+			int left = x % 100, right = (x >> 8) % 100;
+			// mostly forward edges, with a few loops for odd seeds
+			if (left > right && (seed % 2 == 0 || i % 50 != 0))
+				std::swap(left, right);
+			topo.edge(left, right);
+			ref.edge(left, right);
+		}
+
+		ref.sort();
+		EXPECT_EQ(topo.sort(), ref.loops.empty());
+		EXPECT_EQ(topo.sorted, ref.sorted);
+		EXPECT_EQ(topo.loops, ref.loops);
+	}
+}
+
+TEST(KernelUtilsTest, intTopoSort)
+{
+	IntTopoSort topo;
+	for (int i = 0; i < 6; i++)
+		topo.node();
+
+	topo.edge(0, 2);
+	topo.edge(1, 2);
+	topo.edge(2, 3);
+	topo.edge(0, 3);
+	EXPECT_TRUE(topo.sort());
+	EXPECT_EQ(topo.sorted, std::vector<int>({0, 1, 4, 5, 2, 3}));
+	EXPECT_EQ(topo.level, std::vector<int>({0, 0, 1, 2, 0, 0}));
+	EXPECT_EQ(topo.num_levels, 3);
+
+	// 3 -> 4 -> 5 -> 4 is a loop
+	topo.edge(3, 4);
+	topo.edge(4, 5);
+	topo.edge(5, 4);
+	EXPECT_FALSE(topo.sort());
+	EXPECT_EQ(topo.num_sorted, 4);
+	EXPECT_EQ(GetSize(topo.sorted), 6);
+	ASSERT_EQ(GetSize(topo.loops), 1);
+	EXPECT_EQ(std::set<int>(topo.loops[0].begin(), topo.loops[0].end()), std::set<int>({4, 5}));
+
+	// 5 -> 3 -> 4 is a second loop through 4 and 5
+	topo.edge(5, 3);
+	EXPECT_FALSE(topo.sort());
+	EXPECT_EQ(topo.num_sorted, 3);
+	EXPECT_EQ(GetSize(topo.sorted), 6);
+	std::set<std::set<int>> loops;
+	for (auto &loop : topo.loops)
+		loops.insert(std::set<int>(loop.begin(), loop.end()));
+	EXPECT_EQ(loops, std::set<std::set<int>>({{4, 5}, {3, 4, 5}}));
+}
+
+YOSYS_NAMESPACE_END
@@ -0,0 +1,39 @@
+#!/usr/bin/env bash
+# check: two logic loops that share a cell and a wire are reported as two
+# separate loops.
+
+set -e
+
+../../yosys -q -l check_loops.log -p 'check' - > /dev/null 2>&1 << "EOT"
+read_ilang << EOF
+module \top
+  wire input 1 \a
+  wire output 2 \y
+  wire \x
+  wire \w
+  cell $_AND_ $c1
+    connect \A \x
+    connect \B \w
+    connect \Y \y
+  end
+  cell $_NOT_ $c2
+    connect \A \y
+    connect \Y \x
+  end
+  cell $_XOR_ $c3
+    connect \A \y
+    connect \B \a
+    connect \Y \w
+  end
+end
+EOF
+EOT
+
+if [ "$(grep -c 'found logic loop in module top' check_loops.log)" != 2 ]; then
+	echo "expected two logic loops"
+	exit 1
+fi
+grep -A4 'found logic loop' check_loops.log | grep -q 'cell $c2 ($_NOT_)'
+grep -A4 'found logic loop' check_loops.log | grep -q 'cell $c3 ($_XOR_)'
+
+rm check_loops.log
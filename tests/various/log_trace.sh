@@ -0,0 +1,32 @@
+#!/usr/bin/env bash
+# yosys -J: every span is closed, also for passes that fail with an error
+# in the interactive shell.
+
+set -e
+
+cat > log_trace.il << "EOT"
+module \top
+  wire input 1 \a
+  wire output 2 \y
+  cell $_NOT_ $not
+    connect \A \a
+    connect \Y \y
+  end
+end
+EOT
+
+../../yosys -q -J log_trace.json > /dev/null 2>&1 << "EOT" || true
+read_ilang log_trace.il
+tee -o /dev/null hierarchy -top nonexistent
+stat
+EOT
+
+begins=$(grep -c '"ph":"B"' log_trace.json)
+ends=$(grep -c '"ph":"E"' log_trace.json)
+if [ "$begins" != "$ends" ]; then
+	echo "unbalanced trace: $begins begin and $ends end events"
+	exit 1
+fi
+grep -q '"name":"stat"' log_trace.json
+
+rm log_trace.il log_trace.json
@@ -0,0 +1,123 @@
+#!/usr/bin/env bash
+# ltp: path lengths with the default cell delay, with -delay and with the
+# delays from a liberty file, several paths with -paths, and -paths 0.
+
+set -e
+
+cat > ltp.il << "EOT"
+module \top
+  wire input 1 \a
+  wire input 2 \b
+  wire input 3 \c
+  wire output 4 \y
+  wire output 5 \z
+  wire \x1
+  wire \x2
+  cell $_NOT_ $n1
+    connect \A \a
+    connect \Y \x1
+  end
+  cell $_NOT_ $n2
+    connect \A \x1
+    connect \Y \x2
+  end
+  cell $_AND_ $and
+    connect \A \x2
+    connect \B \b
+    connect \Y \y
+  end
+  cell $_XOR_ $xor
+    connect \A \b
+    connect \B \c
+    connect \Y \z
+  end
+end
+EOT
+
+cat > ltp.lib << "EOT"
+library(ltp) {
+  cell(INV) {
+    pin(A) { direction : input; }
+    pin(Y) {
+      direction : output;
+      function : "A'";
+      timing() {
+        related_pin : "A";
+        intrinsic_rise : 1.5;
+        intrinsic_fall : 2;
+      }
+    }
+  }
+  cell(BUF) {
+    pin(A) { direction : input; }
+    pin(Y) {
+      direction : output;
+      function : "A";
+      timing() {
+        related_pin : "A";
+        intrinsic_rise : 10;
+      }
+    }
+  }
+}
+EOT
+
+cat > ltp_lib.il << "EOT"
+module \top
+  wire input 1 \a
+  wire input 2 \b
+  wire output 3 \y
+  wire output 4 \z
+  wire \w
+  cell \INV \u1
+    connect \A \a
+    connect \Y \w
+  end
+  cell \BUF \u2
+    connect \A \w
+    connect \Y \y
+  end
+  cell \INV \u3
+    connect \A \b
+    connect \Y \z
+  end
+end
+EOT
+
+../../yosys -q -l ltp_sh.log -p '
+read_ilang ltp.il
+tee -o ltp_default.log ltp
+tee -o ltp_paths.log ltp -paths 2
+tee -o ltp_delay.log ltp -delay $_XOR_ 5
+design -reset
+read_liberty -lib ltp.lib
+read_ilang ltp_lib.il
+tee -o ltp_liberty.log ltp -liberty ltp.lib
+'
+
+grep -q "Longest topological path in top (length=3):" ltp_default.log
+if grep -q "path #2" ltp_default.log; then
+	echo "ltp without -paths printed more than one path"
+	exit 1
+fi
+
+grep -q "Longest topological path in top (length=3):" ltp_paths.log
+grep -q "Longest topological path #2 in top (length=1):" ltp_paths.log
+if grep -q "path #3" ltp_paths.log; then
+	echo "ltp -paths 2 printed more than two paths"
+	exit 1
+fi
+
+grep -q "Longest topological path in top (length=5):" ltp_delay.log
+grep -q "(via \$xor)" ltp_delay.log
+
+grep -q "Longest topological path in top (length=12):" ltp_liberty.log
+grep -q "(via u2)" ltp_liberty.log
+
+if ../../yosys -q -p 'read_ilang ltp.il; ltp -paths 0' > ltp_error.log 2>&1; then
+	echo "ltp -paths 0 did not fail"
+	exit 1
+fi
+grep -q "Invalid number of paths: 0" ltp_error.log
+
+rm ltp.il ltp_lib.il ltp.lib ltp_sh.log ltp_default.log ltp_paths.log ltp_delay.log ltp_liberty.log ltp_error.log
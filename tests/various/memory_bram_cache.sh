@@ -0,0 +1,109 @@
+#!/usr/bin/env bash
+# memory_bram: two memories with the same shape and one with a different
+# shape, mapped in one call (the second memory reuses the decision for the
+# first) and each in a call of its own, must give the same netlist.
+
+set -e
+
+mem() {
+	cat << EOT
+module \\$1
+  wire input 1 \\clk
+  wire input 2 \\we
+  wire width $3 input 3 \\wa
+  wire width $2 input 4 \\wd
+  wire width $3 input 5 \\ra
+  wire width $2 output 6 \\rd
+  cell \$mem \\mem
+    parameter \\MEMID "\\\\mem"
+    parameter \\SIZE $((1 << $3))
+    parameter \\OFFSET 0
+    parameter \\ABITS $3
+    parameter \\WIDTH $2
+    parameter \\INIT $(($2 << $3))'x
+    parameter \\RD_PORTS 1
+    parameter \\RD_CLK_ENABLE 1'1
+    parameter \\RD_CLK_POLARITY 1'1
+    parameter \\RD_TRANSPARENT 1'0
+    parameter \\WR_PORTS 1
+    parameter \\WR_CLK_ENABLE 1'1
+    parameter \\WR_CLK_POLARITY 1'1
+    connect \\RD_CLK \\clk
+    connect \\RD_EN 1'1
+    connect \\RD_ADDR \\ra
+    connect \\RD_DATA \\rd
+    connect \\WR_CLK \\clk
+    connect \\WR_EN { $(for i in $(seq $2); do echo -n "\\we "; done)}
+    connect \\WR_ADDR \\wa
+    connect \\WR_DATA \\wd
+  end
+end
+EOT
+}
+
+{ mem a 16 8; mem b 16 8; mem c 8 9; } > memory_bram_cache.il
+
+cat > memory_bram_cache.txt << "EOT"
+bram RAM256X8
+  init 0
+  abits 8
+  dbits 8
+  groups 2
+  ports  1 1
+  wrmode 0 1
+  enable 0 1
+  transp 0 0
+  clocks 1 1
+  clkpol 1 1
+endbram
+
+bram RAM512X4
+  init 0
+  abits 9
+  dbits 4
+  groups 2
+  ports  1 1
+  wrmode 0 1
+  enable 0 1
+  transp 0 0
+  clocks 1 1
+  clkpol 1 1
+endbram
+
+match RAM256X8
+  or_next_if_better
+endmatch
+
+match RAM512X4
+endmatch
+EOT
+
+../../yosys -q -p '
+read_ilang memory_bram_cache.il
+tee -o memory_bram_cache.log memory_bram -rules memory_bram_cache.txt
+select -assert-none t:$mem
+write_ilang memory_bram_cache_1.il
+design -reset
+read_ilang memory_bram_cache.il
+memory_bram -rules memory_bram_cache.txt a
+memory_bram -rules memory_bram_cache.txt b
+memory_bram -rules memory_bram_cache.txt c
+write_ilang memory_bram_cache_3.il
+'
+
+if [ $(grep -c "selected for a memory of the same shape" memory_bram_cache.log) != 1 ]; then
+	echo "expected one cached mapping decision"
+	exit 1
+fi
+
+# new wires and cells are numbered differently in the two calls
+for f in memory_bram_cache_1.il memory_bram_cache_3.il; do
+	sed -e '/^# Generated by /d' -e '/^autoidx /d' -e 's/\$[0-9]\+//g' $f > $f.out
+done
+if ! cmp -s memory_bram_cache_1.il.out memory_bram_cache_3.il.out; then
+	echo "mapping with cached decisions differs from mapping without:"
+	diff memory_bram_cache_1.il.out memory_bram_cache_3.il.out | head -20
+	exit 1
+fi
+
+rm memory_bram_cache.il memory_bram_cache.txt memory_bram_cache.log memory_bram_cache_1.il memory_bram_cache_3.il memory_bram_cache_1.il.out memory_bram_cache_3.il.out
@@ -0,0 +1,96 @@
+#!/usr/bin/env bash
+# opt -incremental: after the first iteration only the cells around the
+# changes are re-examined, and the result is equivalent to a full opt run.
+
+set -e
+
+cat > opt_incremental.il << "EOT"
+module \top
+  wire width 3 input 1 \s
+  wire width 2 input 2 \t
+  wire width 8 input 3 \b
+  wire width 4 output 4 \y
+  wire width 4 input 5 \p
+  wire width 4 input 6 \q
+  wire width 4 output 7 \z
+  wire width 4 \pq
+  cell $and $and_pq
+    parameter \A_SIGNED 0
+    parameter \B_SIGNED 0
+    parameter \A_WIDTH 4
+    parameter \B_WIDTH 4
+    parameter \Y_WIDTH 4
+    connect \A \p
+    connect \B \q
+    connect \Y \pq
+  end
+  cell $xor $xor_z
+    parameter \A_SIGNED 0
+    parameter \B_SIGNED 0
+    parameter \A_WIDTH 4
+    parameter \B_WIDTH 4
+    parameter \Y_WIDTH 4
+    connect \A \pq
+    connect \B \p
+    connect \Y \z
+  end
+  process \p
+    assign \y 4'0000
+    switch \s
+      case 3'-11
+      case
+        switch \t
+          case 2'10 , 2'-1
+            switch \t
+              case 2'11
+              case 2'-1
+              case 2'10 , 2'00
+                assign \y 4'1000
+            end
+        end
+        switch \b [0]
+          case 1'1
+          case
+            switch \b [0]
+              case 1'1
+              case
+                assign \y { \t \s [1:0] }
+            end
+        end
+    end
+  end
+end
+EOT
+
+../../yosys -q -l opt_incremental_sh.log -p '
+read_ilang opt_incremental.il
+proc
+opt
+rename top gold
+design -stash gold
+
+read_ilang opt_incremental.il
+proc
+opt -incremental
+rename top gate
+design -stash gate
+
+design -copy-from gold -as gold gold
+design -copy-from gate -as gate gate
+miter -equiv -flatten -make_assert gold gate miter
+sat -verify -prove-asserts miter
+'
+
+# "Re-examining <frontier> of <total> selected cells in this iteration."
+awk '/^Re-examining/ {
+	n++
+	if ($2 >= $4) { print "frontier is not smaller than the module: " $0; exit 1 }
+	if (n == 1) first = $2
+	last = $2
+}
+END {
+	if (n < 2) { print "expected at least two incremental iterations"; exit 1 }
+	if (last >= first) { print "frontier did not shrink"; exit 1 }
+}' opt_incremental_sh.log
+
+rm opt_incremental.il
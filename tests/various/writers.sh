@@ -0,0 +1,28 @@
+#!/usr/bin/env bash
+# write_blif and write_json in several modes, compared with the output of
+# the writers before they assembled their output in a TextBuffer. The
+# version line ("# Generated by" and "creator") is not compared.
+
+set -e
+
+cd writers
+
+../../../yosys -q -p '
+read_ilang writers.il
+hierarchy -top top
+write_blif writers.blif
+write_blif -iname -cname -param -attr -iattr -conn -impltf -buf BUF A Y -true VCC Y -false GND Y -undef UNDEF Y writers_opts.blif
+write_blif -gates -noalias -blackbox writers_gates.blif
+write_json writers.json
+write_json -aig writers_aig.json
+'
+
+for f in writers.blif writers_opts.blif writers_gates.blif writers.json writers_aig.json; do
+	sed -e '/^# Generated by /d' -e '/^  "creator": /d' $f > $f.out
+	if ! cmp -s $f.ok $f.out; then
+		echo "$f differs from $f.ok:"
+		diff $f.ok $f.out | head -20
+		exit 1
+	fi
+	rm $f $f.out
+done